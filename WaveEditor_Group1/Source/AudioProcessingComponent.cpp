@@ -13,45 +13,95 @@
 #include <utility>
 #include "AudioProcessingComponent.h"
 #include "Utils.h"
+#include "ParallelUtils.h"
+
+constexpr float AudioProcessingComponent::minPlaybackRate;
+constexpr float AudioProcessingComponent::maxPlaybackRate;
+constexpr double AudioProcessingComponent::maxRateChangePerSecond;
+constexpr double AudioProcessingComponent::scrubResponseTime;
 
 //==============================================================================
-AudioProcessingComponent::AudioProcessingComponent():
+AudioProcessingComponent::AudioProcessingComponent(bool useAudioDevice):
 state(Stopped),
 fileLoaded(false),
-interpolators(nullptr),
+requestedResamplerQuality(PlaybackResampler::CatmullRom),
+resamplerResetRequested(false),
+loopCrossfadeMs(0.f),
+playbackRate(1.f),
+currentPlaybackRate(0.f),
+scrubActive(false),
+scrubTargetPos(0),
+scrubStartPos(-1),
+timeStretchPreviewEnabled(false),
+timeStretchFactor(1.f),
+timeStretchSemitones(0.f),
+timeStretchPreviewActive(false),
+numStretchSamples(0),
+timeStretchHopRemainder(0.0),
+timeStretchInputFinished(false),
+timeStretchFrameRead(false),
+maxBlockSize(0),
 sampleRate(0.f),
 deviceSampleRate(0.f),
 currentPos(0),
 markerStartPos(0),
 markerEndPos(0),
 loopEnabled(false),
-mouseNormal(false)
+mouseNormal(false),
+snapToZeroCrossings(true),
+snapToOnsets(false),
+useAudioDevice(useAudioDevice)
 {
     formatManager.registerBasicFormats();
     audioCopyBuffer.clear();
 }
 
 AudioProcessingComponent::~AudioProcessingComponent()  {
+    editQueue.cancelAll();
+    editQueue.waitUntilIdle(-1);
     shutdownAudio();
-    if (fileLoaded)
-    {
-        for (int channel=0; channel<getNumChannels(); channel++)
-        {
-            delete interpolators[channel];
-        }
-        delete[] interpolators;
-        interpolators = nullptr;
-    }
+    // the index and export threads read the audio buffer, which is destroyed before them
+    zeroCrossingIndex.stopBuilding();
+    onsetIndex.stopBuilding();
+    sliceExporter.cancel();
 }
 
-void AudioProcessingComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate) 
+void AudioProcessingComponent::prepareToPlay (int samplesPerBlockExpected, double newDeviceSampleRate) 
 {
-    audioBlockBuffer.setSize(getNumChannels(), samplesPerBlockExpected);
+    // JUCE calls this again whenever the device settings change, while the
+    // callback is stopped, so the document stays loaded and only the scratch
+    // buffers and rate dependent state are rebuilt here
+    deviceSampleRate = newDeviceSampleRate;
+    maxBlockSize = samplesPerBlockExpected;
+    if (auto* device = deviceManager.getCurrentAudioDevice())
+        maxBlockSize = jmax(maxBlockSize, device->getCurrentBufferSizeSamples());
+
+    audioBlockBuffer.setSize(getNumChannels(), maxBlockSize);
     audioBlockBuffer.clear();
-    deviceSampleRate = deviceManager.getAudioDeviceSetup().sampleRate;
-    if (fileLoaded)
-        for (int channel=0; channel<getNumChannels(); channel++)
-            interpolators[channel]->reset();
+    resampledBuffer.setSize(getNumChannels(), maxBlockSize);
+    auto maxInputPerBlock = maxBlockSize * jmax(1.0, deviceSampleRate > 0 ? sampleRate / deviceSampleRate : 1.0);
+    playbackReader.prepare(getNumChannels(), jmax(static_cast<int>(std::ceil(maxInputPerBlock)) + 64,
+                                                  static_cast<int>(PhaseVocoder::fftSize)));
+    stretchVocoder.prepare(getNumChannels());
+    stretchBuffer.setSize(getNumChannels(), 4 * PhaseVocoder::fftSize);
+    timeStretchFrame.setSize(getNumChannels(), PhaseVocoder::fftSize);
+    resetTimeStretchPreview();
+    effectChain.prepare(deviceSampleRate, getNumChannels(), maxBlockSize);
+    loudnessMeter.prepare(deviceSampleRate);
+    levelMeter.prepare(deviceSampleRate);
+    callbackProfiler.prepare(deviceSampleRate);
+
+    // route the file channels to the outputs the device actually opened
+    auto numOutputChannels = 2;
+    if (auto* device = deviceManager.getCurrentAudioDevice())
+        numOutputChannels = device->getActiveOutputChannels().countNumberOfSetBits();
+    if (getNumChannels() != channelRouter.getNumInputs() || numOutputChannels != channelRouter.getNumOutputs())
+        channelRouter.prepare(getNumChannels(), numOutputChannels);
+    if (fileLoaded && deviceSampleRate > 0)
+    {
+        resampler.setSpeedRatio(this->sampleRate / deviceSampleRate);
+        resampler.reset();
+    }
 }
 
 void AudioProcessingComponent::releaseResources() 
@@ -63,71 +113,239 @@ void AudioProcessingComponent::getNextAudioBlock (const AudioSourceChannelInfo&
     if (deviceSampleRate == 0)
         return;
 
+    ScopedNoDenormals noDenormals;
+    auto callbackStartTicks = callbackProfiler.callbackStarted(bufferToFill.numSamples);
+    int numLoopIterations = 0;
+
     double sampleRateRatio = deviceSampleRate / sampleRate;
+    resampler.setQuality(static_cast<PlaybackResampler::Quality>(requestedResamplerQuality.load()));
+    if (resamplerResetRequested.exchange(false))
+    {
+        // playback starts at full rate, a scrub from rest
+        resampler.reset();
+        resetTimeStretchPreview();
+        currentPlaybackRate = scrubActive.load() ? 0.f : playbackRate.load();
+    }
 
-    if (state == Playing)
+    // a scrub from rest publishes its start position before the flag
+    auto scrubbing = scrubActive.load(std::memory_order_acquire);
+    if (scrubbing)
     {
-        auto numInputChannels = audioBuffer.getNumChannels();
-        auto numOutputChannels = bufferToFill.buffer->getNumChannels();
+        auto scrubStart = scrubStartPos.exchange(-1);
+        if (scrubStart >= 0)
+        {
+            currentPos = scrubStart;
+            resampler.reset();
+            resetTimeStretchPreview();
+            currentPlaybackRate = 0.f;
+        }
+    }
 
+    if ((state == Playing || scrubbing) && resampledBuffer.getNumSamples() > 0)
+    {
         auto outputSamplesRemaining = bufferToFill.numSamples;
         auto outputSamplesOffset = bufferToFill.startSample;
+        auto looping = !scrubbing && isLoopEnabled() && markerEndPos > markerStartPos;
+        auto crossfadeLength = roundToInt(loopCrossfadeMs.load() * 0.001 * sampleRate);
+
+        // scrubbing moves the playhead towards the mouse, faster the further away it is
+        auto targetRate = playbackRate.load();
+        if (scrubbing)
+            targetRate = jlimit(-maxPlaybackRate, maxPlaybackRate,
+                                static_cast<float>((scrubTargetPos.load() - currentPos) / (scrubResponseTime * sampleRate)));
+        auto maxRateChange = static_cast<float>(rampStepSamples * maxRateChangePerSecond / deviceSampleRate);
+
+        // the time stretch preview replaces the varispeed path while it's on
+        auto stretchPreview = !scrubbing && timeStretchPreviewEnabled.load();
+        if (stretchPreview != timeStretchPreviewActive)
+        {
+            resetTimeStretchPreview();
+            timeStretchPreviewActive = stretchPreview;
+        }
+        if (stretchPreview)
+        {
+            numLoopIterations += renderTimeStretchPreview(bufferToFill, sampleRateRatio, looping, crossfadeLength);
+            outputSamplesRemaining = 0;
+        }
 
         while (outputSamplesRemaining > 0)
         {
-            auto bufferSamplesRemaining = markerEndPos - currentPos;
-            int outputSamplesThisTime = jmin(
-                    static_cast<int>(round(bufferSamplesRemaining*sampleRateRatio)),
-                    outputSamplesRemaining);
-            if (outputSamplesThisTime == 0)
-                outputSamplesThisTime = 1;
-            int inputSamplesThisTime = 0;
-
-            if (getNumChannels() == 1) // if it's single channel, copy channel 0 to channel 1
+            numLoopIterations++;
+
+            // the rate ramps to its target in short steps and stays constant within a step
+            auto ramping = currentPlaybackRate != targetRate;
+            currentPlaybackRate += jlimit(-maxRateChange, maxRateChange, targetRate - currentPlaybackRate);
+            auto reverse = currentPlaybackRate < 0.f;
+            auto speed = std::abs(currentPlaybackRate);
+            auto inputPerOutput = speed / sampleRateRatio;
+            resampler.selectSpeedRatio(inputPerOutput);
+
+            // the resampler may read two samples more than the ratio suggests
+            int outputSamplesThisTime = jmin(outputSamplesRemaining, resampledBuffer.getNumSamples(),
+                                             static_cast<int>((playbackReader.getCapacity() - 2) / jmax(inputPerOutput, 1.0e-3)));
+            if (ramping)
+                outputSamplesThisTime = jmin(outputSamplesThisTime, static_cast<int>(rampStepSamples));
+            if (!looping)
             {
-                inputSamplesThisTime = interpolators[0]->process(
-                        1/sampleRateRatio,
-                        audioBuffer.getReadPointer(0, currentPos),
-                        bufferToFill.buffer->getWritePointer(0, outputSamplesOffset),
-                        outputSamplesThisTime);
-                for (auto channel = 1; channel < numOutputChannels; channel++)
-                {
-                    bufferToFill.buffer->copyFrom(
-                            channel,
-                            outputSamplesOffset,
-                            bufferToFill.buffer->getReadPointer(0, outputSamplesOffset),
-                            outputSamplesThisTime);
-                }
+                auto inputRemaining = scrubbing ? (reverse ? currentPos : getNumSamples() - currentPos)
+                                                : (reverse ? currentPos - markerStartPos : markerEndPos - currentPos);
+                outputSamplesThisTime = jmin(outputSamplesThisTime,
+                                             static_cast<int>(round(inputRemaining / jmax(inputPerOutput, 1.0e-3))));
             }
-            else
-            {
-                for (auto channel = 0; channel < numOutputChannels; channel++)
-                {
-                    inputSamplesThisTime = interpolators[channel]->process(
-                            1/sampleRateRatio,
-                            audioBuffer.getReadPointer(channel, currentPos),
-                            bufferToFill.buffer->getWritePointer(channel, outputSamplesOffset),
-                            outputSamplesThisTime);
-                }
-            }
-            audioBlockBuffer.copyFrom(0, 0, audioBuffer, 0, currentPos, inputSamplesThisTime);
+            if (outputSamplesThisTime <= 0)
+                outputSamplesThisTime = 1;
+
+            // the loop wrap happens inside the staged input, so the resampler
+            // history runs straight through it
+            auto inputSamplesNeeded = static_cast<int>(std::ceil(outputSamplesThisTime * inputPerOutput)) + 2;
+            auto numStaged = playbackReader.read(audioBuffer, currentPos, markerStartPos, markerEndPos,
+                                                 looping, crossfadeLength, inputSamplesNeeded, reverse);
+
+            // all channels are resampled together, then mixed to the outputs
+            int inputSamplesThisTime = resampler.process(
+                    inputPerOutput,
+                    playbackReader.getBuffer(), 0, numStaged,
+                    resampledBuffer, 0, outputSamplesThisTime);
+
+            ChainContext chainContext {static_cast<double>(currentPos), reverse ? -inputPerOutput : inputPerOutput,
+                                       sampleRate, markerStartPos, markerEndPos};
+            effectChain.process(resampledBuffer, 0, outputSamplesThisTime, chainContext);
+
+            // fade out instead of holding a DC value when a scrub comes to rest
+            if (speed < minPlaybackRate)
+                resampledBuffer.applyGain(0, outputSamplesThisTime, speed / minPlaybackRate);
+
+            // loudness is measured on the file channels before routing, so the
+            // BS.1770 weights of the file's layout apply, as in measureLoudness
+            loudnessMeter.process(resampledBuffer, 0, outputSamplesThisTime);
+            channelRouter.process(resampledBuffer, 0, *bufferToFill.buffer, outputSamplesOffset, outputSamplesThisTime);
+            audioBlockBuffer.copyFrom(0, 0, playbackReader.getBuffer(), 0, 0,
+                                      jmin(inputSamplesThisTime, numStaged, audioBlockBuffer.getNumSamples()));
             blockReady.sendChangeMessage();
 
             outputSamplesRemaining -= outputSamplesThisTime;
             outputSamplesOffset += outputSamplesThisTime;
-            currentPos += inputSamplesThisTime;
+            currentPos = PlaybackReader::advance(currentPos, inputSamplesThisTime, markerStartPos, markerEndPos, looping, reverse);
 
-            if (currentPos >= markerEndPos)
+            auto reachedEnd = scrubbing ? (reverse ? currentPos <= 0 : currentPos >= getNumSamples())
+                                        : (reverse ? currentPos <= markerStartPos : currentPos >= markerEndPos);
+            if (!looping && reachedEnd)
             {
-                bufferToFill.clearActiveBufferRegion();
-                if (isLoopEnabled())
-                    currentPos = markerStartPos;
-                else
+                for (int channel=0; channel<bufferToFill.buffer->getNumChannels(); channel++)
+                    bufferToFill.buffer->clear(channel, outputSamplesOffset, outputSamplesRemaining);
+                currentPos = jlimit(0, getNumSamples(), currentPos);
+                currentPlaybackRate = 0.f;
+                if (!scrubbing)
                     stopRequested();
                 break;
             }
         }
+
+        levelMeter.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
     }
+    else
+    {
+        currentPlaybackRate = 0.f;
+    }
+
+    callbackProfiler.callbackFinished(callbackStartTicks, bufferToFill.numSamples, numLoopIterations);
+}
+
+int AudioProcessingComponent::renderTimeStretchPreview(const AudioSourceChannelInfo& bufferToFill, double sampleRateRatio,
+                                                       bool looping, int crossfadeLength)
+{
+    const int fftSize = PhaseVocoder::fftSize;
+    const int hop = PhaseVocoder::synthesisHop;
+    auto stretchFactor = static_cast<double>(timeStretchFactor.load());
+    auto pitchFactor = std::pow(2.0, timeStretchSemitones.load() / 12.0);
+    auto analysisHop = PhaseVocoder::getAnalysisHop(stretchFactor, pitchFactor);
+    auto inputPerOutput = pitchFactor / sampleRateRatio;
+    resampler.selectSpeedRatio(inputPerOutput);
+
+    auto outputSamplesRemaining = bufferToFill.numSamples;
+    auto outputSamplesOffset = bufferToFill.startSample;
+    int numIterations = 0;
+
+    while (outputSamplesRemaining > 0)
+    {
+        numIterations++;
+        int outputSamplesThisTime = jmin(outputSamplesRemaining, resampledBuffer.getNumSamples(),
+                                         static_cast<int>((stretchBuffer.getNumSamples() - hop - 2) / inputPerOutput));
+        auto inputSamplesNeeded = static_cast<int>(std::ceil(outputSamplesThisTime * inputPerOutput)) + 2;
+
+        // vocoder frames until the resampler has enough input, the playhead
+        // moves by the analysis hop and wraps like normal playback. The first
+        // frame is read where the playhead is, so no input is skipped.
+        while (numStretchSamples < inputSamplesNeeded && !timeStretchInputFinished)
+        {
+            auto frameHop = 0;
+            if (timeStretchFrameRead)
+            {
+                frameHop = static_cast<int>(timeStretchHopRemainder + analysisHop);
+                timeStretchHopRemainder += analysisHop - frameHop;
+                currentPos = PlaybackReader::advance(currentPos, frameHop, markerStartPos, markerEndPos, looping);
+                if (!looping && currentPos >= markerEndPos)
+                {
+                    timeStretchInputFinished = true;
+                    break;
+                }
+            }
+            timeStretchFrameRead = true;
+
+            auto numStaged = playbackReader.read(audioBuffer, currentPos, markerStartPos, markerEndPos,
+                                                 looping, crossfadeLength, fftSize);
+            for (int channel=0; channel<stretchVocoder.getNumChannels(); channel++)
+            {
+                TimeStretcher::copyWithZeroPadding(playbackReader.getBuffer().getReadPointer(channel), numStaged, 0,
+                                                   timeStretchFrame.getWritePointer(channel), fftSize);
+                stretchVocoder.processFrame(channel, timeStretchFrame.getReadPointer(channel), frameHop,
+                                            stretchBuffer.getWritePointer(channel, numStretchSamples));
+            }
+            numStretchSamples += hop;
+        }
+
+        int stretchSamplesUsed = jmin(numStretchSamples, resampler.process(
+                inputPerOutput,
+                stretchBuffer, 0, numStretchSamples,
+                resampledBuffer, 0, outputSamplesThisTime));
+
+        // the playhead runs ahead of the output by the stretch latency, close enough for the chain
+        ChainContext chainContext {static_cast<double>(currentPos), inputPerOutput / (stretchFactor * pitchFactor),
+                                   sampleRate, markerStartPos, markerEndPos};
+        effectChain.process(resampledBuffer, 0, outputSamplesThisTime, chainContext);
+
+        loudnessMeter.process(resampledBuffer, 0, outputSamplesThisTime);
+        channelRouter.process(resampledBuffer, 0, *bufferToFill.buffer, outputSamplesOffset, outputSamplesThisTime);
+        audioBlockBuffer.copyFrom(0, 0, stretchBuffer, 0, 0, jmin(stretchSamplesUsed, audioBlockBuffer.getNumSamples()));
+        blockReady.sendChangeMessage();
+
+        numStretchSamples -= stretchSamplesUsed;
+        for (int channel=0; channel<stretchBuffer.getNumChannels(); channel++)
+        {
+            auto stretchPointer = stretchBuffer.getWritePointer(channel);
+            std::memmove(stretchPointer, stretchPointer + stretchSamplesUsed, sizeof(float) * static_cast<size_t>(numStretchSamples));
+        }
+        outputSamplesRemaining -= outputSamplesThisTime;
+        outputSamplesOffset += outputSamplesThisTime;
+
+        if (timeStretchInputFinished && numStretchSamples == 0)
+        {
+            for (int channel=0; channel<bufferToFill.buffer->getNumChannels(); channel++)
+                bufferToFill.buffer->clear(channel, outputSamplesOffset, outputSamplesRemaining);
+            stopRequested();
+            break;
+        }
+    }
+    return numIterations;
+}
+
+void AudioProcessingComponent::resetTimeStretchPreview()
+{
+    stretchVocoder.reset();
+    numStretchSamples = 0;
+    timeStretchHopRemainder = 0.0;
+    timeStretchInputFinished = false;
+    timeStretchFrameRead = false;
 }
 
 //---------------------------------AUDIO BUFFER HANDLING--------------------------------------
@@ -174,171 +392,815 @@ void AudioProcessingComponent::muteMarkedRegion ()
     if (markerStartPos == 0 && markerEndPos == getNumSamples())
         return;
     else
-        inplaceOperateMarkedRegion(&AudioProcessingUtils::mute);
+        inplaceOperateMarkedRegion("Mute", &AudioProcessingUtils::mute);
 }
 
 void AudioProcessingComponent::fadeInMarkedRegion()
 {
-    inplaceOperateMarkedRegion(AudioProcessingUtils::fadeIn);
+    inplaceOperateMarkedRegion("Fade In", AudioProcessingUtils::fadeIn);
 }
 
 void AudioProcessingComponent::fadeOutMarkedRegion()
 {
-    inplaceOperateMarkedRegion(AudioProcessingUtils::fadeOut);
+    inplaceOperateMarkedRegion("Fade Out", AudioProcessingUtils::fadeOut);
 }
 
 void AudioProcessingComponent::normalizeMarkedRegion()
 {
-    inplaceOperateMarkedRegion(AudioProcessingUtils::normalize);
+    // the peak is found in the copy of the region, so it includes the edits
+    // queued before this one and the worker never touches the component
+    inplaceOperateMarkedRegion("Normalize", [](float* bufferWritePointer, int startSample, int numSamples) {
+        auto range = FloatVectorOperations::findMinAndMax(bufferWritePointer + startSample, numSamples);
+        AudioProcessingUtils::normalize(bufferWritePointer, startSample, numSamples, jmax(-range.getStart(), range.getEnd()));
+    });
 }
 
-void AudioProcessingComponent::gainMarkedRegion(float gainValue)
+void AudioProcessingComponent::loudnessNormalizeMarkedRegion(float targetLoudness)
 {
-    auto gainFunc = AudioProcessingUtils::getGainFunc(gainValue);
-    inplaceOperateMarkedRegion(gainFunc);
+    // measured on the worker too, with the edits queued before it applied
+    auto documentSampleRate = static_cast<double>(sampleRate);
+    inplaceOperateRegion("Loudness Normalize", [targetLoudness, documentSampleRate](AudioBuffer<float>& region) {
+        auto result = LoudnessMeter::measure(region, 0, region.getNumSamples(), documentSampleRate);
+        if (result.integratedLoudness <= LoudnessMeter::getSilenceLoudness())
+            return;
+        region.applyGain(Decibels::decibelsToGain(targetLoudness - result.integratedLoudness));
+    }, markerStartPos, markerEndPos-markerStartPos+1);
 }
 
-void AudioProcessingComponent::copyMarkedRegion()
+void AudioProcessingComponent::equalizeMarkedRegion(const std::vector<EqBand>& bands)
 {
-    audioCopyBuffer.clear();
-    // TODO: the channel number is hard-coded here, which equals to the audio channel number
-    audioCopyBuffer.setSize(getNumChannels(), markerEndPos-markerStartPos+1);
-    for (int channel=0; channel<getNumChannels(); channel++)
-        audioCopyBuffer.copyFrom(channel, 0, audioBuffer, channel, markerStartPos, markerEndPos-markerStartPos+1);
-    audioCopied.sendChangeMessage();
+    if (!fileLoaded)
+        return;
+    auto documentSampleRate = sampleRate;
+    inplaceOperateRegion("Equalize", [bands, documentSampleRate](AudioBuffer<float>& region) {
+        ParametricEqualizer::process(region, documentSampleRate, bands);
+    }, markerStartPos, markerEndPos-markerStartPos+1);
 }
 
-void AudioProcessingComponent::cutMarkedRegion()
+void AudioProcessingComponent::applyDynamicsToMarkedRegion(const DynamicsSettings& settings)
 {
-    copyMarkedRegion();
-    muteMarkedRegion();
+    if (!fileLoaded)
+        return;
+    auto documentSampleRate = sampleRate;
+    inplaceOperateRegion("Dynamics", [settings, documentSampleRate](AudioBuffer<float>& region) {
+        DynamicsProcessor::process(region, documentSampleRate, settings);
+    }, markerStartPos, markerEndPos-markerStartPos+1);
 }
 
-void AudioProcessingComponent::deleteMarkedRegion()
+void AudioProcessingComponent::limitMarkedRegion(float ceilingDb)
 {
-    AudioBuffer<float> bufferBeforeOperation;
-    bufferBeforeOperation.setSize(getNumChannels(), markerEndPos-markerStartPos+1);
-    AudioBuffer<float> bufferAfterOperation;
-    bufferAfterOperation.setSize(getNumChannels(), 0);
+    applyDynamicsToMarkedRegion(LimiterEffect::makeSettings(ceilingDb, 100.f, 5.f));
+}
 
-    // fill the bufferBeforeOperation
-    for (int channel=0; channel<getNumChannels(); channel++)
-        bufferBeforeOperation.copyFrom(channel, 0, audioBuffer, 0, markerStartPos, markerEndPos-markerStartPos+1);
+void AudioProcessingComponent::captureNoiseProfile()
+{
+    if (!fileLoaded)
+        return;
+    auto numSamples = jmin(markerEndPos-markerStartPos+1, getNumSamples()-markerStartPos);
+    AudioBuffer<float> noiseRegion (audioBuffer.getArrayOfWritePointers(), getNumChannels(), markerStartPos, numSamples);
+    noiseProfile.capture(noiseRegion);
+}
 
-    AudioBufferUtils<float>::deleteRegion(audioBuffer, markerStartPos, markerEndPos-markerStartPos+1);
+bool AudioProcessingComponent::hasNoiseProfile()
+{
+    return !noiseProfile.isEmpty();
+}
 
-    UndoRecord record{bufferBeforeOperation, bufferAfterOperation, 0, markerStartPos};
-    undoStack.addRecord(record);
+void AudioProcessingComponent::reduceNoiseInMarkedRegion(float reductionDb, float sensitivity)
+{
+    if (!fileLoaded || noiseProfile.isEmpty())
+        return;
+    inplaceOperateRegion("Noise Reduction", [profile = noiseProfile, reductionDb, sensitivity](AudioBuffer<float>& region) {
+        // the frames read around the samples they write, so they need their own copy
+        AudioBuffer<float> input;
+        input.makeCopyOf(region);
+        SpectralNoiseReducer::process(input, region, profile, reductionDb, sensitivity);
+    }, markerStartPos, markerEndPos-markerStartPos+1);
+}
 
-    // set the positions
-    currentPos = markerStartPos;
-    markerStartPos = 0;
-    markerEndPos = getNumSamples();
-    boundPositions();
+void AudioProcessingComponent::setSilenceSettings(const SilenceSettings& settings)
+{
+    // queued, so a strip silence being prepared never sees the index change
+    editQueue.submit({"Silence Settings", nullptr, [this, settings] {
+        silenceIndex.setSettings(settings, levelIndex, getNumSamples());
+    }});
+}
 
-    audioBufferChanged.sendChangeMessage();
+const SilenceSettings& AudioProcessingComponent::getSilenceSettings()
+{
+    return silenceIndex.getSettings();
 }
 
-void AudioProcessingComponent::pasteFromCursor()
+std::vector<Range<int>> AudioProcessingComponent::getMarkedRegionSilentSpans()
+{
+    return silenceIndex.getSpans(markerStartPos, markerEndPos-markerStartPos+1);
+}
+
+void AudioProcessingComponent::setOnsetSettings(const OnsetSettings& settings)
+{
+    onsetIndex.setSettings(settings);
+}
+
+const OnsetSettings& AudioProcessingComponent::getOnsetSettings()
+{
+    return onsetIndex.getSettings();
+}
+
+std::vector<int> AudioProcessingComponent::getOnsets(int startSample, int numSamples)
 {
-    // TODO: the channel number is hard-coded here, which equals to the audio channel number
-    int newLength = currentPos + audioCopyBuffer.getNumSamples();
-    int replacedNumSamples = jmin(getNumSamples()-currentPos, audioCopyBuffer.getNumSamples());
-    int copiedNumSamples = audioCopyBuffer.getNumSamples();
+    return onsetIndex.getOnsets(startSample, numSamples);
+}
+
+std::vector<Range<int>> AudioProcessingComponent::getMarkedRegionOnsetSlices()
+{
+    std::vector<Range<int>> slices;
+    if (!fileLoaded)
+        return slices;
 
-    AudioBuffer<float> bufferBeforeOperation;
-    bufferBeforeOperation.setSize(getNumChannels(), replacedNumSamples);
-    AudioBuffer<float> bufferAfterOperation;
-    bufferAfterOperation.setSize(getNumChannels(), copiedNumSamples);
+    auto sliceStart = markerStartPos;
+    for (auto onset : onsetIndex.getOnsets(markerStartPos + 1, markerEndPos - markerStartPos))
+    {
+        slices.push_back({sliceStart, onset});
+        sliceStart = onset;
+    }
+    slices.push_back({sliceStart, markerEndPos + 1});
+    return slices;
+}
+
+void AudioProcessingComponent::selectOnsetSliceAtCursor()
+{
+    if (!fileLoaded)
+        return;
+
+    auto slice = onsetIndex.getSliceAt(currentPos);
+    markerStartPos = slice.getStart();
+    markerEndPos = slice.getEnd() - 1;
+    currentPos = markerStartPos;
+}
 
-    // fill the bufferBeforeOperation
-    for (int channel=0; channel<getNumChannels(); channel++)
-        bufferBeforeOperation.copyFrom(channel, 0, audioBuffer, 0, currentPos, replacedNumSamples);
+std::vector<Range<int>> AudioProcessingComponent::getMarkedRegionNonSilentSlices()
+{
+    std::vector<Range<int>> slices;
+    if (!fileLoaded)
+        return slices;
 
-    // operation
-    for (int channel=0; channel<getNumChannels(); channel++)
+    auto sliceStart = markerStartPos;
+    for (auto& span : getMarkedRegionSilentSpans())
     {
-        if (newLength > getNumSamples()) // resize audio buffer if it should get larger
-            audioBuffer.setSize(getNumChannels(), newLength, true);
-        audioBuffer.copyFrom(channel, currentPos, audioCopyBuffer, channel, 0, copiedNumSamples);
+        if (span.getStart() > sliceStart)
+            slices.push_back({sliceStart, span.getStart()});
+        sliceStart = jmax(sliceStart, span.getEnd());
     }
+    if (markerEndPos + 1 > sliceStart)
+        slices.push_back({sliceStart, markerEndPos + 1});
+    return slices;
+}
 
-    // fill the bufferAfterOperation
-    for (int channel=0; channel<getNumChannels(); channel++)
-        bufferAfterOperation.copyFrom(channel, 0, audioBuffer, 0, currentPos, copiedNumSamples);
+bool AudioProcessingComponent::exportSlices(const std::vector<Range<int>>& slices, const SliceExportSettings& settings)
+{
+    if (!fileLoaded || slices.empty())
+        return false;
+    return sliceExporter.start(audioBuffer, sampleRate, slices, settings);
+}
 
-    UndoRecord record{bufferBeforeOperation, bufferAfterOperation, 0, currentPos};
-    undoStack.addRecord(record);
+SliceExporter& AudioProcessingComponent::getSliceExporter()
+{
+    return sliceExporter;
+}
 
-    // set the markers
-    markerStartPos = currentPos;
-    markerEndPos = currentPos + copiedNumSamples;
-    boundPositions();
+const RegionList& AudioProcessingComponent::getRegionList()
+{
+    return regionList;
+}
 
-    audioBufferChanged.sendChangeMessage();
+int AudioProcessingComponent::addRegionFromMarkedRegion()
+{
+    if (!fileLoaded)
+        return -1;
+    return regionList.add("Region " + String(regionList.size() + 1), getMarkedRegion());
 }
 
-void AudioProcessingComponent::insertFromCursor()
+int AudioProcessingComponent::addMarkerAtCursor()
 {
-    AudioBuffer<float> bufferBeforeOperation;
-    bufferBeforeOperation.setSize(getNumChannels(), 0);
-    AudioBuffer<float> bufferAfterOperation;
-    bufferAfterOperation.setSize(getNumChannels(), audioCopyBuffer.getNumSamples());
+    if (!fileLoaded)
+        return -1;
+    return regionList.add("Marker " + String(regionList.size() + 1), {currentPos, currentPos});
+}
 
-    AudioBufferUtils<float>::insertRegion(audioBuffer, audioCopyBuffer, currentPos);
+void AudioProcessingComponent::removeRegion(int id)
+{
+    regionList.remove(id);
+}
 
-    // fill the bufferAfterOperation
-    for (int channel=0; channel<getNumChannels(); channel++)
-        bufferAfterOperation.copyFrom(channel, 0, audioBuffer, 0, currentPos, audioCopyBuffer.getNumSamples());
+void AudioProcessingComponent::renameRegion(int id, const String& name)
+{
+    regionList.setName(id, name);
+}
 
-    UndoRecord record{bufferBeforeOperation, bufferAfterOperation, 0, currentPos};
-    undoStack.addRecord(record);
+int AudioProcessingComponent::getRegionAt(double positionInS, double maxDistanceInS)
+{
+    return regionList.hitTest(static_cast<int>(positionInS * sampleRate), static_cast<int>(maxDistanceInS * sampleRate));
+}
+
+void AudioProcessingComponent::selectRegion(int id)
+{
+    if (!fileLoaded || !regionList.contains(id))
+        return;
 
-    // set the markers
-    markerStartPos = currentPos;
-    markerEndPos = currentPos + audioCopyBuffer.getNumSamples();
+    auto region = regionList.get(id);
+    currentPos = region.range.getStart();
+    if (!region.isMarker())
+    {
+        markerStartPos = region.range.getStart();
+        markerEndPos = region.range.getEnd() - 1;
+    }
     boundPositions();
+}
 
-    audioBufferChanged.sendChangeMessage();
+void AudioProcessingComponent::muteAllRegions()
+{
+    inplaceOperateRanges("Mute Regions", [](AudioBuffer<float>& region) {
+        region.clear();
+    }, getRegionRanges());
 }
 
-bool AudioProcessingComponent::isPasteEnabled()
+void AudioProcessingComponent::fadeInAllRegions()
 {
-    return !audioCopyBuffer.hasBeenCleared();
+    inplaceOperateRanges("Fade In Regions", [](AudioBuffer<float>& region) {
+        for (int channel=0; channel<region.getNumChannels(); channel++)
+            AudioProcessingUtils::fadeIn(region.getWritePointer(channel), 0, region.getNumSamples());
+    }, getRegionRanges());
 }
 
-void AudioProcessingComponent::undo()
+void AudioProcessingComponent::fadeOutAllRegions()
+{
+    inplaceOperateRanges("Fade Out Regions", [](AudioBuffer<float>& region) {
+        for (int channel=0; channel<region.getNumChannels(); channel++)
+            AudioProcessingUtils::fadeOut(region.getWritePointer(channel), 0, region.getNumSamples());
+    }, getRegionRanges());
+}
+
+void AudioProcessingComponent::normalizeAllRegions()
+{
+    // every region is normalized to its own peak, found when it is processed
+    // because an earlier overlapping region may have changed it
+    inplaceOperateRanges("Normalize Regions", [](AudioBuffer<float>& region) {
+        for (int channel=0; channel<region.getNumChannels(); channel++)
+            AudioProcessingUtils::normalize(region.getWritePointer(channel), 0, region.getNumSamples());
+    }, getRegionRanges());
+}
+
+std::vector<Range<int>> AudioProcessingComponent::getRegionRanges()
+{
+    std::vector<Range<int>> ranges;
+    for (auto& region : regionList.getAll())
+        if (!region.isMarker())
+            ranges.push_back(region.range);
+    return ranges;
+}
+
+void AudioProcessingComponent::stripSilenceInMarkedRegion(float keepMs)
+{
+    struct Result
+    {
+        int startSample = 0;
+        int numRemoved = 0;
+        int numDeleted = 0;
+        AudioBuffer<float> document;
+        UndoRecord record;
+    };
+    auto result = std::make_shared<Result>();
+    auto regionStart = markerStartPos;
+    auto regionEnd = markerEndPos;
+
+    // the stripped document is made on the worker, applying it only moves it in
+    editQueue.submit({"Strip Silence", [this, result, keepMs, regionStart, regionEnd](EditProgress& progress) {
+        if (!fileLoaded)
+            return false;
+
+        // cut the middle of every span that is longer than what is kept
+        auto keepSamples = jmax(0, static_cast<int>(keepMs * sampleRate / 1000.0));
+        std::vector<Range<int>> cuts;
+        for (auto& span : silenceIndex.getSpans(regionStart, regionEnd-regionStart+1))
+        {
+            if (span.getLength() <= keepSamples)
+                continue;
+            auto head = keepSamples / 2;
+            cuts.push_back({span.getStart() + head, span.getEnd() - (keepSamples - head)});
+            result->numDeleted += cuts.back().getLength();
+        }
+        if (cuts.empty())
+            return false;
+
+        // one record from the first to the last cut, so a single undo restores everything
+        auto startSample = cuts.front().getStart();
+        auto numRemoved = cuts.back().getEnd() - startSample;
+        auto numInserted = numRemoved - result->numDeleted;
+        result->startSample = startSample;
+        result->numRemoved = numRemoved;
+
+        AudioBuffer<float> bufferBeforeOperation (getNumChannels(), numRemoved);
+        for (int channel=0; channel<getNumChannels(); channel++)
+            bufferBeforeOperation.copyFrom(channel, 0, audioBuffer, channel, startSample, numRemoved);
+        if (!progress.setProgress(0.2))
+            return false;
+
+        AudioBufferUtils<float>::copyWithRegionsDeleted(audioBuffer, cuts, result->document);
+        if (!progress.setProgress(0.8))
+            return false;
+
+        AudioBuffer<float> bufferAfterOperation (getNumChannels(), numInserted);
+        for (int channel=0; channel<getNumChannels(); channel++)
+            bufferAfterOperation.copyFrom(channel, 0, result->document, channel, startSample, numInserted);
+
+        result->record = UndoRecord(std::move(bufferBeforeOperation), std::move(bufferAfterOperation), 0, startSample);
+        return progress.setProgress(1.0);
+    }, [this, result, regionStart, regionEnd] {
+        auto regionsBefore = regionList.getReshapedBy(result->startSample, result->numRemoved);
+        bufferWillChange();
+        audioBuffer = std::move(result->document);
+        bufferRegionChanged(result->startSample, result->numRemoved, result->numRemoved - result->numDeleted);
+        result->record.setRegions(regionsBefore, regionList.getCurrent(regionsBefore));
+        undoStack.addRecord(std::move(result->record));
+
+        // keep the stripped region selected
+        markerStartPos = regionStart;
+        markerEndPos = regionEnd - result->numDeleted;
+        currentPos = markerStartPos;
+        boundPositions();
+    }});
+}
+
+LoudnessResult AudioProcessingComponent::measureLoudness()
+{
+    return LoudnessMeter::measure(audioBuffer, 0, getNumSamples(), sampleRate);
+}
+
+float AudioProcessingComponent::getMomentaryLoudness()
+{
+    return loudnessMeter.getMomentaryLoudness();
+}
+
+float AudioProcessingComponent::getShortTermLoudness()
+{
+    return loudnessMeter.getShortTermLoudness();
+}
+
+float AudioProcessingComponent::getIntegratedLoudness()
+{
+    return loudnessMeter.getIntegratedLoudness();
+}
+
+float AudioProcessingComponent::getTruePeak()
+{
+    return loudnessMeter.getTruePeak();
+}
+
+LevelMeter& AudioProcessingComponent::getLevelMeter()
+{
+    return levelMeter;
+}
+
+CallbackProfiler& AudioProcessingComponent::getCallbackProfiler()
+{
+    return callbackProfiler;
+}
+
+void AudioProcessingComponent::setResamplerQuality(PlaybackResampler::Quality quality)
+{
+    requestedResamplerQuality.store(quality);
+}
+
+PlaybackResampler::Quality AudioProcessingComponent::getResamplerQuality()
+{
+    return static_cast<PlaybackResampler::Quality>(requestedResamplerQuality.load());
+}
+
+void AudioProcessingComponent::setLoopCrossfade(float milliseconds)
+{
+    loopCrossfadeMs.store(jmax(0.f, milliseconds));
+}
+
+float AudioProcessingComponent::getLoopCrossfade()
+{
+    return loopCrossfadeMs.load();
+}
+
+void AudioProcessingComponent::setPlaybackRate(float rate)
+{
+    auto speed = jlimit(minPlaybackRate, maxPlaybackRate, std::abs(rate));
+    playbackRate.store(rate < 0.f ? -speed : speed);
+}
+
+float AudioProcessingComponent::getPlaybackRate()
+{
+    return playbackRate.load();
+}
+
+void AudioProcessingComponent::startScrubbing(double positionInS)
 {
-    if(!isUndoEnabled())
+    if (!fileLoaded)
         return;
+    auto position = jlimit(0, getNumSamples(), static_cast<int>(positionInS * sampleRate));
+    scrubTargetPos.store(position);
+    if (state != Playing)
+    {
+        // the audio thread moves the playhead and starts from rest when it sees the flag
+        scrubStartPos.store(position);
+    }
+    scrubActive.store(true, std::memory_order_release);
+}
 
-    int startSample;
-    int numSamples;
-    undoStack.undo(audioBuffer, startSample, numSamples);
+void AudioProcessingComponent::scrubTo(double positionInS)
+{
+    scrubTargetPos.store(jlimit(0, getNumSamples(), static_cast<int>(positionInS * sampleRate)));
+}
 
-    markerStartPos = startSample;
-    markerEndPos = startSample+numSamples-1;
-    currentPos = markerStartPos;
-    boundPositions();
+void AudioProcessingComponent::stopScrubbing()
+{
+    scrubActive.store(false);
+}
 
-    audioBufferChanged.sendChangeMessage();
+bool AudioProcessingComponent::isScrubbing()
+{
+    return scrubActive.load();
 }
 
-void AudioProcessingComponent::redo()
+void AudioProcessingComponent::setTimeStretchPreview(bool enabled)
 {
-    if(!isRedoEnabled())
+    timeStretchPreviewEnabled.store(enabled);
+}
+
+bool AudioProcessingComponent::isTimeStretchPreviewEnabled()
+{
+    return timeStretchPreviewEnabled.load();
+}
+
+void AudioProcessingComponent::setTimeStretchParameters(float stretchFactor, float pitchSemitones)
+{
+    timeStretchFactor.store(jlimit(0.25f, 4.f, stretchFactor));
+    timeStretchSemitones.store(jlimit(-12.f, 12.f, pitchSemitones));
+}
+
+void AudioProcessingComponent::timeStretchMarkedRegion(float stretchFactor, float pitchSemitones)
+{
+    if (!fileLoaded)
         return;
+    auto stretch = static_cast<double>(jlimit(0.25f, 4.f, stretchFactor));
+    auto pitch = std::pow(2.0, jlimit(-12.f, 12.f, pitchSemitones) / 12.0);
+    replaceOperate("Time Stretch", [stretch, pitch](const AudioBuffer<float>& region, AudioBuffer<float>& result) {
+        TimeStretcher::process(region, stretch, pitch, result);
+    }, markerStartPos, markerEndPos-markerStartPos+1);
+}
 
-    int startSample;
-    int numSamples;
-    undoStack.redo(audioBuffer, startSample, numSamples);
+EffectChain& AudioProcessingComponent::getEffectChain()
+{
+    return effectChain;
+}
 
-    markerStartPos = startSample;
-    markerEndPos = startSample+numSamples-1;
-    currentPos = markerStartPos;
-    boundPositions();
+void AudioProcessingComponent::renderEffectChainToMarkedRegion()
+{
+    if (!fileLoaded || effectChain.getNumEffects() == 0)
+        return;
+    auto regionStart = markerStartPos;
+    auto regionEnd = markerEndPos;
+    auto documentSampleRate = static_cast<double>(sampleRate);
+    // the worker renders copies, the chain may be edited meanwhile
+    auto effects = effectChain.cloneEffects();
+    replaceOperate("Render Effects", [effects, regionStart, regionEnd, documentSampleRate](const AudioBuffer<float>& region, AudioBuffer<float>& result) {
+        result.makeCopyOf(region);
+        EffectChain::render(effects, result, documentSampleRate, regionStart, regionEnd);
+    }, markerStartPos, markerEndPos-markerStartPos+1);
+
+    // the effects are in the audio now, playing them again would apply them twice,
+    // unless the render is cancelled, which drops this as well
+    editQueue.submit({"Clear Effects", nullptr, [this] { effectChain.clear(); }});
+}
+
+ChannelRouter& AudioProcessingComponent::getChannelRouter()
+{
+    return channelRouter;
+}
 
-    audioBufferChanged.sendChangeMessage();
+LevelSummary AudioProcessingComponent::getMarkedRegionLevels()
+{
+    return levelIndex.getLevels(audioBuffer, markerStartPos, markerEndPos-markerStartPos+1);
+}
+
+LevelSummary AudioProcessingComponent::getMarkedRegionLevels(int channel)
+{
+    return levelIndex.getLevels(audioBuffer, channel, markerStartPos, markerEndPos-markerStartPos+1);
+}
+
+void AudioProcessingComponent::convertSampleRate(double targetSampleRate)
+{
+    if (!fileLoaded || targetSampleRate <= 0 || targetSampleRate == sampleRate)
+        return;
+
+    struct Result
+    {
+        double sourceSampleRate = 0.0;
+        AudioBuffer<float> convertedBuffer;
+        UndoRecord record;
+    };
+    auto result = std::make_shared<Result>();
+
+    editQueue.submit({"Convert Sample Rate", [this, result, targetSampleRate](EditProgress& progress) {
+        result->sourceSampleRate = sampleRate;
+        if (targetSampleRate == result->sourceSampleRate)
+            return false;
+        SampleRateConverter::process(audioBuffer, result->sourceSampleRate, targetSampleRate, result->convertedBuffer);
+        if (!progress.setProgress(0.6))
+            return false;
+
+        result->record = UndoRecord(audioBuffer, result->convertedBuffer, 0, 0);
+        result->record.setSampleRates(result->sourceSampleRate, targetSampleRate);
+        return progress.setProgress(1.0);
+    }, [this, result, targetSampleRate] {
+        undoStack.addRecord(std::move(result->record));
+
+        auto oldNumSamples = getNumSamples();
+        auto ratio = targetSampleRate / result->sourceSampleRate;
+        auto regions = regionList.getAll();
+        bufferWillChange();
+        audioBuffer = std::move(result->convertedBuffer);
+        setDocumentSampleRate(targetSampleRate);
+        bufferRegionChanged(0, oldNumSamples, getNumSamples());
+
+        rescaleRegions(regions, ratio);
+
+        // keep the markers at the same time
+        markerStartPos = static_cast<int>(markerStartPos * ratio);
+        markerEndPos = static_cast<int>(markerEndPos * ratio);
+        currentPos = static_cast<int>(currentPos * ratio);
+        boundPositions();
+    }});
+}
+
+void AudioProcessingComponent::rescaleRegions(const std::vector<Region>& regions, double ratio)
+{
+    // replacing the whole buffer collapses the regions, put them back at the same time
+    for (auto& region : regions)
+        regionList.setRange(region.id, {static_cast<int>(region.range.getStart() * ratio), static_cast<int>(region.range.getEnd() * ratio)});
+}
+
+void AudioProcessingComponent::setDocumentSampleRate(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    silenceIndex.setSampleRate(sampleRate);
+    if (deviceSampleRate > 0)
+        resampler.setSpeedRatio(sampleRate / deviceSampleRate);
+}
+
+void AudioProcessingComponent::gainMarkedRegion(float gainValue)
+{
+    auto gainFunc = AudioProcessingUtils::getGainFunc(gainValue);
+    inplaceOperateMarkedRegion("Gain", gainFunc);
+}
+
+void AudioProcessingComponent::copyMarkedRegion()
+{
+    auto startSample = markerStartPos;
+    auto numSamples = markerEndPos-markerStartPos+1;
+    auto copiedBuffer = std::make_shared<AudioBuffer<float>>();
+    editQueue.submit({"Copy", [this, copiedBuffer, startSample, numSamples](EditProgress& progress) {
+        // TODO: the channel number is hard-coded here, which equals to the audio channel number
+        copiedBuffer->setSize(getNumChannels(), numSamples);
+        for (int channel=0; channel<getNumChannels(); channel++)
+            copiedBuffer->copyFrom(channel, 0, audioBuffer, channel, startSample, numSamples);
+        return progress.setProgress(1.0);
+    }, [this, copiedBuffer] {
+        audioCopyBuffer = std::move(*copiedBuffer);
+        audioCopied.sendChangeMessage();
+    }});
+}
+
+void AudioProcessingComponent::cutMarkedRegion()
+{
+    copyMarkedRegion();
+    muteMarkedRegion();
+}
+
+void AudioProcessingComponent::deleteMarkedRegion()
+{
+    auto startSample = markerStartPos;
+    auto numSamples = markerEndPos-markerStartPos+1;
+    struct Result
+    {
+        int numDeleted = 0;
+        AudioBuffer<float> document;
+        UndoRecord record;
+    };
+    auto result = std::make_shared<Result>();
+
+    // the shorter document is made on the worker, applying it only moves it in
+    editQueue.submit({"Delete", [this, result, startSample, numSamples](EditProgress& progress) {
+        result->numDeleted = jmin(numSamples, getNumSamples() - startSample);
+        if (result->numDeleted <= 0)
+            return false;
+
+        // fill the bufferBeforeOperation
+        AudioBuffer<float> bufferBeforeOperation (getNumChannels(), result->numDeleted);
+        AudioBuffer<float> bufferAfterOperation (getNumChannels(), 0);
+        for (int channel=0; channel<getNumChannels(); channel++)
+            bufferBeforeOperation.copyFrom(channel, 0, audioBuffer, channel, startSample, result->numDeleted);
+        if (!progress.setProgress(0.3))
+            return false;
+
+        AudioBufferUtils<float>::copyWithRegionReplaced(audioBuffer, bufferAfterOperation, startSample, result->numDeleted, result->document);
+        result->record = UndoRecord(std::move(bufferBeforeOperation), std::move(bufferAfterOperation), 0, startSample);
+        return progress.setProgress(1.0);
+    }, [this, result, startSample] {
+        auto regionsBefore = regionList.getReshapedBy(startSample, result->numDeleted);
+        bufferWillChange();
+        audioBuffer = std::move(result->document);
+        bufferRegionChanged(startSample, result->numDeleted, 0);
+        result->record.setRegions(regionsBefore, regionList.getCurrent(regionsBefore));
+        undoStack.addRecord(std::move(result->record));
+
+        // set the positions
+        currentPos = startSample;
+        markerStartPos = 0;
+        markerEndPos = getNumSamples();
+        boundPositions();
+    }});
+}
+
+void AudioProcessingComponent::pasteFromCursor()
+{
+    auto position = currentPos;
+    struct Result
+    {
+        int replacedNumSamples = 0;
+        int copiedNumSamples = 0;
+        AudioBuffer<float> document;
+        UndoRecord record;
+    };
+    auto result = std::make_shared<Result>();
+
+    // the new document is made on the worker, applying it only moves it in
+    editQueue.submit({"Paste", [this, result, position](EditProgress& progress) {
+        // TODO: the channel number is hard-coded here, which equals to the audio channel number
+        result->copiedNumSamples = audioCopyBuffer.getNumSamples();
+        result->replacedNumSamples = jmin(getNumSamples()-position, result->copiedNumSamples);
+
+        // fill the bufferBeforeOperation and the bufferAfterOperation
+        AudioBuffer<float> bufferBeforeOperation (getNumChannels(), result->replacedNumSamples);
+        for (int channel=0; channel<getNumChannels(); channel++)
+            bufferBeforeOperation.copyFrom(channel, 0, audioBuffer, channel, position, result->replacedNumSamples);
+        AudioBuffer<float> bufferAfterOperation;
+        bufferAfterOperation.makeCopyOf(audioCopyBuffer);
+        if (!progress.setProgress(0.3))
+            return false;
+
+        // operation
+        AudioBufferUtils<float>::copyWithRegionReplaced(audioBuffer, audioCopyBuffer, position, result->replacedNumSamples, result->document);
+        result->record = UndoRecord(std::move(bufferBeforeOperation), std::move(bufferAfterOperation), 0, position);
+        return progress.setProgress(1.0);
+    }, [this, result, position] {
+        auto regionsBefore = regionList.getReshapedBy(position, result->replacedNumSamples);
+        bufferWillChange();
+        audioBuffer = std::move(result->document);
+        bufferRegionChanged(position, result->replacedNumSamples, result->copiedNumSamples);
+        result->record.setRegions(regionsBefore, regionList.getCurrent(regionsBefore));
+        undoStack.addRecord(std::move(result->record));
+
+        // set the markers
+        markerStartPos = position;
+        markerEndPos = position + result->copiedNumSamples;
+        boundPositions();
+    }});
+}
+
+void AudioProcessingComponent::insertFromCursor()
+{
+    auto position = currentPos;
+    struct Result
+    {
+        int insertedNumSamples = 0;
+        AudioBuffer<float> document;
+        UndoRecord record;
+    };
+    auto result = std::make_shared<Result>();
+
+    // the longer document is made on the worker, applying it only moves it in
+    editQueue.submit({"Insert", [this, result, position](EditProgress& progress) {
+        result->insertedNumSamples = audioCopyBuffer.getNumSamples();
+        AudioBuffer<float> bufferBeforeOperation (getNumChannels(), 0);
+        AudioBuffer<float> bufferAfterOperation;
+        bufferAfterOperation.makeCopyOf(audioCopyBuffer);
+        if (!progress.setProgress(0.3))
+            return false;
+
+        AudioBufferUtils<float>::copyWithRegionReplaced(audioBuffer, audioCopyBuffer, position, 0, result->document);
+        result->record = UndoRecord(std::move(bufferBeforeOperation), std::move(bufferAfterOperation), 0, position);
+        return progress.setProgress(1.0);
+    }, [this, result, position] {
+        bufferWillChange();
+        audioBuffer = std::move(result->document);
+        bufferRegionChanged(position, 0, result->insertedNumSamples);
+        undoStack.addRecord(std::move(result->record));
+
+        // set the markers
+        markerStartPos = position;
+        markerEndPos = position + result->insertedNumSamples;
+        boundPositions();
+    }});
+}
+
+bool AudioProcessingComponent::isPasteEnabled()
+{
+    return !audioCopyBuffer.hasBeenCleared();
+}
+
+void AudioProcessingComponent::undo()
+{
+    // a record that changes the length is put into a new document on the
+    // worker, the others are copied into place when they are applied
+    struct Result
+    {
+        bool prepared = false;
+        AudioBuffer<float> document;
+    };
+    auto result = std::make_shared<Result>();
+
+    editQueue.submit({"Undo", [this, result](EditProgress& progress) {
+        if(!isUndoEnabled())
+            return false;
+        result->prepared = undoStack.prepareUndo(audioBuffer, result->document);
+        return progress.setProgress(1.0);
+    }, [this, result] {
+        if(!isUndoEnabled())
+            return;
+
+        int startSample;
+        int numSamples;
+        int oldNumSamples = getNumSamples();
+        double newSampleRate = 0.0;
+        auto oldSampleRate = sampleRate;
+        auto regions = regionList.getAll();
+        std::vector<Region> reshapedRegions;
+        bufferWillChange();
+        undoStack.undo(audioBuffer, startSample, numSamples, newSampleRate, reshapedRegions,
+                       result->prepared ? &result->document : nullptr);
+        if (newSampleRate > 0.0)
+            setDocumentSampleRate(newSampleRate);
+        bufferRegionChanged(startSample, oldNumSamples - getNumSamples() + numSamples, numSamples);
+        if (newSampleRate > 0.0)
+            rescaleRegions(regions, newSampleRate / oldSampleRate);
+        // the regions the edit cut don't get their shape back by moving
+        regionList.restore(reshapedRegions);
+
+        markerStartPos = startSample;
+        markerEndPos = startSample+numSamples-1;
+        currentPos = markerStartPos;
+        boundPositions();
+    }});
+}
+
+void AudioProcessingComponent::redo()
+{
+    // a record that changes the length is put into a new document on the
+    // worker, the others are copied into place when they are applied
+    struct Result
+    {
+        bool prepared = false;
+        AudioBuffer<float> document;
+    };
+    auto result = std::make_shared<Result>();
+
+    editQueue.submit({"Redo", [this, result](EditProgress& progress) {
+        if(!isRedoEnabled())
+            return false;
+        result->prepared = undoStack.prepareRedo(audioBuffer, result->document);
+        return progress.setProgress(1.0);
+    }, [this, result] {
+        if(!isRedoEnabled())
+            return;
+
+        int startSample;
+        int numSamples;
+        int oldNumSamples = getNumSamples();
+        double newSampleRate = 0.0;
+        auto oldSampleRate = sampleRate;
+        auto regions = regionList.getAll();
+        std::vector<Region> reshapedRegions;
+        bufferWillChange();
+        undoStack.redo(audioBuffer, startSample, numSamples, newSampleRate, reshapedRegions,
+                       result->prepared ? &result->document : nullptr);
+        if (newSampleRate > 0.0)
+            setDocumentSampleRate(newSampleRate);
+        bufferRegionChanged(startSample, oldNumSamples - getNumSamples() + numSamples, numSamples);
+        if (newSampleRate > 0.0)
+            rescaleRegions(regions, newSampleRate / oldSampleRate);
+        // the regions the edit cut don't get their shape back by moving
+        regionList.restore(reshapedRegions);
+
+        markerStartPos = startSample;
+        markerEndPos = startSample+numSamples-1;
+        currentPos = markerStartPos;
+        boundPositions();
+    }});
 }
 
 bool AudioProcessingComponent::isUndoEnabled()
@@ -351,6 +1213,16 @@ bool AudioProcessingComponent::isRedoEnabled()
     return undoStack.isRedoEnabled();
 }
 
+EditCommandQueue& AudioProcessingComponent::getEditQueue()
+{
+    return editQueue;
+}
+
+bool AudioProcessingComponent::waitForEdits(int timeOutMilliseconds)
+{
+    return editQueue.waitUntilIdle(timeOutMilliseconds);
+}
+
 void AudioProcessingComponent::boundPositions()
 {
     if (markerStartPos < 0)
@@ -369,39 +1241,240 @@ void AudioProcessingComponent::boundPositions()
         currentPos = getNumSamples() - 1;
 }
 
-void AudioProcessingComponent::inplaceOperate(const std::function<void(float*, int, int)>& processFunc, int startSample, int numSamples)
+void AudioProcessingComponent::bufferRegionChanged(int startSample, int numRemoved, int numInserted)
+{
+    levelIndex.update(audioBuffer, startSample, numRemoved, numInserted);
+    silenceIndex.update(levelIndex, getNumSamples(), startSample, numRemoved, numInserted);
+    zeroCrossingIndex.update(startSample, numRemoved, numInserted);
+    onsetIndex.update(startSample, numRemoved, numInserted, sampleRate);
+    regionList.update(startSample, numRemoved, numInserted);
+    audioBufferChanged.addChange(startSample, numRemoved, numInserted, getNumSamples());
+}
+
+void AudioProcessingComponent::bufferRangesChanged(const std::vector<Range<int>>& ranges)
+{
+    for (auto& range : ranges)
+    {
+        levelIndex.update(audioBuffer, range.getStart(), range.getLength(), range.getLength());
+        silenceIndex.update(levelIndex, getNumSamples(), range.getStart(), range.getLength(), range.getLength());
+    }
+    // the background indices restart once for all ranges, regions don't move
+    zeroCrossingIndex.update(ranges);
+    onsetIndex.update(ranges);
+    // listeners get the span of the ranges
+    if (!ranges.empty())
+    {
+        auto span = ranges.front().getUnionWith(ranges.back());
+        audioBufferChanged.addChange(span.getStart(), span.getLength(), span.getLength(), getNumSamples());
+    }
+}
+
+void AudioProcessingComponent::bufferWillChange()
 {
-    int numAudioSamples;
+    zeroCrossingIndex.stopBuilding();
+    onsetIndex.stopBuilding();
+    sliceExporter.cancel();
+}
 
-    AudioBuffer<float> bufferBeforeOperation;
-    bufferBeforeOperation.setSize(getNumChannels(), numSamples);
-    AudioBuffer<float> bufferAfterOperation;
-    bufferAfterOperation.setSize(getNumChannels(), numSamples);
+void AudioProcessingComponent::inplaceOperate(const String& name, const std::function<void(float*, int, int)>& processFunc, int startSample, int numSamples)
+{
+    inplaceOperatePerChannel(name, [processFunc](int, float* bufferWritePointer, int start, int num) {
+        processFunc(bufferWritePointer, start, num);
+    }, startSample, numSamples);
+}
 
-    // fill the bufferBeforeOperation
-    for (int channel=0; channel<getNumChannels(); channel++)
-        bufferBeforeOperation.copyFrom(channel, 0, audioBuffer, 0, startSample, numSamples);
+void AudioProcessingComponent::inplaceOperatePerChannel(const String& name, const std::function<void(int, float*, int, int)>& processFunc, int startSample, int numSamples)
+{
+    inplaceOperateRegion(name, [processFunc](AudioBuffer<float>& region) {
+        for (int channel=0; channel<region.getNumChannels(); channel++)
+            processFunc(channel, region.getWritePointer(channel), 0, region.getNumSamples());
+    }, startSample, numSamples);
+}
 
-    // operation
-    for (int channel=0; channel<getNumChannels(); channel++)
+void AudioProcessingComponent::inplaceOperateRegion(const String& name, const std::function<void(AudioBuffer<float>&)>& processFunc, int startSample, int numSamples)
+{
+    // the function works on a copy, the document only changes when the result is applied
+    struct Result
     {
-        auto channelPointer = getAudioWritePointer(channel, numAudioSamples);
-        auto actualNumSamples = jmin(numSamples, numAudioSamples - startSample);
-        processFunc(channelPointer, startSample, actualNumSamples);
-    }
+        AudioBuffer<float> bufferAfterOperation;
+        UndoRecord record;
+    };
+    auto result = std::make_shared<Result>();
+
+    editQueue.submit({name, [this, processFunc, result, startSample, numSamples](EditProgress& progress) {
+        auto regionLength = jmin(numSamples, getNumSamples() - startSample);
+        if (regionLength <= 0)
+            return false;
+
+        // fill the bufferBeforeOperation
+        AudioBuffer<float> bufferBeforeOperation (getNumChannels(), regionLength);
+        for (int channel=0; channel<getNumChannels(); channel++)
+            bufferBeforeOperation.copyFrom(channel, 0, audioBuffer, channel, startSample, regionLength);
+        result->bufferAfterOperation.makeCopyOf(bufferBeforeOperation);
+        if (!progress.setProgress(0.1))
+            return false;
+
+        processFunc(result->bufferAfterOperation);
+        if (!progress.setProgress(0.6))
+            return false;
+
+        result->record = UndoRecord(std::move(bufferBeforeOperation), result->bufferAfterOperation, 0, startSample);
+        return progress.setProgress(1.0);
+    }, [this, result, startSample] {
+        auto regionLength = result->bufferAfterOperation.getNumSamples();
+        bufferWillChange();
+        for (int channel=0; channel<getNumChannels(); channel++)
+            audioBuffer.copyFrom(channel, startSample, result->bufferAfterOperation, channel, 0, regionLength);
+        bufferRegionChanged(startSample, regionLength, regionLength);
+        undoStack.addRecord(std::move(result->record));
+    }});
+}
 
-    // fill the bufferAfterOperation
-    for (int channel=0; channel<getNumChannels(); channel++)
-        bufferAfterOperation.copyFrom(channel, 0, audioBuffer, 0, startSample, numSamples);
+void AudioProcessingComponent::inplaceOperateRanges(const String& name, const std::function<void(AudioBuffer<float>&)>& processFunc, std::vector<Range<int>> ranges)
+{
+    if (!fileLoaded)
+        return;
 
-    UndoRecord record{bufferBeforeOperation, bufferAfterOperation, 0, startSample};
-    undoStack.addRecord(record);
-    audioBufferChanged.sendChangeMessage();
+    // the ranges are processed in copies of the spans they cover
+    struct Result
+    {
+        std::vector<Range<int>> dirtyRanges;
+        std::vector<AudioBuffer<float>> spans;
+        UndoRecord record;
+    };
+    auto result = std::make_shared<Result>();
+
+    editQueue.submit({name, [this, processFunc, result, ranges](EditProgress& progress) mutable {
+        for (auto& range : ranges)
+            range = range.getIntersectionWith({0, getNumSamples()});
+        ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [](const Range<int>& range) { return range.isEmpty(); }), ranges.end());
+        if (ranges.empty())
+            return false;
+        std::sort(ranges.begin(), ranges.end(), [](const Range<int>& a, const Range<int>& b) { return a.getStart() < b.getStart(); });
+
+        // the union of the ranges, for the copies and the indices
+        auto& dirtyRanges = result->dirtyRanges;
+        for (auto& range : ranges)
+        {
+            if (!dirtyRanges.empty() && dirtyRanges.back().getEnd() >= range.getStart())
+                dirtyRanges.back().setEnd(jmax(dirtyRanges.back().getEnd(), range.getEnd()));
+            else
+                dirtyRanges.push_back(range);
+        }
+        for (auto& span : dirtyRanges)
+        {
+            result->spans.emplace_back(getNumChannels(), span.getLength());
+            for (int channel=0; channel<getNumChannels(); channel++)
+                result->spans.back().copyFrom(channel, 0, audioBuffer, channel, span.getStart(), span.getLength());
+        }
+
+        // split the ranges into layers without overlaps, a range goes to the first
+        // layer that ends before it so overlapping ranges are processed in order
+        std::vector<std::vector<Range<int>>> layers;
+        for (auto& range : ranges)
+        {
+            auto layer = std::find_if(layers.begin(), layers.end(), [&range](const std::vector<Range<int>>& l) { return l.back().getEnd() <= range.getStart(); });
+            if (layer == layers.end())
+                layers.push_back({range});
+            else
+                layer->push_back(range);
+        }
+
+        std::atomic<int> numDone {0};
+        auto numRanges = static_cast<double>(ranges.size());
+        for (auto& layer : layers)
+        {
+            std::vector<UndoRecord::Part> parts (layer.size());
+            ParallelUtils::parallelFor(static_cast<int>(layer.size()), [&](int index) {
+                if (progress.isCancelled())
+                    return;
+                auto range = layer[static_cast<size_t>(index)];
+                auto span = static_cast<size_t>(std::upper_bound(dirtyRanges.begin(), dirtyRanges.end(), range.getStart(),
+                                                                 [](int position, const Range<int>& r) { return position < r.getStart(); })
+                                                - dirtyRanges.begin() - 1);
+                auto& spanBuffer = result->spans[span];
+                auto offset = range.getStart() - dirtyRanges[span].getStart();
+
+                AudioBuffer<float> bufferBeforeOperation (spanBuffer.getNumChannels(), range.getLength());
+                for (int channel=0; channel<spanBuffer.getNumChannels(); channel++)
+                    bufferBeforeOperation.copyFrom(channel, 0, spanBuffer, channel, offset, range.getLength());
+                AudioBuffer<float> region (spanBuffer.getArrayOfWritePointers(), spanBuffer.getNumChannels(), offset, range.getLength());
+                processFunc(region);
+
+                parts[static_cast<size_t>(index)] = UndoRecord::Part(bufferBeforeOperation, region, range.getStart());
+                progress.setProgress(++numDone / numRanges);
+            });
+            if (progress.isCancelled())
+                return false;
+            for (auto& part : parts)
+                result->record.addPart(std::move(part));
+        }
+        return true;
+    }, [this, result] {
+        bufferWillChange();
+        for (size_t span=0; span<result->spans.size(); span++)
+            for (int channel=0; channel<getNumChannels(); channel++)
+                audioBuffer.copyFrom(channel, result->dirtyRanges[span].getStart(), result->spans[span], channel, 0, result->spans[span].getNumSamples());
+        bufferRangesChanged(result->dirtyRanges);
+        undoStack.addRecord(std::move(result->record));
+    }});
 }
 
-void AudioProcessingComponent::inplaceOperateMarkedRegion(const std::function<void(float*, int, int)>& processFunc)
+void AudioProcessingComponent::replaceOperate(const String& name, const std::function<void(const AudioBuffer<float>&, AudioBuffer<float>&)>& processFunc, int startSample, int numSamples)
 {
-    inplaceOperate(processFunc, markerStartPos, markerEndPos-markerStartPos+1);
+    // the result is made from a copy, the document only changes when it is applied
+    struct Result
+    {
+        int numRemoved = 0;
+        int numInserted = 0;
+        AudioBuffer<float> document;
+        UndoRecord record;
+    };
+    auto result = std::make_shared<Result>();
+
+    editQueue.submit({name, [this, processFunc, result, startSample, numSamples](EditProgress& progress) {
+        result->numRemoved = jmin(numSamples, getNumSamples() - startSample);
+        if (result->numRemoved <= 0)
+            return false;
+
+        // fill the bufferBeforeOperation
+        AudioBuffer<float> bufferBeforeOperation (getNumChannels(), result->numRemoved);
+        for (int channel=0; channel<getNumChannels(); channel++)
+            bufferBeforeOperation.copyFrom(channel, 0, audioBuffer, channel, startSample, result->numRemoved);
+        if (!progress.setProgress(0.1))
+            return false;
+
+        // operation, the result may have any length
+        AudioBuffer<float> bufferAfterOperation;
+        processFunc(bufferBeforeOperation, bufferAfterOperation);
+        result->numInserted = bufferAfterOperation.getNumSamples();
+        if (!progress.setProgress(0.6))
+            return false;
+
+        // the new document, applying it only moves it in
+        AudioBufferUtils<float>::copyWithRegionReplaced(audioBuffer, bufferAfterOperation, startSample, result->numRemoved, result->document);
+        result->record = UndoRecord(std::move(bufferBeforeOperation), std::move(bufferAfterOperation), 0, startSample);
+        return progress.setProgress(1.0);
+    }, [this, result, startSample] {
+        auto numInserted = result->numInserted;
+        auto regionsBefore = regionList.getReshapedBy(startSample, result->numRemoved);
+        bufferWillChange();
+        audioBuffer = std::move(result->document);
+        bufferRegionChanged(startSample, result->numRemoved, numInserted);
+        result->record.setRegions(regionsBefore, regionList.getCurrent(regionsBefore));
+        undoStack.addRecord(std::move(result->record));
+
+        // select the result
+        markerStartPos = startSample;
+        markerEndPos = startSample + numInserted - 1;
+        currentPos = markerStartPos;
+        boundPositions();
+    }});
+}
+
+void AudioProcessingComponent::inplaceOperateMarkedRegion(const String& name, const std::function<void(float*, int, int)>& processFunc)
+{
+    inplaceOperate(name, processFunc, markerStartPos, markerEndPos-markerStartPos+1);
 }
 //-------------------------------TRANSPORT STATE HANDLING-------------------------------------
 AudioProcessingComponent::TransportState AudioProcessingComponent::getState ()
@@ -421,7 +1494,10 @@ void AudioProcessingComponent::setState (TransportState newState)
                 break;
                 
             case Starting:                          
-                prepareToPlay(512, sampleRate); // TODO: block size is hard coded here
+                // the device is already prepared, playback only starts from a clean resampler history
+                resamplerResetRequested = true;
+                if (playbackRate.load() < 0.f && currentPos <= markerStartPos)
+                    currentPos = markerEndPos;
                 state = Playing;
                 break;
                 
@@ -474,6 +1550,75 @@ void AudioProcessingComponent::setPositionInS(AudioProcessingComponent::Position
     }
 }
 
+void AudioProcessingComponent::setSnapToZeroCrossings(bool enabled)
+{
+    snapToZeroCrossings = enabled;
+}
+
+bool AudioProcessingComponent::isSnapToZeroCrossingsEnabled()
+{
+    return snapToZeroCrossings;
+}
+
+void AudioProcessingComponent::snapToZeroCrossing(AudioProcessingComponent::PositionType positionType, double maxDistanceInS)
+{
+    if (!snapToZeroCrossings || !fileLoaded)
+        return;
+
+    auto maxDistance = static_cast<int>(maxDistanceInS * sampleRate);
+    switch (positionType)
+    {
+        case Cursor:
+            currentPos = zeroCrossingIndex.snap(currentPos, maxDistance);
+            break;
+        case MarkerStart:
+            markerStartPos = zeroCrossingIndex.snap(markerStartPos, maxDistance);
+            break;
+        case MarkerEnd:
+            markerEndPos = zeroCrossingIndex.snap(markerEndPos, maxDistance);
+            break;
+    }
+}
+
+void AudioProcessingComponent::setSnapToOnsets(bool enabled)
+{
+    snapToOnsets = enabled;
+}
+
+bool AudioProcessingComponent::isSnapToOnsetsEnabled()
+{
+    return snapToOnsets;
+}
+
+void AudioProcessingComponent::snapToOnset(AudioProcessingComponent::PositionType positionType, double maxDistanceInS)
+{
+    if (!snapToOnsets || !fileLoaded)
+        return;
+
+    auto maxDistance = static_cast<int>(maxDistanceInS * sampleRate);
+    auto snap = [this, maxDistance](int position) {
+        auto onset = onsetIndex.getNearest(position, maxDistance);
+        return onset < 0 ? position : onset;
+    };
+    switch (positionType)
+    {
+        case Cursor:
+            currentPos = snap(currentPos);
+            break;
+        case MarkerStart:
+            markerStartPos = snap(markerStartPos);
+            break;
+        case MarkerEnd:
+            markerEndPos = snap(markerEndPos);
+            break;
+    }
+}
+
+Range<int> AudioProcessingComponent::getMarkedRegion()
+{
+    return {markerStartPos, markerEndPos + 1};
+}
+
 double AudioProcessingComponent::getPositionInS(AudioProcessingComponent::PositionType positionType)
 {
     switch (positionType)
@@ -498,35 +1643,34 @@ double AudioProcessingComponent::getLengthInS()
 //-----------------------------BUTTON PRESS HANDLING-------------------------------------------
 void AudioProcessingComponent::loadFile(File file)
 {
+    // the edits were meant for the old document
+    editQueue.cancelAll();
+    editQueue.waitUntilIdle(-1);
     shutdownAudio();
     auto* reader = formatManager.createReaderFor (file);
     if (reader != nullptr)
     {
-        // if there's a file has been loaded, clean the interpolators
-        if (fileLoaded)
-        {
-            for (int channel=0; channel<getNumChannels(); channel++)
-            {
-                delete interpolators[channel];
-            }
-            delete[] interpolators;
-            interpolators = nullptr;
-            fileLoaded = false;
-        }
+        fileLoaded = false;
 
         // read the entire audio into audioBuffer
         auto numSamples = reader->lengthInSamples;
         auto numChannels = reader->numChannels;
+        auto oldNumSamples = getNumSamples();
+        bufferWillChange();
         audioBuffer.setSize(numChannels, numSamples); // TODO: There's a precision losing warning
         reader->read(&audioBuffer, 0, numSamples, 0, true, true);
+        levelIndex.rebuild(audioBuffer);
+        zeroCrossingIndex.rebuild(audioBuffer);
 
         // set sample rate
         sampleRate = reader->sampleRate;
+        silenceIndex.setSampleRate(sampleRate);
+        silenceIndex.rebuild(levelIndex, audioBuffer.getNumSamples());
+        onsetIndex.rebuild(audioBuffer, sampleRate);
+        regionList.loadFromWavMetadata(reader->metadataValues);
 
-        // create interpolators
-        interpolators = new CatmullRomInterpolator*[numChannels];
-        for (int channel=0; channel<numChannels; channel++)
-            interpolators[channel] = new CatmullRomInterpolator();
+        // one resampler for all channels
+        resampler.prepare(numChannels);
 
         //initialize markers
         markerStartPos = 0;
@@ -536,30 +1680,43 @@ void AudioProcessingComponent::loadFile(File file)
         undoStack.reset();
         undoStack.setMaxUndoTimes(5); // TODO: let our user choose the number
 
-        audioBufferChanged.sendChangeMessage();
+        audioBufferChanged.addChange(0, oldNumSamples, audioBuffer.getNumSamples(), audioBuffer.getNumSamples());
         fileLoaded = true;
 
-        // set audio channels
-        setAudioChannels(0, 2); // TODO: enabling 2 channels is hard-coded here
+        // ask for an output per file channel, the router mixes down to whatever the device has
+        if (useAudioDevice)
+            setAudioChannels(0, jmax(2, static_cast<int>(numChannels)));
     }
 }
 
 void AudioProcessingComponent::saveFile(File file)
 {
-    // doesn't do anything if no file is loaded
-    if (!fileLoaded)
-        return;
-
-    WavAudioFormat format;
-    std::unique_ptr<AudioFormatWriter> writer;
-    writer.reset (format.createWriterFor (new FileOutputStream (file),
-                                          sampleRate,
-                                          audioBuffer.getNumChannels(),
-                                          24,
-                                          {},
-                                          0));
-    if (writer != nullptr)
-        writer->writeFromAudioSampleBuffer (audioBuffer, 0, audioBuffer.getNumSamples());
+    // the regions are edited on the message thread, so they are read there in
+    // their turn, then the file is written on the worker
+    auto metadata = std::make_shared<StringPairArray>();
+    editQueue.submit({"Save", nullptr, [this, metadata] {
+        // a broadcast wave chunk, and the regions as cue points
+        *metadata = WavAudioFormat::createBWAVMetadata ("KoolEdit", "KoolEdit", {}, Time::getCurrentTime(), 0, {});
+        regionList.addToWavMetadata (*metadata);
+    }});
+
+    editQueue.submit({"Save", [this, file, metadata](EditProgress& progress) {
+        // doesn't do anything if no file is loaded
+        if (!fileLoaded)
+            return false;
+
+        WavAudioFormat format;
+        std::unique_ptr<AudioFormatWriter> writer;
+        writer.reset (format.createWriterFor (new FileOutputStream (file),
+                                              sampleRate,
+                                              audioBuffer.getNumChannels(),
+                                              24,
+                                              *metadata,
+                                              0));
+        if (writer != nullptr)
+            writer->writeFromAudioSampleBuffer (audioBuffer, 0, audioBuffer.getNumSamples());
+        return progress.setProgress(1.0);
+    }, [] {}});
 }
 
 void AudioProcessingComponent::playRequested()
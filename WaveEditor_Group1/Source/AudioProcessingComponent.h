@@ -13,6 +13,23 @@
 #include <JuceHeader.h>
 #include "WaveAudio.h"
 #include "UndoStack.h"
+#include "BufferChange.h"
+#include "LevelIndex.h"
+#include "SilenceIndex.h"
+#include "ZeroCrossingIndex.h"
+#include "OnsetIndex.h"
+#include "SliceExporter.h"
+#include "RegionList.h"
+#include "MeterAudio.h"
+#include "CallbackProfiler.h"
+#include "Resampler.h"
+#include "SampleRateConverter.h"
+#include "ChannelRouter.h"
+#include "PlaybackReader.h"
+#include "TimeStretch.h"
+#include "EffectChain.h"
+#include "NoiseReduction.h"
+#include "EditCommandQueue.h"
 
 //==============================================================================
 /*
@@ -20,7 +37,10 @@
 class AudioProcessingComponent    : public AudioAppComponent
 {
 public:
-    AudioProcessingComponent();
+    /*! Without an audio device the component only edits, e.g. for the
+    \   headless benchmarks on machines that have no sound card
+    */
+    AudioProcessingComponent(bool useAudioDevice = true);
     ~AudioProcessingComponent();
 
     enum TransportState
@@ -141,6 +161,32 @@ public:
     */
     void setPositionInS(PositionType positionType, double position);
 
+    /*! Snapping moves new selections and the cursor to the nearest zero
+    \   crossing, so cuts don't land in the middle of the waveform and click
+    */
+    void setSnapToZeroCrossings(bool enabled);
+    bool isSnapToZeroCrossingsEnabled();
+
+    /*! Moves the cursor or a marker to the nearest zero crossing at most
+    \   maxDistanceInS away, does nothing while snapping is disabled
+    */
+    void snapToZeroCrossing(PositionType positionType, double maxDistanceInS);
+
+    /*! Snapping to onsets moves new selections and the cursor to the nearest
+    \   detected onset, so a selection starts on the attack of a note
+    */
+    void setSnapToOnsets(bool enabled);
+    bool isSnapToOnsetsEnabled();
+
+    /*! Moves the cursor or a marker to the nearest onset at most
+    \   maxDistanceInS away, does nothing while snapping to onsets is disabled
+    */
+    void snapToOnset(PositionType positionType, double maxDistanceInS);
+
+    /*! The samples between the markers, end exclusive
+    */
+    Range<int> getMarkedRegion();
+
     /*! Gets the cursor position or marker position in seconds
         @param PositionType the position type
     */
@@ -166,6 +212,202 @@ public:
     */
     void normalizeMarkedRegion();
 
+    /*! Returns the peak, RMS and DC of all channels in the marked region
+    */
+    LevelSummary getMarkedRegionLevels();
+
+    /*! Returns the peak, RMS and DC of one channel in the marked region
+    */
+    LevelSummary getMarkedRegionLevels(int channel);
+
+    /*! Applies the gain that brings the marked region to the target integrated loudness
+        @param float the target loudness in LUFS
+    */
+    void loudnessNormalizeMarkedRegion(float targetLoudness = -23.f);
+
+    /*! Filters the marked region through the bands in place, channel groups
+    \   run in parallel
+    */
+    void equalizeMarkedRegion(const std::vector<EqBand>& bands);
+
+    /*! Compresses or limits the marked region in place, the lookahead delay
+    \   is compensated
+    */
+    void applyDynamicsToMarkedRegion(const DynamicsSettings& settings);
+
+    /*! Linked true peak limiting with 5 ms lookahead
+        @param float the ceiling in dBTP
+    */
+    void limitMarkedRegion(float ceilingDb = -1.f);
+
+    /*! Learns the noise spectrum from the marked region, which should hold
+    \   noise only
+    */
+    void captureNoiseProfile();
+    bool hasNoiseProfile();
+
+    /*! Spectral subtraction of the captured noise profile from the marked region
+        @param float how far the noise is pushed down, in dB
+        @param float how many times the profile is subtracted
+    */
+    void reduceNoiseInMarkedRegion(float reductionDb, float sensitivity);
+
+    /*! Changes what counts as silence and rescans the silence index
+    */
+    void setSilenceSettings(const SilenceSettings& settings);
+    const SilenceSettings& getSilenceSettings();
+
+    /*! The silent spans of the marked region, from the silence index
+    */
+    std::vector<Range<int>> getMarkedRegionSilentSpans();
+
+    /*! Shortens every silent span of the marked region to keepMs, keeping
+    \   half of it on each side, as one edit with one undo record
+        @param float the silence left of each span in milliseconds, 0 removes it
+    */
+    void stripSilenceInMarkedRegion(float keepMs);
+
+    /*! Changes the onset detection settings and detects the file again
+    */
+    void setOnsetSettings(const OnsetSettings& settings);
+    const OnsetSettings& getOnsetSettings();
+
+    /*! The onsets found so far in [startSample, startSample+numSamples)
+    */
+    std::vector<int> getOnsets(int startSample, int numSamples);
+
+    /*! The marked region cut at every onset inside it
+    */
+    std::vector<Range<int>> getMarkedRegionOnsetSlices();
+
+    /*! Marks the audio from the onset at or before the cursor up to the next
+    \   onset, or to the end of the file
+    */
+    void selectOnsetSliceAtCursor();
+
+    /*! The marked region without its silent spans
+    */
+    std::vector<Range<int>> getMarkedRegionNonSilentSlices();
+
+    /*! Writes every slice to its own wave file in the background, returns
+    \   false if an export is still running. Editing the document cancels it.
+    */
+    bool exportSlices(const std::vector<Range<int>>& slices, const SliceExportSettings& settings);
+
+    /*! Progress and cancellation of the running slice export
+    */
+    SliceExporter& getSliceExporter();
+
+    /*! The named regions and markers of the document, saved as cue points
+    \   with the file. They move with the audio when it is edited.
+    */
+    const RegionList& getRegionList();
+
+    /*! Adds the marked region, or a marker at the cursor, with a numbered
+    \   name and returns its id
+    */
+    int addRegionFromMarkedRegion();
+    int addMarkerAtCursor();
+
+    void removeRegion(int id);
+    void renameRegion(int id, const String& name);
+
+    /*! The region whose edge is nearest to position, at most maxDistanceInS
+    \   away, or else the shortest region containing it. -1 if there is none.
+    */
+    int getRegionAt(double positionInS, double maxDistanceInS);
+
+    /*! Sets the markers to a region, or the cursor to a marker
+    */
+    void selectRegion(int id);
+
+    /*! Mutes, fades or normalizes every region, not the markers, as one edit
+    \   that is undone at once
+    */
+    void muteAllRegions();
+    void fadeInAllRegions();
+    void fadeOutAllRegions();
+    void normalizeAllRegions();
+
+    /*! Converts the whole document to a new sample rate, undoable
+        @param double the target sample rate
+    */
+    void convertSampleRate(double targetSampleRate);
+
+    /*! Measures the loudness of the whole file offline
+    */
+    LoudnessResult measureLoudness();
+
+    /*! Loudness of the audio being played, safe to call from the message thread
+    */
+    float getMomentaryLoudness();
+    float getShortTermLoudness();
+    float getIntegratedLoudness();
+    float getTruePeak();
+
+    /*! Peak and RMS meter of the audio being played
+    */
+    LevelMeter& getLevelMeter();
+
+    /*! Timing statistics of the audio callback
+    */
+    CallbackProfiler& getCallbackProfiler();
+
+    /*! Sets the interpolation used when the file and device sample rates differ,
+     * the audio thread picks it up at its next callback
+    */
+    void setResamplerQuality(PlaybackResampler::Quality quality);
+    PlaybackResampler::Quality getResamplerQuality();
+
+    /*! Length of the crossfade at the loop point in milliseconds, 0 for a plain wrap
+    */
+    void setLoopCrossfade(float milliseconds);
+    float getLoopCrossfade();
+
+    /*! Varispeed, the magnitude is limited to minPlaybackRate - maxPlaybackRate
+    \   and a negative rate plays backwards. The callback ramps to a new rate.
+    */
+    void setPlaybackRate(float rate);
+    float getPlaybackRate();
+
+    /*! Scrubbing drives the playback rate from the mouse: the playhead chases
+    \   the scrub position and slows down as it gets close, with or without the
+    \   transport running
+    */
+    void startScrubbing(double positionInS);
+    void scrubTo(double positionInS);
+    void stopScrubbing();
+    bool isScrubbing();
+
+    /*! Time stretch and pitch shift preview, played instead of the varispeed
+    \   rate while enabled. Stretch is the output length over the input length
+    \   (0.25 - 4), pitch is in semitones (-12 - 12).
+    */
+    void setTimeStretchPreview(bool enabled);
+    bool isTimeStretchPreviewEnabled();
+    void setTimeStretchParameters(float stretchFactor, float pitchSemitones);
+
+    /*! Renders the time stretch into the marked region, changes its length
+    */
+    void timeStretchMarkedRegion(float stretchFactor, float pitchSemitones);
+
+    /*! Non-destructive effects applied in the playback callback, edit them
+    \   from the message thread at any time
+    */
+    EffectChain& getEffectChain();
+
+    /*! Applies the effect chain to the marked region as one undoable edit,
+    \   then empties the chain
+    */
+    void renderEffectChainToMarkedRegion();
+
+    static constexpr float minPlaybackRate = 0.1f;
+    static constexpr float maxPlaybackRate = 4.f;
+
+    /*! Gain matrix from the file channels to the device outputs
+    */
+    ChannelRouter& getChannelRouter();
+
     /*! Adds gain to the audio in the marked region
         @param float the gain value
     */
@@ -205,8 +447,20 @@ public:
 
     bool isRedoEnabled();
 
+    /*! The edits waiting or running, for showing their progress and
+    \   cancelling them
+    */
+    EditCommandQueue& getEditQueue();
+
+    /*! Waits until the submitted edits are in the document, call on the
+    \   message thread. Returns false on time out.
+    */
+    bool waitForEdits(int timeOutMilliseconds = -1);
+
     ChangeBroadcaster transportState;
-    ChangeBroadcaster audioBufferChanged;
+    /*! Which samples the edits changed, merged once per message loop turn
+    */
+    BufferChangeBroadcaster audioBufferChanged;
     ChangeBroadcaster blockReady;
     ChangeBroadcaster audioCopied;
 
@@ -221,18 +475,113 @@ private:
     */
     void boundPositions();
 
-    void inplaceOperate(const std::function<void(float*, int, int)>&, int startSample, int numSamples);
-    void inplaceOperateMarkedRegion(const std::function<void(float*, int, int)>&);
+    /*! Updates everything derived from the audio buffer after numRemoved samples
+     * starting at startSample have been replaced by numInserted samples
+    */
+    void bufferRegionChanged(int startSample, int numRemoved, int numInserted);
+
+    /*! Updates everything derived from the audio buffer after the samples in
+     * the ranges were changed in place
+    */
+    void bufferRangesChanged(const std::vector<Range<int>>& ranges);
+
+    /*! Stops the background readers of the audio buffer, call before changing it
+    */
+    void bufferWillChange();
+
+    /*! Sets the sample rate of the document and updates the playback resampler
+    */
+    void setDocumentSampleRate(double newSampleRate);
+
+    /*! Moves regions taken before a sample rate change to the same time
+    */
+    void rescaleRegions(const std::vector<Region>& regions, double ratio);
+
+    /*! Submits the operation to the edit queue under the name shown while it
+    \   runs. The function is called on the worker thread with a copy of the
+    \   region, so it must not use the component.
+    */
+    void inplaceOperate(const String& name, const std::function<void(float*, int, int)>&, int startSample, int numSamples);
+    void inplaceOperateMarkedRegion(const String& name, const std::function<void(float*, int, int)>&);
+    void inplaceOperatePerChannel(const String& name, const std::function<void(int, float*, int, int)>&, int startSample, int numSamples);
+
+    /*! Like inplaceOperate for operations that need all channels at once, the
+    \   function gets a copy of the region of the document
+    */
+    void inplaceOperateRegion(const String& name, const std::function<void(AudioBuffer<float>&)>&, int startSample, int numSamples);
+
+    /*! Like inplaceOperateRegion for many ranges at once, with one undo record
+    \   and one change message. The ranges are processed in parallel, so the
+    \   function is called from several threads at the same time. Overlapping
+    \   ranges are processed one after the other, in the order of their starts.
+    */
+    void inplaceOperateRanges(const String& name, const std::function<void(AudioBuffer<float>&)>&, std::vector<Range<int>> ranges);
+
+    /*! The ranges of all regions that are not markers
+    */
+    std::vector<Range<int>> getRegionRanges();
+
+    /*! Like inplaceOperate for operations whose result has a different length,
+    \   the function fills the second buffer from the region in the first
+    */
+    void replaceOperate(const String& name, const std::function<void(const AudioBuffer<float>&, AudioBuffer<float>&)>&, int startSample, int numSamples);
+
+    /*! Fills the device block from the phase vocoder, returns the number of chunks
+    */
+    int renderTimeStretchPreview(const AudioSourceChannelInfo& bufferToFill, double sampleRateRatio, bool looping, int crossfadeLength);
+    void resetTimeStretchPreview();
 
     AudioFormatManager formatManager;
     TransportState state;
     bool fileLoaded;  // indicates if a file is loaded
-    CatmullRomInterpolator** interpolators;
+    PlaybackResampler resampler;
+    PlaybackReader playbackReader;
+    ChannelRouter channelRouter;
+    EffectChain effectChain;
+    NoiseProfile noiseProfile;
+    std::atomic<int> requestedResamplerQuality;
+    std::atomic<bool> resamplerResetRequested; // applied by the audio thread
+    std::atomic<float> loopCrossfadeMs;
+    std::atomic<float> playbackRate;     // target rate set by the user
+    float currentPlaybackRate;           // ramped rate, audio thread only
+    std::atomic<bool> scrubActive;
+    std::atomic<int> scrubTargetPos;
+    std::atomic<int> scrubStartPos;      // where a scrub from rest starts, -1 when taken
+    std::atomic<bool> timeStretchPreviewEnabled;
+    std::atomic<float> timeStretchFactor;
+    std::atomic<float> timeStretchSemitones;
+    // time stretch preview state, audio thread only
+    bool timeStretchPreviewActive;
+    int numStretchSamples;           // vocoder output waiting for the resampler
+    double timeStretchHopRemainder;
+    bool timeStretchInputFinished;
+    bool timeStretchFrameRead;       // the playhead only moves between frames
+    PhaseVocoder stretchVocoder;
+    AudioBuffer<float> stretchBuffer;
+    AudioBuffer<float> timeStretchFrame;
+    enum
+    {
+        rampStepSamples = 32
+    };
+    static constexpr double maxRateChangePerSecond = 20.0;
+    static constexpr double scrubResponseTime = 0.05;  // seconds to reach the scrub position at constant rate
     UndoStack undoStack;
+    LevelIndex levelIndex;
+    SilenceIndex silenceIndex;   // derived from the level index blocks
+    ZeroCrossingIndex zeroCrossingIndex;
+    OnsetIndex onsetIndex;
+    SliceExporter sliceExporter;
+    RegionList regionList;
+    LoudnessMeter loudnessMeter;
+    LevelMeter levelMeter;
+    CallbackProfiler callbackProfiler;
+    EditCommandQueue editQueue;  // every change to audioBuffer goes through it
 
     //// AudioBuffer
     // buffer definitions
     AudioBuffer<float> audioBlockBuffer;
+    AudioBuffer<float> resampledBuffer; // resampler output, one block
+    int maxBlockSize; // largest block the scratch buffers hold
     AudioBuffer<float> audioBuffer;
     AudioBuffer<float> audioCopyBuffer;
     // meta info
@@ -245,6 +594,9 @@ private:
 
     bool loopEnabled;
     bool mouseNormal;
+    bool snapToZeroCrossings;
+    bool snapToOnsets;
+    const bool useAudioDevice;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessingComponent)
 };
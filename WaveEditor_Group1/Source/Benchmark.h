@@ -0,0 +1,537 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+    Created: 19 Oct 2026 7:04:04am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioProcessingComponent.h"
+#include "Utils.h"
+#include "UndoStack.h"
+#include "Resampler.h"
+#include "SampleRateConverter.h"
+#include "TimeStretch.h"
+#include "Equalizer.h"
+#include "EffectChain.h"
+#include "NoiseReduction.h"
+#include "SilenceIndex.h"
+#include "ZeroCrossingIndex.h"
+#include "OnsetIndex.h"
+#include "SliceExporter.h"
+#include "RegionList.h"
+#include <iostream>
+
+/*! Performance benchmarks of the editing engine.
+\   Every case runs for each combination of file length and channel count and
+\   the results are written as JSON, one object per case:
+\   {"name", "channels", "samples", "iterations", "meanMs", "minMs", "maxMs", "samplesPerSecond"}
+\
+\   Run with:  KoolEdit --benchmark [--lengths=10,60] [--channels=1,2] [--output=results.json]
+\   The defaults are the ones shown and fit in a few hundred MB. Longer files
+\   or more channels, e.g. --lengths=600 --channels=8, need several GB.
+*/
+class KoolEditBenchmark
+{
+public:
+    KoolEditBenchmark(double sampleRate = 48000.0):
+    sampleRate(sampleRate),
+    minTimeInS(0.2),
+    minIterations(3),
+    maxIterations(100)
+    {
+        lengthsInS.add(10);
+        lengthsInS.add(60);
+        channelCounts.add(1);
+        channelCounts.add(2);
+    }
+    ~KoolEditBenchmark(){}
+
+    struct Result
+    {
+        String name;
+        int numChannels;
+        int numSamples;
+        int numIterations;
+        double meanMs;
+        double minMs;
+        double maxMs;
+    };
+
+    /*! Parses --lengths, --channels and --output from the command line
+    */
+    void parseCommandLine(const String& commandLine)
+    {
+        auto arguments = StringArray::fromTokens(commandLine, true);
+        for (auto& argument : arguments)
+        {
+            auto value = argument.fromFirstOccurrenceOf("=", false, false).unquoted();
+            if (argument.startsWith("--lengths="))
+                lengthsInS = parseList(value);
+            else if (argument.startsWith("--channels="))
+                channelCounts = parseList(value);
+            else if (argument.startsWith("--output="))
+                outputFile = File::getCurrentWorkingDirectory().getChildFile(value);
+        }
+    }
+
+    void runAll()
+    {
+        results.clear();
+        for (auto numChannels : channelCounts)
+        {
+            for (auto lengthInS : lengthsInS)
+            {
+                auto numSamples = static_cast<int>(lengthInS * sampleRate);
+                log("channels: " + String(numChannels) + ", length: " + String(lengthInS) + " s");
+                fillTestSignal(numChannels, numSamples);
+
+                runBufferUtilsBenchmarks();
+                runProcessingUtilsBenchmarks();
+                runUndoStackBenchmarks();
+                runResamplerBenchmarks();
+                runSampleRateConverterBenchmarks();
+                runTimeStretchBenchmarks();
+                runEqualizerBenchmarks();
+                runDynamicsBenchmarks();
+                runNoiseReductionBenchmarks();
+                runSilenceBenchmarks();
+                runZeroCrossingBenchmarks();
+                runOnsetBenchmarks();
+                runRegionBenchmarks();
+                runFileBenchmarks();
+                runThumbnailBenchmarks();
+            }
+        }
+        testBuffer.setSize(0, 0);
+        workBuffer.setSize(0, 0);
+    }
+
+    /*! Times operation, calling setup (untimed) before every iteration
+    */
+    void measure(const String& name, const std::function<void()>& setup, const std::function<void()>& operation)
+    {
+        Result result {name, testBuffer.getNumChannels(), testBuffer.getNumSamples(), 0, 0.0, 0.0, 0.0};
+        double totalTime = 0.0;
+        while (result.numIterations < maxIterations
+               && (result.numIterations < minIterations || totalTime < minTimeInS))
+        {
+            if (setup)
+                setup();
+            auto startTicks = Time::getHighResolutionTicks();
+            operation();
+            auto elapsed = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+
+            result.minMs = result.numIterations == 0 ? elapsed * 1000.0 : jmin(result.minMs, elapsed * 1000.0);
+            result.maxMs = jmax(result.maxMs, elapsed * 1000.0);
+            totalTime += elapsed;
+            result.numIterations++;
+        }
+        result.meanMs = totalTime * 1000.0 / result.numIterations;
+        results.add(result);
+        log("    " + name.paddedRight(' ', 28) + String(result.meanMs, 3) + " ms");
+    }
+
+    String getResultsAsJSON() const
+    {
+        Array<var> list;
+        for (auto& result : results)
+        {
+            DynamicObject::Ptr object = new DynamicObject();
+            object->setProperty("name", result.name);
+            object->setProperty("channels", result.numChannels);
+            object->setProperty("samples", result.numSamples);
+            object->setProperty("iterations", result.numIterations);
+            object->setProperty("meanMs", result.meanMs);
+            object->setProperty("minMs", result.minMs);
+            object->setProperty("maxMs", result.maxMs);
+            object->setProperty("samplesPerSecond", result.meanMs > 0.0
+                                ? result.numSamples * result.numChannels / (result.meanMs / 1000.0) : 0.0);
+            list.add(var(object.get()));
+        }
+        return JSON::toString(var(list));
+    }
+
+    /*! Writes the results to the --output file, or to stdout if none was given
+    */
+    void writeResults() const
+    {
+        auto json = getResultsAsJSON();
+        if (outputFile == File())
+            std::cout << json << std::endl;
+        else
+            outputFile.replaceWithText(json);
+    }
+
+    const Array<Result>& getResults() const
+    {
+        return results;
+    }
+
+private:
+    static Array<int> parseList(const String& value)
+    {
+        Array<int> list;
+        for (auto& token : StringArray::fromTokens(value, ",", ""))
+            if (token.getIntValue() > 0)
+                list.add(token.getIntValue());
+        return list;
+    }
+
+    void log(const String& message) const
+    {
+        std::cerr << message << std::endl;
+    }
+
+    /*! Sine sweep with some noise, so the results don't depend on silent data
+    */
+    void fillTestSignal(int numChannels, int numSamples)
+    {
+        Random random (1234);
+        testBuffer.setSize(numChannels, numSamples);
+        for (int channel=0; channel<numChannels; channel++)
+        {
+            auto writePointer = testBuffer.getWritePointer(channel);
+            auto phase = 0.0;
+            for (int i=0; i<numSamples; i++)
+            {
+                phase += MathConstants<double>::twoPi * (100.0 + 5000.0 * i / numSamples) / sampleRate;
+                writePointer[i] = static_cast<float>(0.5 * std::sin(phase)) + 0.01f * (random.nextFloat() - 0.5f);
+            }
+        }
+    }
+
+    void resetWorkBuffer()
+    {
+        workBuffer.makeCopyOf(testBuffer, true);
+    }
+
+    void runBufferUtilsBenchmarks()
+    {
+        // edits of a tenth of the file in the middle, like a typical cut or paste
+        auto regionStart = testBuffer.getNumSamples() / 2;
+        auto regionLength = testBuffer.getNumSamples() / 10;
+        AudioBuffer<float> regionBuffer (testBuffer.getNumChannels(), regionLength);
+        for (int channel=0; channel<testBuffer.getNumChannels(); channel++)
+            regionBuffer.copyFrom(channel, 0, testBuffer, channel, 0, regionLength);
+
+        measure("deleteRegion", [this] { resetWorkBuffer(); }, [this, regionStart, regionLength] {
+            AudioBufferUtils<float>::deleteRegion(workBuffer, regionStart, regionLength);
+        });
+        measure("insertRegion", [this] { resetWorkBuffer(); }, [this, &regionBuffer, regionStart] {
+            AudioBufferUtils<float>::insertRegion(workBuffer, regionBuffer, regionStart);
+        });
+        measure("replaceRegion", [this] { resetWorkBuffer(); }, [this, &regionBuffer, regionStart, regionLength] {
+            AudioBufferUtils<float>::replaceRegion(workBuffer, regionBuffer, regionStart, regionLength);
+        });
+    }
+
+    void measureKernel(const String& name, const std::function<void(float*, int, int)>& kernel)
+    {
+        measure(name, [this] { resetWorkBuffer(); }, [this, &kernel] {
+            for (int channel=0; channel<workBuffer.getNumChannels(); channel++)
+                kernel(workBuffer.getWritePointer(channel), 0, workBuffer.getNumSamples());
+        });
+    }
+
+    void runProcessingUtilsBenchmarks()
+    {
+        measureKernel("mute", AudioProcessingUtils::mute);
+        measureKernel("fadeIn", AudioProcessingUtils::fadeIn);
+        measureKernel("fadeOut", AudioProcessingUtils::fadeOut);
+        measureKernel("gain", AudioProcessingUtils::getGainFunc(0.5f));
+        measureKernel("normalize", [](float* writePointer, int startSample, int numSamples) {
+            AudioProcessingUtils::normalize(writePointer, startSample, numSamples);
+        });
+    }
+
+    void runUndoStackBenchmarks()
+    {
+        auto regionStart = testBuffer.getNumSamples() / 2;
+        auto regionLength = testBuffer.getNumSamples() / 10;
+        AudioBuffer<float> beforeBuffer (testBuffer.getNumChannels(), regionLength);
+        AudioBuffer<float> afterBuffer (testBuffer.getNumChannels(), regionLength);
+        for (int channel=0; channel<testBuffer.getNumChannels(); channel++)
+        {
+            beforeBuffer.copyFrom(channel, 0, testBuffer, channel, regionStart, regionLength);
+            afterBuffer.copyFrom(channel, 0, testBuffer, channel, regionStart, regionLength);
+        }
+        afterBuffer.applyGain(0.5f);
+
+        UndoStack undoStack;
+        measure("UndoStack::addRecord", [&undoStack] { undoStack.reset(); undoStack.setMaxUndoTimes(5); }, [&] {
+            undoStack.addRecord(UndoRecord(beforeBuffer, afterBuffer, 0, regionStart));
+        });
+
+        int startSample = 0;
+        int numSamples = 0;
+        measure("UndoStack::undo", [&] {
+            resetWorkBuffer();
+            undoStack.reset();
+            undoStack.setMaxUndoTimes(5);
+            undoStack.addRecord(UndoRecord(beforeBuffer, afterBuffer, 0, regionStart));
+        }, [&] {
+            undoStack.undo(workBuffer, startSample, numSamples);
+        });
+        measure("UndoStack::redo", [&] {
+            resetWorkBuffer();
+            undoStack.reset();
+            undoStack.setMaxUndoTimes(5);
+            undoStack.addRecord(UndoRecord(beforeBuffer, afterBuffer, 0, regionStart));
+            undoStack.undo(workBuffer, startSample, numSamples);
+        }, [&] {
+            undoStack.redo(workBuffer, startSample, numSamples);
+        });
+    }
+
+    /*! 44.1k to 48k playback of the whole buffer in 512 sample blocks
+    */
+    void runResamplerBenchmarks()
+    {
+        AudioBuffer<float> outputBuffer (testBuffer.getNumChannels(), 512);
+        for (auto quality : {PlaybackResampler::Linear, PlaybackResampler::CatmullRom, PlaybackResampler::WindowedSinc})
+        {
+            PlaybackResampler resampler;
+            resampler.prepare(testBuffer.getNumChannels());
+            resampler.setQuality(quality);
+            resampler.setSpeedRatio(44100.0 / 48000.0);
+
+            String names[] = {"resample linear", "resample catmull-rom", "resample sinc"};
+            measure(names[quality], [&resampler] { resampler.reset(); }, [&] {
+                int position = 0;
+                while (position < testBuffer.getNumSamples())
+                    position += resampler.process(44100.0 / 48000.0, testBuffer, position, testBuffer.getNumSamples() - position,
+                                                  outputBuffer, 0, outputBuffer.getNumSamples());
+            });
+        }
+    }
+
+    void runSampleRateConverterBenchmarks()
+    {
+        AudioBuffer<float> convertedBuffer;
+        measure("convert 48k to 44.1k", {}, [&] {
+            SampleRateConverter::process(testBuffer, 48000.0, 44100.0, convertedBuffer);
+        });
+    }
+
+    void runTimeStretchBenchmarks()
+    {
+        AudioBuffer<float> stretchedBuffer;
+        measure("time stretch 1.5x", {}, [&] {
+            TimeStretcher::process(testBuffer, 1.5, 1.0, stretchedBuffer);
+        });
+        measure("pitch shift +7 semitones", {}, [&] {
+            TimeStretcher::process(testBuffer, 1.0, std::pow(2.0, 7.0 / 12.0), stretchedBuffer);
+        });
+    }
+
+    void runEqualizerBenchmarks()
+    {
+        std::vector<EqBand> bands {{EqBand::HighPass, 40.0, 0.0, 0.7071},
+                                   {EqBand::LowShelf, 120.0, 3.0, 0.7071},
+                                   {EqBand::Peak, 800.0, -4.0, 1.5},
+                                   {EqBand::Peak, 3000.0, 2.0, 0.8},
+                                   {EqBand::HighShelf, 9000.0, -3.0, 0.7071},
+                                   {EqBand::LowPass, 18000.0, 0.0, 0.7071}};
+        measure("parametric EQ 6 bands", [this] { resetWorkBuffer(); }, [&] {
+            ParametricEqualizer::process(workBuffer, sampleRate, bands);
+        });
+    }
+
+    void runDynamicsBenchmarks()
+    {
+        DynamicsSettings compressor;
+        compressor.thresholdDb = -20.f;
+        measure("compressor linked", [this] { resetWorkBuffer(); }, [&] {
+            DynamicsProcessor::process(workBuffer, sampleRate, compressor);
+        });
+        compressor.linked = false;
+        measure("compressor unlinked", [this] { resetWorkBuffer(); }, [&] {
+            DynamicsProcessor::process(workBuffer, sampleRate, compressor);
+        });
+        measure("true peak limiter", [this] { resetWorkBuffer(); }, [&] {
+            DynamicsProcessor::process(workBuffer, sampleRate, LimiterEffect::makeSettings(-6.f, 100.f, 5.f));
+        });
+    }
+
+    void runNoiseReductionBenchmarks()
+    {
+        NoiseProfile profile;
+        AudioBuffer<float> noiseBuffer (testBuffer.getArrayOfWritePointers(), testBuffer.getNumChannels(),
+                                        jmin(testBuffer.getNumSamples(), static_cast<int>(sampleRate)));
+        profile.capture(noiseBuffer);
+        measure("spectral noise reduction", [this] { resetWorkBuffer(); }, [&] {
+            SpectralNoiseReducer::process(testBuffer, workBuffer, profile, 12.f, 1.5f);
+        });
+    }
+
+    void runSilenceBenchmarks()
+    {
+        LevelIndex levelIndex;
+        SilenceIndex silenceIndex;
+        silenceIndex.setSampleRate(sampleRate);
+        measure("level index rebuild", {}, [&] {
+            levelIndex.rebuild(testBuffer);
+        });
+        measure("silence index rebuild", {}, [&] {
+            silenceIndex.rebuild(levelIndex, testBuffer.getNumSamples());
+        });
+
+        // a hundred evenly spread cuts, in one pass against one delete per cut
+        std::vector<Range<int>> cuts;
+        auto spacing = testBuffer.getNumSamples() / 100;
+        for (int i=0; i<100; i++)
+            cuts.push_back(Range<int>::withStartAndLength(i * spacing, spacing / 10));
+        measure("deleteRegions 100 cuts", [this] { resetWorkBuffer(); }, [&] {
+            AudioBufferUtils<float>::deleteRegions(workBuffer, cuts);
+        });
+        measure("deleteRegion 100 cuts", [this] { resetWorkBuffer(); }, [&] {
+            for (auto cut=cuts.rbegin(); cut!=cuts.rend(); cut++)
+                AudioBufferUtils<float>::deleteRegion(workBuffer, cut->getStart(), cut->getLength());
+        });
+    }
+
+    void runZeroCrossingBenchmarks()
+    {
+        ZeroCrossingIndex zeroCrossingIndex;
+        measure("zero crossing index build", {}, [&] {
+            zeroCrossingIndex.rebuild(testBuffer);
+            zeroCrossingIndex.waitUntilBuilt(-1);
+        });
+        // a selection at full file zoom snaps within one pixel of a 1000 pixel view
+        auto maxDistance = testBuffer.getNumSamples() / 1000;
+        measure("zero crossing snap x10000", {}, [&] {
+            for (int i=0; i<10000; i++)
+                zeroCrossingIndex.snap(static_cast<int>((i * static_cast<int64>(7919)) % testBuffer.getNumSamples()), maxDistance);
+        });
+    }
+
+    void runOnsetBenchmarks()
+    {
+        OnsetIndex onsetIndex;
+        measure("onset index build", {}, [&] {
+            onsetIndex.rebuild(testBuffer, sampleRate);
+            onsetIndex.waitUntilBuilt(-1);
+        });
+        // an in-place edit of one second only detects that second and its context again
+        measure("onset index update 1 s", {}, [&] {
+            onsetIndex.update(testBuffer.getNumSamples() / 2, static_cast<int>(sampleRate), static_cast<int>(sampleRate), sampleRate);
+            onsetIndex.waitUntilBuilt(-1);
+        });
+    }
+
+    void runRegionBenchmarks()
+    {
+        // one marker every 10 ms, edited and queried like the view does
+        RegionList regionList;
+        auto spacing = static_cast<int>(sampleRate / 100);
+        for (int position=0; position<testBuffer.getNumSamples(); position+=spacing)
+            regionList.add("Marker", {position, position});
+        Random random (1);
+        measure("region shift x1000", {}, [&] {
+            for (int i=0; i<1000; i++)
+                regionList.update(random.nextInt(testBuffer.getNumSamples()), 0, 100);
+        });
+        measure("region hit test x1000", {}, [&] {
+            for (int i=0; i<1000; i++)
+                regionList.hitTest(random.nextInt(testBuffer.getNumSamples()), spacing / 4);
+        });
+    }
+
+    void runFileBenchmarks()
+    {
+        TemporaryFile sourceFile (".wav");
+        TemporaryFile savedFile (".wav");
+        {
+            WavAudioFormat format;
+            std::unique_ptr<AudioFormatWriter> writer (format.createWriterFor(new FileOutputStream(sourceFile.getFile()),
+                                                                              sampleRate, testBuffer.getNumChannels(), 24, {}, 0));
+            if (writer == nullptr)
+                return;
+            writer->writeFromAudioSampleBuffer(testBuffer, 0, testBuffer.getNumSamples());
+        }
+
+        // no audio device, so loadFile times the decode and the index builds only
+        AudioProcessingComponent apc (false);
+        measure("loadFile", {}, [&] {
+            apc.loadFile(sourceFile.getFile());
+        });
+        measure("saveFile", [&] { savedFile.getFile().deleteFile(); }, [&] {
+            apc.saveFile(savedFile.getFile());
+            apc.waitForEdits();
+        });
+
+        // 500 regions processed as one edit, and one edit per region, both
+        // timed until the edit queue has put them into the document
+        auto lengthInS = static_cast<double>(testBuffer.getNumSamples()) / sampleRate;
+        for (int i=0; i<500; i++)
+        {
+            apc.setPositionInS(AudioProcessingComponent::MarkerStart, lengthInS * i / 500);
+            apc.setPositionInS(AudioProcessingComponent::MarkerEnd, lengthInS * (i + 0.5) / 500);
+            apc.addRegionFromMarkedRegion();
+        }
+        measure("normalize 500 regions", {}, [&] {
+            apc.normalizeAllRegions();
+            apc.waitForEdits();
+        });
+        measure("normalize regions one by one", {}, [&] {
+            for (auto& region : apc.getRegionList().getAll())
+            {
+                apc.selectRegion(region.id);
+                apc.normalizeMarkedRegion();
+            }
+            apc.waitForEdits();
+        });
+
+        // 2000 slices of the whole buffer, one file each
+        std::vector<Range<int>> slices;
+        for (int i=0; i<2000; i++)
+            slices.push_back({static_cast<int>(static_cast<int64>(i) * testBuffer.getNumSamples() / 2000),
+                              static_cast<int>(static_cast<int64>(i + 1) * testBuffer.getNumSamples() / 2000)});
+        SliceExporter exporter;
+        SliceExportSettings settings;
+        settings.directory = File::createTempFile("slices");
+        measure("export 2000 slices", [&] { settings.directory.deleteRecursively(); }, [&] {
+            exporter.start(testBuffer, sampleRate, slices, settings);
+            exporter.waitUntilFinished(-1);
+        });
+        settings.directory.deleteRecursively();
+    }
+
+    void runThumbnailBenchmarks()
+    {
+        AudioFormatManager formatManager;
+        AudioThumbnailCache thumbnailCache (5);
+        AudioThumbnail thumbnail (512, formatManager, thumbnailCache);
+
+        // the same calls WaveVisualizer makes when the buffer changes
+        measure("thumbnail rebuild", {}, [&] {
+            thumbnail.reset(testBuffer.getNumChannels(), sampleRate, testBuffer.getNumSamples());
+            thumbnail.addBlock(0, testBuffer, 0, testBuffer.getNumSamples());
+        });
+        // what it does after an in-place edit of one second
+        auto editStart = testBuffer.getNumSamples() / 2 / 512 * 512;
+        auto editLength = jmin(static_cast<int>(sampleRate), testBuffer.getNumSamples() - editStart);
+        measure("thumbnail update 1 s", {}, [&] {
+            thumbnail.addBlock(editStart, testBuffer, editStart, editLength);
+        });
+    }
+
+    double sampleRate;
+    double minTimeInS;
+    int minIterations;
+    int maxIterations;
+
+    Array<int> lengthsInS;
+    Array<int> channelCounts;
+    File outputFile;
+
+    AudioBuffer<float> testBuffer;
+    AudioBuffer<float> workBuffer;
+    Array<Result> results;
+};
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    BufferChange.h
+    Created: 19 Oct 2026 7:58:12am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*! What changed in the audio buffer since the last notification. The samples
+\   in range differ from before. When the length changed, range reaches the
+\   end of the buffer because everything after the edit has moved.
+*/
+struct BufferChange
+{
+    Range<int> range;
+    bool lengthChanged = false;
+    int64 version = 0;      // the number of edits so far, the last one included
+    int numEdits = 0;       // the edits merged into this change
+};
+
+/*! Tells listeners on the message thread which part of the audio buffer
+\   changed. Edits made before the message thread gets to the notification
+\   are merged into one change, so a listener redraws or rescans once per
+\   message loop turn however many edits there were.
+\
+\   It is also a ChangeBroadcaster for listeners that only need to know that
+\   something changed, e.g. to update the undo buttons.
+*/
+class BufferChangeBroadcaster : public ChangeBroadcaster,
+                                private AsyncUpdater
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+        virtual void bufferChanged(const BufferChange& change) = 0;
+    };
+
+    BufferChangeBroadcaster():
+    version(0)
+    {
+    }
+
+    ~BufferChangeBroadcaster()
+    {
+        cancelPendingUpdate();
+    }
+
+    void addListener(Listener* listener)
+    {
+        listeners.add(listener);
+    }
+
+    void removeListener(Listener* listener)
+    {
+        listeners.remove(listener);
+    }
+
+    /*! Records an edit that replaced numRemoved samples at startSample with
+    \   numInserted samples, leaving numSamples in the buffer. Can be called
+    \   from any thread.
+    */
+    void addChange(int startSample, int numRemoved, int numInserted, int numSamples)
+    {
+        auto lengthChanged = numRemoved != numInserted;
+        Range<int> range (startSample, lengthChanged ? numSamples : startSample + numInserted);
+        {
+            const ScopedLock sl (lock);
+            version++;
+            if (pending.numEdits == 0)
+                pending.range = range;
+            else
+                pending.range = pending.range.getUnionWith(range);
+            // a later edit may have shortened the buffer
+            pending.range = pending.range.getIntersectionWith({0, numSamples});
+            pending.lengthChanged = pending.lengthChanged || lengthChanged;
+            pending.version = version;
+            pending.numEdits++;
+        }
+        triggerAsyncUpdate();
+    }
+
+    /*! The version of the last recorded edit, which listeners may not have
+    \   been told about yet
+    */
+    int64 getVersion() const
+    {
+        const ScopedLock sl (lock);
+        return version;
+    }
+
+    /*! Tells the listeners now instead of waiting for the message loop, call
+    \   on the message thread
+    */
+    void dispatchPendingChange()
+    {
+        handleUpdateNowIfNeeded();
+    }
+
+private:
+    void handleAsyncUpdate() override
+    {
+        BufferChange change;
+        {
+            const ScopedLock sl (lock);
+            change = pending;
+            pending = BufferChange();
+        }
+        if (change.numEdits == 0)
+            return;
+
+        listeners.call([&change](Listener& listener) { listener.bufferChanged(change); });
+        sendSynchronousChangeMessage();
+    }
+
+    CriticalSection lock;       // guards pending and version
+    BufferChange pending;
+    int64 version;
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_NON_COPYABLE (BufferChangeBroadcaster)
+};
@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+    CallbackProfiler.h
+    Created: 19 Oct 2026 7:05:12am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*! Timing statistics of the audio callback.
+\   The audio thread is the only writer, every value is an atomic so the
+\   diagnostics panel can read them at any time without locking. A callback is
+\   an overrun when it takes longer than the audio it produces, and late when
+\   it starts more than one and a half buffer periods after the previous one.
+*/
+class CallbackProfiler
+{
+public:
+    enum
+    {
+        numHistogramBins = 41, // load in 5% steps, the last bin collects everything above 200%
+        histogramBinWidthPercent = 5
+    };
+
+    CallbackProfiler():
+    sampleRate(0.0),
+    lastCallbackTicks(0)
+    {
+        clear();
+    }
+
+    /*! Called from prepareToPlay
+    */
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        lastCallbackTicks = 0;
+    }
+
+    /*! Asks the audio thread to clear the statistics at its next callback
+    */
+    void reset()
+    {
+        resetRequested.store(true);
+    }
+
+    /*! Called at the start of the callback, returns the start time
+    */
+    int64 callbackStarted(int numSamples)
+    {
+        auto startTicks = Time::getHighResolutionTicks();
+        if (resetRequested.exchange(false))
+        {
+            clear();
+            lastCallbackTicks = 0;
+        }
+
+        if (lastCallbackTicks != 0 && sampleRate > 0.0)
+        {
+            auto interval = Time::highResolutionTicksToSeconds(startTicks - lastCallbackTicks);
+            if (interval > 1.5 * numSamples / sampleRate)
+                numLateCallbacks.store(numLateCallbacks.load() + 1);
+        }
+        lastCallbackTicks = startTicks;
+        return startTicks;
+    }
+
+    /*! Called at the end of the callback
+        @param int64 the value returned by callbackStarted
+        @param int the number of samples produced
+        @param int the number of iterations of the resampling loop
+    */
+    void callbackFinished(int64 startTicks, int numSamples, int numLoopIterations)
+    {
+        if (sampleRate <= 0.0 || numSamples <= 0)
+            return;
+
+        auto duration = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+        auto deadline = numSamples / sampleRate;
+        auto load = static_cast<float>(duration / deadline);
+
+        auto bin = jmin(static_cast<int>(numHistogramBins) - 1,
+                        static_cast<int>(load * 100.f) / static_cast<int>(histogramBinWidthPercent));
+        histogram[bin].store(histogram[bin].load() + 1);
+
+        numCallbacks.store(numCallbacks.load() + 1);
+        if (load > 1.f)
+            numOverruns.store(numOverruns.load() + 1);
+
+        lastDuration.store(static_cast<float>(duration));
+        lastDeadline.store(static_cast<float>(deadline));
+        maxDuration.store(jmax(maxDuration.load(), static_cast<float>(duration)));
+        maxLoad.store(jmax(maxLoad.load(), load));
+        totalLoad.store(totalLoad.load() + load);
+
+        totalLoopIterations.store(totalLoopIterations.load() + static_cast<uint64>(numLoopIterations));
+        maxLoopIterations.store(jmax(maxLoopIterations.load(), numLoopIterations));
+    }
+
+    uint64 getNumCallbacks() const          { return numCallbacks.load(); }
+    uint64 getNumOverruns() const           { return numOverruns.load(); }
+    uint64 getNumLateCallbacks() const      { return numLateCallbacks.load(); }
+    uint64 getTotalLoopIterations() const   { return totalLoopIterations.load(); }
+    int getMaxLoopIterations() const        { return maxLoopIterations.load(); }
+    float getLastDuration() const           { return lastDuration.load(); }
+    float getLastDeadline() const           { return lastDeadline.load(); }
+    float getMaxDuration() const            { return maxDuration.load(); }
+    float getMaxLoad() const                { return maxLoad.load(); }
+
+    float getAverageLoad() const
+    {
+        auto callbacks = getNumCallbacks();
+        return callbacks == 0 ? 0.f : static_cast<float>(totalLoad.load() / callbacks);
+    }
+
+    double getAverageLoopIterations() const
+    {
+        auto callbacks = getNumCallbacks();
+        return callbacks == 0 ? 0.0 : static_cast<double>(getTotalLoopIterations()) / callbacks;
+    }
+
+    uint64 getHistogramBin(int bin) const
+    {
+        return histogram[bin].load();
+    }
+
+    /*! Returns the statistics as text, the histogram as "load%: count" lines
+    */
+    String getReport() const
+    {
+        String report;
+        report << "callbacks: " << String(static_cast<int64>(getNumCallbacks())) << newLine
+               << "overruns: " << String(static_cast<int64>(getNumOverruns())) << newLine
+               << "late callbacks: " << String(static_cast<int64>(getNumLateCallbacks())) << newLine
+               << "sample rate: " << String(sampleRate) << newLine
+               << "last duration ms: " << String(getLastDuration() * 1000.f, 3) << newLine
+               << "deadline ms: " << String(getLastDeadline() * 1000.f, 3) << newLine
+               << "max duration ms: " << String(getMaxDuration() * 1000.f, 3) << newLine
+               << "average load %: " << String(getAverageLoad() * 100.f, 1) << newLine
+               << "max load %: " << String(getMaxLoad() * 100.f, 1) << newLine
+               << "resampling loop iterations per callback: " << String(getAverageLoopIterations(), 2)
+               << " (max " << getMaxLoopIterations() << ")" << newLine
+               << "load histogram" << newLine;
+        for (int bin=0; bin<numHistogramBins; bin++)
+        {
+            report << String(bin * histogramBinWidthPercent) << (bin == numHistogramBins - 1 ? "+%: " : "%: ")
+                   << String(static_cast<int64>(getHistogramBin(bin))) << newLine;
+        }
+        return report;
+    }
+
+    bool dumpToFile(const File& file) const
+    {
+        return file.replaceWithText(getReport());
+    }
+
+private:
+    void clear()
+    {
+        for (auto& bin : histogram)
+            bin.store(0);
+        numCallbacks.store(0);
+        numOverruns.store(0);
+        numLateCallbacks.store(0);
+        totalLoopIterations.store(0);
+        maxLoopIterations.store(0);
+        lastDuration.store(0.f);
+        lastDeadline.store(0.f);
+        maxDuration.store(0.f);
+        maxLoad.store(0.f);
+        totalLoad.store(0.0);
+    }
+
+    double sampleRate;
+    int64 lastCallbackTicks; // only touched by the audio thread
+
+    std::atomic<bool> resetRequested {false};
+    std::atomic<uint64> histogram[numHistogramBins];
+    std::atomic<uint64> numCallbacks;
+    std::atomic<uint64> numOverruns;
+    std::atomic<uint64> numLateCallbacks;
+    std::atomic<uint64> totalLoopIterations;
+    std::atomic<int> maxLoopIterations;
+    std::atomic<float> lastDuration;
+    std::atomic<float> lastDeadline;
+    std::atomic<float> maxDuration;
+    std::atomic<float> maxLoad;
+    std::atomic<double> totalLoad;
+
+    JUCE_DECLARE_NON_COPYABLE (CallbackProfiler)
+};
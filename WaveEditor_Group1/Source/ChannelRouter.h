@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    ChannelRouter.h
+    Created: 19 Oct 2026 7:11:12am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*! Gain matrix from the file channels to the device channels.
+\   Every output is built with one vectorized multiply-add per input with a
+\   non-zero gain. The message thread edits a pending copy of the matrix which
+\   the audio thread picks up with a try-lock, so the callback never waits.
+*/
+class ChannelRouter
+{
+public:
+    ChannelRouter():
+    numInputs(0),
+    numOutputs(0),
+    pendingChanged(false)
+    {
+    }
+    ~ChannelRouter(){}
+
+    /*! Allocates the matrix and sets the default routing, not real-time safe
+    */
+    void prepare(int newNumInputs, int newNumOutputs)
+    {
+        const SpinLock::ScopedLockType lock (pendingLock);
+        numInputs = newNumInputs;
+        numOutputs = newNumOutputs;
+        gains.assign(static_cast<size_t>(numInputs * numOutputs), 0.f);
+        pendingGains = gains;
+        for (int output=0; output<numOutputs; output++)
+            for (int input=0; input<numInputs; input++)
+                pendingGains[static_cast<size_t>(output * numInputs + input)] = getDefaultGain(numInputs, numOutputs, input, output);
+        gains = pendingGains;
+        pendingChanged.store(false);
+    }
+
+    int getNumInputs() const
+    {
+        return numInputs;
+    }
+
+    int getNumOutputs() const
+    {
+        return numOutputs;
+    }
+
+    void setGain(int output, int input, float gain)
+    {
+        const SpinLock::ScopedLockType lock (pendingLock);
+        if (output < numOutputs && input < numInputs)
+        {
+            pendingGains[static_cast<size_t>(output * numInputs + input)] = gain;
+            pendingChanged.store(true);
+        }
+    }
+
+    float getGain(int output, int input)
+    {
+        const SpinLock::ScopedLockType lock (pendingLock);
+        if (output < numOutputs && input < numInputs)
+            return pendingGains[static_cast<size_t>(output * numInputs + input)];
+        return 0.f;
+    }
+
+    /*! Restores the default routing for the current channel counts
+    */
+    void resetToDefault()
+    {
+        const SpinLock::ScopedLockType lock (pendingLock);
+        for (int output=0; output<numOutputs; output++)
+            for (int input=0; input<numInputs; input++)
+                pendingGains[static_cast<size_t>(output * numInputs + input)] = getDefaultGain(numInputs, numOutputs, input, output);
+        pendingChanged.store(true);
+    }
+
+    /*! Mixes numSamples samples of source into dest, real-time safe.
+    \   Output channels of dest that the matrix doesn't cover are cleared.
+    */
+    void process(const AudioBuffer<float>& source, int sourceStartSample,
+                 AudioBuffer<float>& dest, int destStartSample, int numSamples)
+    {
+        if (pendingChanged.load())
+        {
+            const SpinLock::ScopedTryLockType lock (pendingLock);
+            if (lock.isLocked())
+            {
+                std::copy(pendingGains.begin(), pendingGains.end(), gains.begin());
+                pendingChanged.store(false);
+            }
+        }
+
+        auto inputs = jmin(numInputs, source.getNumChannels());
+        for (int output=0; output<dest.getNumChannels(); output++)
+        {
+            auto destPointer = dest.getWritePointer(output, destStartSample);
+            FloatVectorOperations::clear(destPointer, numSamples);
+            if (output >= numOutputs)
+                continue;
+
+            for (int input=0; input<inputs; input++)
+            {
+                auto gain = gains[static_cast<size_t>(output * numInputs + input)];
+                if (gain != 0.f)
+                    FloatVectorOperations::addWithMultiply(destPointer, source.getReadPointer(input, sourceStartSample), gain, numSamples);
+            }
+        }
+    }
+
+    /*! Identity when the counts match, mono to every output, and a downmix
+    \   when there are more inputs than outputs: 5.1 (L R C LFE Ls Rs) to stereo
+    \   follows ITU-R BS.775, anything else folds input i onto output i % numOutputs
+    */
+    static float getDefaultGain(int numInputs, int numOutputs, int input, int output)
+    {
+        if (numInputs == 1)
+            return 1.f;
+        if (numInputs <= numOutputs)
+            return input == output ? 1.f : 0.f;
+
+        const auto minus3dB = 0.70710678f;
+        if (numInputs == 6 && numOutputs == 2)
+        {
+            switch (input)
+            {
+                case 0:  return output == 0 ? 1.f : 0.f;
+                case 1:  return output == 1 ? 1.f : 0.f;
+                case 2:  return minus3dB;
+                case 4:  return output == 0 ? minus3dB : 0.f;
+                case 5:  return output == 1 ? minus3dB : 0.f;
+                default: return 0.f; // LFE
+            }
+        }
+        if (numOutputs == 1)
+            return 1.f / std::sqrt(static_cast<float>(numInputs));
+
+        auto numFolded = (numInputs + numOutputs - 1) / numOutputs;
+        return input % numOutputs == output ? 1.f / std::sqrt(static_cast<float>(numFolded)) : 0.f;
+    }
+
+private:
+    int numInputs;
+    int numOutputs;
+    std::vector<float> gains;          // audio thread
+    std::vector<float> pendingGains;   // message thread, under pendingLock
+    SpinLock pendingLock;
+    std::atomic<bool> pendingChanged;
+
+    JUCE_DECLARE_NON_COPYABLE (ChannelRouter)
+};
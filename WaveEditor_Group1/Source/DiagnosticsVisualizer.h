@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    DiagnosticsVisualizer.h
+    Created: 19 Oct 2026 7:05:12am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioProcessingComponent.h"
+
+/*! Shows the audio callback statistics of the CallbackProfiler:
+\   counters on the left, the load histogram on the right
+*/
+class DiagnosticsVisualizer : public Component,
+                              private Timer
+{
+public:
+    DiagnosticsVisualizer(AudioProcessingComponent& c) :
+        apc(c)
+    {
+        resetButton.setButtonText("Reset");
+        resetButton.onClick = [this] {apc.getCallbackProfiler().reset(); };
+        addAndMakeVisible(resetButton);
+
+        dumpButton.setButtonText("Dump to File...");
+        dumpButton.onClick = [this] {dumpButtonClicked(); };
+        addAndMakeVisible(dumpButton);
+
+        setOpaque(true);
+        setSize(520, 300);
+        startTimerHz(5);
+    }
+
+    ~DiagnosticsVisualizer()
+    {
+    }
+
+    void paint(Graphics& g) override
+    {
+        auto& profiler = apc.getCallbackProfiler();
+        g.fillAll(Colour(32, 32, 32));
+
+        auto area = getLocalBounds().reduced(10).withTrimmedBottom(35);
+        auto textArea = area.removeFromLeft(220);
+        auto lineHeight = 18;
+
+        g.setFont(13.0f);
+        paintValue(g, textArea.removeFromTop(lineHeight), "callbacks", String(static_cast<int64>(profiler.getNumCallbacks())));
+        paintValue(g, textArea.removeFromTop(lineHeight), "overruns", String(static_cast<int64>(profiler.getNumOverruns())),
+                   profiler.getNumOverruns() > 0);
+        paintValue(g, textArea.removeFromTop(lineHeight), "late callbacks", String(static_cast<int64>(profiler.getNumLateCallbacks())),
+                   profiler.getNumLateCallbacks() > 0);
+        paintValue(g, textArea.removeFromTop(lineHeight), "duration (ms)", String(profiler.getLastDuration() * 1000.f, 3));
+        paintValue(g, textArea.removeFromTop(lineHeight), "deadline (ms)", String(profiler.getLastDeadline() * 1000.f, 3));
+        paintValue(g, textArea.removeFromTop(lineHeight), "max duration (ms)", String(profiler.getMaxDuration() * 1000.f, 3));
+        paintValue(g, textArea.removeFromTop(lineHeight), "average load (%)", String(profiler.getAverageLoad() * 100.f, 1));
+        paintValue(g, textArea.removeFromTop(lineHeight), "max load (%)", String(profiler.getMaxLoad() * 100.f, 1),
+                   profiler.getMaxLoad() > 1.f);
+        paintValue(g, textArea.removeFromTop(lineHeight), "loop iterations",
+                   String(profiler.getAverageLoopIterations(), 2) + " / " + String(profiler.getMaxLoopIterations()));
+
+        paintHistogram(g, area.withTrimmedLeft(15));
+    }
+
+    void resized() override
+    {
+        auto buttonArea = getLocalBounds().reduced(10).removeFromBottom(25);
+        resetButton.setBounds(buttonArea.removeFromLeft(100));
+        buttonArea.removeFromLeft(10);
+        dumpButton.setBounds(buttonArea.removeFromLeft(120));
+    }
+
+private:
+    void timerCallback() override
+    {
+        repaint();
+    }
+
+    void paintValue(Graphics& g, Rectangle<int> area, const String& name, const String& value, bool warning = false)
+    {
+        g.setColour(Colours::grey);
+        g.drawText(name, area, Justification::centredLeft);
+        g.setColour(warning ? Colours::red : Colours::white);
+        g.drawText(value, area, Justification::centredRight);
+    }
+
+    /*! Bars on a log scale, so the rare slow callbacks stay visible next to the common ones
+    */
+    void paintHistogram(Graphics& g, Rectangle<int> area)
+    {
+        auto& profiler = apc.getCallbackProfiler();
+        g.setColour(Colours::grey);
+        g.drawText("load histogram (0 - 200%)", area.removeFromTop(18), Justification::centredLeft);
+        g.setColour(Colour(48, 48, 48));
+        g.fillRect(area);
+
+        uint64 maxCount = 1;
+        for (int bin=0; bin<CallbackProfiler::numHistogramBins; bin++)
+            maxCount = jmax(maxCount, profiler.getHistogramBin(bin));
+
+        auto barWidth = area.getWidth() / static_cast<float>(CallbackProfiler::numHistogramBins);
+        auto overrunBin = 100 / CallbackProfiler::histogramBinWidthPercent;
+        for (int bin=0; bin<CallbackProfiler::numHistogramBins; bin++)
+        {
+            auto count = profiler.getHistogramBin(bin);
+            if (count == 0)
+                continue;
+            auto proportion = std::log(1.0 + count) / std::log(1.0 + maxCount);
+            auto barHeight = static_cast<float>(proportion * area.getHeight());
+            g.setColour(bin >= overrunBin ? Colours::red : Colours::limegreen);
+            g.fillRect(area.getX() + bin * barWidth, area.getBottom() - barHeight, jmax(1.f, barWidth - 1.f), barHeight);
+        }
+    }
+
+    void dumpButtonClicked()
+    {
+        FileChooser chooser("Save callback statistics...", {}, "*.txt");
+        if (chooser.browseForFileToSave(true))
+            apc.getCallbackProfiler().dumpToFile(chooser.getResult());
+    }
+
+    AudioProcessingComponent& apc;
+    TextButton resetButton;
+    TextButton dumpButton;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DiagnosticsVisualizer)
+};
@@ -0,0 +1,476 @@
+/*
+  ==============================================================================
+
+    Dynamics.h
+    Created: 19 Oct 2026 7:30:16am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParallelUtils.h"
+#include "MeterAudio.h"
+
+/*! Compressor and limiter settings, a ratio of maxRatio or more limits
+*/
+struct DynamicsSettings
+{
+    float thresholdDb = -12.f;
+    float ratio = 4.f;
+    float kneeDb = 6.f;
+    float attackMs = 10.f;
+    float releaseMs = 100.f;
+    float lookaheadMs = 0.f;
+    float makeupDb = 0.f;
+    bool linked = true;     // one gain for all channels from the loudest one
+    bool truePeak = false;  // detect the 4x oversampled peaks instead of the samples
+
+    static constexpr float maxRatio = 100.f;
+    static constexpr float maxLookaheadMs = 20.f;
+};
+
+/*! Feed forward compressor and lookahead limiter working in blocks.
+\
+\   Every block runs in stages: the detector levels of all channels, the
+\   maximum of them when linked, the static gain curve, then the envelope.
+\   The envelope runs on gain tracks (one when linked, one per channel
+\   otherwise) packed into SIMD lanes like the BiquadCascade, so unlinked
+\   channels are smoothed side by side. Its steps are:
+\   - a minimum hold over the lookahead, computed from chunk minima, so it
+\     may hold a little longer but never shorter
+\   - attack and release as the smaller of the two one pole candidates,
+\     which is the attack one while the gain falls and the release one while
+\     it rises, as long as the attack is the faster one
+\   - a moving average over the lookahead
+\   The audio is delayed by the lookahead, so with zero attack the gain has
+\   reached the curve's value when a peak comes out, and a limiter holds its
+\   ceiling. The true peak detector adds its own latency to the delay.
+*/
+class DynamicsProcessor
+{
+public:
+    enum
+    {
+        blockSize = 256
+    };
+
+    DynamicsProcessor():
+    sampleRate(44100.0),
+    numChannels(0),
+    numGroups(0),
+    maxLookahead(1),
+    delayCapacity(1),
+    lookahead(1),
+    chunkSize(1),
+    numStoredChunks(0),
+    latency(0),
+    chunkCount(0),
+    chunkIndex(0),
+    boxIndex(0),
+    attackCoefficient(0.f),
+    releaseCoefficient(0.f),
+    makeupGain(1.f),
+    delayIndex(0)
+    {
+    }
+    ~DynamicsProcessor(){}
+
+    /*! Allocates for the longest lookahead, not real-time safe
+    */
+    void prepare(double newSampleRate, int newNumChannels)
+    {
+        sampleRate = newSampleRate;
+        numChannels = newNumChannels;
+        numGroups = (numChannels + numLanes - 1) / numLanes;
+        maxLookahead = static_cast<int>(std::ceil(DynamicsSettings::maxLookaheadMs * 0.001 * sampleRate)) + 1;
+        delayCapacity = maxLookahead + TruePeakDetector::getLatency();
+
+        detectorBuffer.setSize(jmax(1, numChannels), blockSize);
+        laneStorage.allocate(static_cast<size_t>(numGroups * numLanes * (blockSize + 4 + maxLookahead + maxLookahead) + 16), true);
+        laneWork = alignPointer(laneStorage.get());
+        envelope = laneWork + numGroups * blockSize * numLanes;
+        chunkMinimum = envelope + numGroups * numLanes;
+        storedMinimum = chunkMinimum + numGroups * numLanes;
+        boxSum = storedMinimum + numGroups * numLanes;
+        chunkMinima = boxSum + numGroups * numLanes;
+        boxHistory = chunkMinima + numGroups * maxLookahead * numLanes;
+        delayLine.setSize(jmax(1, numChannels), delayCapacity);
+        truePeakDetectors.clear();
+        truePeakDetectors.resize(static_cast<size_t>(numChannels));
+
+        setSettings(settings, true);
+        reset();
+    }
+
+    /*! Real-time safe. Changing the lookahead or the detector restarts the
+    \   envelope and the delay, the other settings apply from the next block.
+    */
+    void setSettings(const DynamicsSettings& newSettings, bool forceReset = false)
+    {
+        auto newLookahead = jlimit(1, maxLookahead, roundToInt(newSettings.lookaheadMs * 0.001 * sampleRate) + 1);
+        auto newLatency = newLookahead - 1 + (newSettings.truePeak ? TruePeakDetector::getLatency() : 0);
+        auto needsReset = forceReset || newLookahead != lookahead || newLatency != latency || newSettings.linked != settings.linked;
+        settings = newSettings;
+
+        // the attack can't be slower than the release, see the class description
+        auto releaseSamples = jmax(1.0, settings.releaseMs * 0.001 * sampleRate);
+        auto attackSamples = jmin(releaseSamples, settings.attackMs * 0.001 * sampleRate);
+        attackCoefficient = attackSamples < 1.0 ? 0.f : static_cast<float>(std::exp(-1.0 / attackSamples));
+        releaseCoefficient = static_cast<float>(std::exp(-1.0 / releaseSamples));
+        makeupGain = Decibels::decibelsToGain(settings.makeupDb);
+
+        if (needsReset)
+        {
+            lookahead = newLookahead;
+            latency = newLatency;
+            chunkSize = jmax(1, lookahead / 4);
+            numStoredChunks = (lookahead - 1 + chunkSize - 1) / chunkSize;
+            reset();
+        }
+    }
+
+    const DynamicsSettings& getSettings() const
+    {
+        return settings;
+    }
+
+    /*! Samples the output is delayed by
+    */
+    int getLatency() const
+    {
+        return latency;
+    }
+
+    void reset()
+    {
+        if (laneWork == nullptr)
+            return;
+        auto numLaneValues = numGroups * numLanes;
+        FloatVectorOperations::fill(envelope, 1.f, numLaneValues);
+        FloatVectorOperations::fill(chunkMinimum, 1.f, numLaneValues);
+        FloatVectorOperations::fill(storedMinimum, 1.f, numLaneValues);
+        FloatVectorOperations::fill(boxSum, static_cast<float>(lookahead), numLaneValues);
+        FloatVectorOperations::fill(chunkMinima, 1.f, numLaneValues * maxLookahead);
+        FloatVectorOperations::fill(boxHistory, 1.f, numLaneValues * maxLookahead);
+        delayLine.clear();
+        for (auto& detector : truePeakDetectors)
+            detector.reset();
+        chunkCount = 0;
+        chunkIndex = 0;
+        boxIndex = 0;
+        delayIndex = 0;
+    }
+
+    /*! Processes all channels in place with getLatency() samples of delay, real-time safe
+    */
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        auto numBufferChannels = jmin(numChannels, buffer.getNumChannels());
+        for (int offset=0; offset<numSamples; offset+=blockSize)
+        {
+            auto numThisTime = jmin(static_cast<int>(blockSize), numSamples - offset);
+            auto numTracks = settings.linked ? 1 : numBufferChannels;
+
+            // detector levels, the loudest channel when linked
+            for (int channel=0; channel<numBufferChannels; channel++)
+            {
+                auto input = buffer.getReadPointer(channel, startSample + offset);
+                auto levels = detectorBuffer.getWritePointer(channel);
+                if (settings.truePeak)
+                    truePeakDetectors[static_cast<size_t>(channel)].processEach(input, levels, numThisTime);
+                else
+                    FloatVectorOperations::abs(levels, input, numThisTime);
+                if (settings.linked && channel > 0)
+                    FloatVectorOperations::max(detectorBuffer.getWritePointer(0), detectorBuffer.getReadPointer(0), levels, numThisTime);
+            }
+
+            for (int track=0; track<numTracks; track++)
+                computeGains(detectorBuffer.getWritePointer(track), numThisTime);
+            for (int group=0; group<(numTracks + numLanes - 1) / numLanes; group++)
+                processEnvelope(group, numTracks, numThisTime);
+
+            // the delayed audio times the gain of its track
+            auto readIndex = delayIndex;
+            for (int channel=0; channel<numBufferChannels; channel++)
+            {
+                auto samples = buffer.getWritePointer(channel, startSample + offset);
+                auto gains = detectorBuffer.getReadPointer(settings.linked ? 0 : channel);
+                auto delayed = delayLine.getWritePointer(channel);
+                readIndex = delayIndex;
+                for (int i=0; i<numThisTime; i++)
+                {
+                    delayed[readIndex] = samples[i];
+                    auto delayedIndex = readIndex - latency;
+                    if (delayedIndex < 0)
+                        delayedIndex += delayCapacity;
+                    samples[i] = delayed[delayedIndex] * gains[i] * makeupGain;
+                    if (++readIndex == delayCapacity)
+                        readIndex = 0;
+                }
+            }
+            delayIndex = readIndex;
+        }
+    }
+
+    /*! Offline version for a whole buffer, compensates the latency so the
+    \   result lines up with the input. Unlinked channel groups run in parallel.
+    */
+    static void process(AudioBuffer<float>& buffer, double sampleRate, const DynamicsSettings& settings)
+    {
+        auto numTasks = settings.linked ? 1 : (buffer.getNumChannels() + numLanes - 1) / numLanes;
+        ParallelUtils::parallelFor(numTasks, [&](int task) {
+            auto firstChannel = settings.linked ? 0 : task * numLanes;
+            auto numTaskChannels = settings.linked ? buffer.getNumChannels()
+                                                   : jmin(static_cast<int>(numLanes), buffer.getNumChannels() - firstChannel);
+            AudioBuffer<float> channels (buffer.getArrayOfWritePointers() + firstChannel, numTaskChannels, buffer.getNumSamples());
+
+            DynamicsProcessor processor;
+            processor.prepare(sampleRate, numTaskChannels);
+            processor.setSettings(settings);
+            auto delay = processor.getLatency();
+
+            // every block comes back delayed, it is written delay samples earlier,
+            // where the input was already read, then silence flushes the tail
+            AudioBuffer<float> block (numTaskChannels, blockSize);
+            auto numSamples = buffer.getNumSamples();
+            for (int start=0; start<numSamples + delay; start+=blockSize)
+            {
+                auto numThisTime = jmin(static_cast<int>(blockSize), numSamples + delay - start);
+                auto numInput = jlimit(0, numThisTime, numSamples - start);
+                block.clear();
+                for (int channel=0; channel<numTaskChannels; channel++)
+                    if (numInput > 0)
+                        block.copyFrom(channel, 0, channels, channel, start, numInput);
+                processor.process(block, 0, numThisTime);
+
+                auto first = jmax(0, delay - start);
+                auto last = jmin(numThisTime, numSamples + delay - start);
+                for (int channel=0; channel<numTaskChannels; channel++)
+                    if (last > first)
+                        channels.copyFrom(channel, start + first - delay, block, channel, first, last - first);
+            }
+        });
+    }
+
+private:
+#if JUCE_USE_SIMD
+    typedef dsp::SIMDRegister<float> Lanes;
+    enum { numLanes = static_cast<int>(Lanes::SIMDNumElements) };
+#else
+    enum { numLanes = 1 };
+#endif
+
+    static float* alignPointer(float* pointer)
+    {
+        auto address = reinterpret_cast<pointer_sized_uint>(pointer);
+        return reinterpret_cast<float*>((address + 63) & ~static_cast<pointer_sized_uint>(63));
+    }
+
+    /*! Replaces the levels with the gains of the static curve, levels below
+    \   the knee skip the logarithms
+    */
+    void computeGains(float* levels, int numSamples) const
+    {
+        auto slope = settings.ratio >= DynamicsSettings::maxRatio ? 1.f : 1.f - 1.f / jmax(1.f, settings.ratio);
+        auto knee = jmax(0.f, settings.kneeDb);
+        auto kneeStart = Decibels::decibelsToGain(settings.thresholdDb - knee / 2.f);
+        for (int i=0; i<numSamples; i++)
+        {
+            if (levels[i] <= kneeStart)
+            {
+                levels[i] = 1.f;
+                continue;
+            }
+            auto over = 20.f * std::log10(levels[i]) - settings.thresholdDb;
+            auto reduction = (knee > 0.f && 2.f * over < knee) ? slope * (over + knee / 2.f) * (over + knee / 2.f) / (2.f * knee)
+                                                               : slope * over;
+            levels[i] = std::pow(10.f, -reduction / 20.f);
+        }
+    }
+
+    void processEnvelope(int group, int numTracks, int numSamples)
+    {
+        auto work = laneWork + group * blockSize * numLanes;
+        auto firstTrack = group * numLanes;
+        auto numGroupTracks = jmin(static_cast<int>(numLanes), numTracks - firstTrack);
+        if (numLanes > 1)
+            FloatVectorOperations::fill(work, 1.f, numSamples * numLanes);
+        for (int lane=0; lane<numGroupTracks; lane++)
+        {
+            auto gains = detectorBuffer.getReadPointer(firstTrack + lane);
+            for (int i=0; i<numSamples; i++)
+                work[i * numLanes + lane] = gains[i];
+        }
+
+        auto laneOffset = group * numLanes;
+        auto chunks = chunkMinima + group * maxLookahead * numLanes;
+        auto box = boxHistory + group * maxLookahead * numLanes;
+        auto groupChunkCount = chunkCount;
+        auto groupChunkIndex = chunkIndex;
+        auto groupBoxIndex = boxIndex;
+        auto boxScale = 1.f / lookahead;
+#if JUCE_USE_SIMD
+        auto attack = Lanes::expand(attackCoefficient);
+        auto release = Lanes::expand(releaseCoefficient);
+        auto env = Lanes::fromRawArray(envelope + laneOffset);
+        auto chunkMin = Lanes::fromRawArray(chunkMinimum + laneOffset);
+        auto storedMin = Lanes::fromRawArray(storedMinimum + laneOffset);
+        auto sum = Lanes::fromRawArray(boxSum + laneOffset);
+        for (int i=0; i<numSamples; i++)
+        {
+            auto target = Lanes::fromRawArray(work + i * numLanes);
+            chunkMin = Lanes::min(chunkMin, target);
+            auto held = Lanes::min(chunkMin, storedMin);
+            if (++groupChunkCount == chunkSize)
+                storedMin = pushChunk(chunks, groupChunkIndex, groupChunkCount, chunkMin);
+
+            auto difference = env - held;
+            env = Lanes::min(held + difference * attack, held + difference * release);
+
+            auto oldest = Lanes::fromRawArray(box + groupBoxIndex * numLanes);
+            env.copyToRawArray(box + groupBoxIndex * numLanes);
+            sum = sum + env - oldest;
+            if (++groupBoxIndex == lookahead)
+            {
+                groupBoxIndex = 0;
+                sum = sumBox(box);
+            }
+            (sum * boxScale).copyToRawArray(work + i * numLanes);
+        }
+        env.copyToRawArray(envelope + laneOffset);
+        chunkMin.copyToRawArray(chunkMinimum + laneOffset);
+        storedMin.copyToRawArray(storedMinimum + laneOffset);
+        sum.copyToRawArray(boxSum + laneOffset);
+#else
+        auto env = envelope[laneOffset];
+        auto chunkMin = chunkMinimum[laneOffset];
+        auto storedMin = storedMinimum[laneOffset];
+        auto sum = boxSum[laneOffset];
+        for (int i=0; i<numSamples; i++)
+        {
+            chunkMin = jmin(chunkMin, work[i]);
+            auto held = jmin(chunkMin, storedMin);
+            if (++groupChunkCount == chunkSize)
+                storedMin = pushChunk(chunks, groupChunkIndex, groupChunkCount, chunkMin);
+
+            auto difference = env - held;
+            env = jmin(held + difference * attackCoefficient, held + difference * releaseCoefficient);
+
+            sum += env - box[groupBoxIndex];
+            box[groupBoxIndex] = env;
+            if (++groupBoxIndex == lookahead)
+            {
+                groupBoxIndex = 0;
+                sum = sumBox(box);
+            }
+            work[i] = sum * boxScale;
+        }
+        envelope[laneOffset] = env;
+        chunkMinimum[laneOffset] = chunkMin;
+        storedMinimum[laneOffset] = storedMin;
+        boxSum[laneOffset] = sum;
+#endif
+
+        for (int lane=0; lane<numGroupTracks; lane++)
+        {
+            auto gains = detectorBuffer.getWritePointer(firstTrack + lane);
+            for (int i=0; i<numSamples; i++)
+                gains[i] = work[i * numLanes + lane];
+        }
+
+        // all groups step through the same positions
+        if (group == (numTracks - 1) / numLanes)
+        {
+            chunkCount = groupChunkCount;
+            chunkIndex = groupChunkIndex;
+            boxIndex = groupBoxIndex;
+        }
+    }
+
+#if JUCE_USE_SIMD
+    /*! Stores a finished chunk minimum and returns the minimum of the stored chunks
+    */
+    Lanes pushChunk(float* chunks, int& index, int& count, Lanes& chunkMin) const
+    {
+        count = 0;
+        if (numStoredChunks > 0)
+        {
+            chunkMin.copyToRawArray(chunks + index * numLanes);
+            index = (index + 1) % numStoredChunks;
+        }
+        chunkMin = Lanes::expand(1.f);
+        auto result = Lanes::expand(1.f);
+        for (int chunk=0; chunk<numStoredChunks; chunk++)
+            result = Lanes::min(result, Lanes::fromRawArray(chunks + chunk * numLanes));
+        return result;
+    }
+
+    /*! Recomputes the moving average sum, so rounding errors don't build up
+    */
+    Lanes sumBox(const float* box) const
+    {
+        auto result = Lanes::expand(0.f);
+        for (int i=0; i<lookahead; i++)
+            result = result + Lanes::fromRawArray(box + i * numLanes);
+        return result;
+    }
+#else
+    float pushChunk(float* chunks, int& index, int& count, float& chunkMin) const
+    {
+        count = 0;
+        if (numStoredChunks > 0)
+        {
+            chunks[index] = chunkMin;
+            index = (index + 1) % numStoredChunks;
+        }
+        chunkMin = 1.f;
+        auto result = 1.f;
+        for (int chunk=0; chunk<numStoredChunks; chunk++)
+            result = jmin(result, chunks[chunk]);
+        return result;
+    }
+
+    float sumBox(const float* box) const
+    {
+        auto result = 0.f;
+        for (int i=0; i<lookahead; i++)
+            result += box[i];
+        return result;
+    }
+#endif
+
+    DynamicsSettings settings;
+    double sampleRate;
+    int numChannels;
+    int numGroups;
+    int maxLookahead;
+    int delayCapacity;
+    int lookahead;        // samples of the minimum hold and the moving average
+    int chunkSize;
+    int numStoredChunks;
+    int latency;
+    int chunkCount;
+    int chunkIndex;
+    int boxIndex;
+    float attackCoefficient;
+    float releaseCoefficient;
+    float makeupGain;
+
+    AudioBuffer<float> detectorBuffer;  // levels, then gains, per channel
+    HeapBlock<float> laneStorage;
+    float* laneWork = nullptr;          // interleaved gain tracks of every group
+    float* envelope = nullptr;
+    float* chunkMinimum = nullptr;
+    float* storedMinimum = nullptr;
+    float* boxSum = nullptr;
+    float* chunkMinima = nullptr;
+    float* boxHistory = nullptr;
+    AudioBuffer<float> delayLine;
+    int delayIndex;
+    std::vector<TruePeakDetector> truePeakDetectors;
+
+    JUCE_DECLARE_NON_COPYABLE (DynamicsProcessor)
+};
@@ -0,0 +1,280 @@
+/*
+  ==============================================================================
+
+    EditCommandQueue.h
+    Created: 19 Oct 2026 8:05:09am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <deque>
+
+/*! Progress and cancellation of the command that is being prepared
+*/
+class EditProgress
+{
+public:
+    EditProgress():
+    progress(0.0),
+    cancelled(false),
+    listeners(nullptr)
+    {
+    }
+
+    /*! Reports the fraction done, from 0 to 1. Returns false once the command
+    \   is cancelled, the prepare function should then return false too.
+    */
+    bool setProgress(double newProgress)
+    {
+        progress.store(jlimit(0.0, 1.0, newProgress));
+        if (listeners != nullptr)
+            listeners->sendChangeMessage();
+        return !isCancelled();
+    }
+
+    double getProgress() const
+    {
+        return progress.load();
+    }
+
+    bool isCancelled() const
+    {
+        return cancelled.load();
+    }
+
+private:
+    friend class EditCommandQueue;
+
+    void reset()
+    {
+        progress.store(0.0);
+        cancelled.store(false);
+    }
+
+    void cancel()
+    {
+        cancelled.store(true);
+    }
+
+    std::atomic<double> progress;
+    std::atomic<bool> cancelled;
+    ChangeBroadcaster* listeners;
+};
+
+/*! A document edit in two steps. prepare runs on the worker thread and does
+\   the slow part, e.g. processing a copy of the region, copying the undo
+\   buffers or making the new document of an edit that changes the length.
+\   It may read the document but never changes it, and returns false if it
+\   was cancelled. apply then runs on the message thread and puts the result
+\   into the document, which should be quick: it copies a region of the same
+\   length into place or moves the new document in. A command without
+\   prepare is applied in its turn.
+*/
+struct EditCommand
+{
+    String name;
+    std::function<bool(EditProgress&)> prepare;
+    std::function<void()> apply;
+};
+
+/*! Runs edit commands one after the other, preparing each one on a worker
+\   thread so the message thread stays free while it takes long. A command is
+\   only prepared once the one before it has been applied, so it sees the
+\   document as the user will.
+\
+\   Cancelling drops the queued commands and stops the one being prepared
+\   before it is applied, so the document stays as it was. Listeners get a
+\   change message when a command starts, reports progress or finishes.
+*/
+class EditCommandQueue : public ChangeBroadcaster,
+                         private Thread,
+                         private AsyncUpdater
+{
+public:
+    EditCommandQueue():
+    Thread("Edit Commands"),
+    running(false),
+    prepared(false)
+    {
+        progress.listeners = this;
+    }
+
+    ~EditCommandQueue()
+    {
+        cancelAll();
+        signalThreadShouldExit();
+        workAvailable.signal();
+        applied.signal();
+        stopThread(-1);
+        cancelPendingUpdate();
+    }
+
+    /*! Queues a command, call on the message thread. A command without
+    \   prepare is applied straight away when nothing else is queued.
+    */
+    void submit(EditCommand command)
+    {
+        if (!command.prepare && isIdle())
+        {
+            command.apply();
+            return;
+        }
+
+        {
+            const ScopedLock sl (lock);
+            queued.push_back(std::move(command));
+        }
+        if (!isThreadRunning())
+            startThread(4);
+        workAvailable.signal();
+        sendChangeMessage();
+    }
+
+    /*! Drops the queued commands and cancels the one that is running, which
+    \   leaves the document unchanged
+    */
+    void cancelAll()
+    {
+        {
+            const ScopedLock sl (lock);
+            queued.clear();
+            if (running)
+                progress.cancel();
+        }
+        sendChangeMessage();
+    }
+
+    bool isIdle() const
+    {
+        const ScopedLock sl (lock);
+        return queued.empty() && !running;
+    }
+
+    int getNumQueued() const
+    {
+        const ScopedLock sl (lock);
+        return static_cast<int>(queued.size());
+    }
+
+    /*! The name of the command being prepared or applied, empty when idle
+    */
+    String getCurrentName() const
+    {
+        const ScopedLock sl (lock);
+        return running ? current.name : String();
+    }
+
+    double getProgress() const
+    {
+        return progress.getProgress();
+    }
+
+    /*! Blocks until every queued command is applied or cancelled, applying
+    \   them on the calling thread, which must be the message thread. For
+    \   loading a new document, tests and benchmarks. Returns false on time out.
+    */
+    bool waitUntilIdle(int timeOutMilliseconds)
+    {
+        auto startTime = Time::getMillisecondCounter();
+        while (!isIdle())
+        {
+            if (timeOutMilliseconds >= 0 && static_cast<int>(Time::getMillisecondCounter() - startTime) > timeOutMilliseconds)
+                return false;
+            if (!applyPrepared())
+                preparedEvent.wait(10);
+        }
+        return true;
+    }
+
+private:
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            {
+                const ScopedLock sl (lock);
+                if (!queued.empty())
+                {
+                    current = std::move(queued.front());
+                    queued.pop_front();
+                    progress.reset();
+                    running = true;
+                }
+            }
+            if (!isRunning())
+            {
+                workAvailable.wait(500);
+                continue;
+            }
+            sendChangeMessage();
+
+            auto ok = !current.prepare || current.prepare(progress);
+            {
+                const ScopedLock sl (lock);
+                if (ok && !progress.isCancelled())
+                    prepared = true;
+                else
+                    running = false;
+            }
+            sendChangeMessage();
+            if (!isRunning())
+                continue;
+
+            // the next command has to see this one in the document
+            triggerAsyncUpdate();
+            preparedEvent.signal();
+            applied.wait();
+        }
+    }
+
+    bool isRunning() const
+    {
+        const ScopedLock sl (lock);
+        return running;
+    }
+
+    void handleAsyncUpdate() override
+    {
+        applyPrepared();
+    }
+
+    /*! Applies the prepared command unless it was cancelled, returns false if
+    \   there was none
+    */
+    bool applyPrepared()
+    {
+        {
+            const ScopedLock sl (lock);
+            if (!prepared)
+                return false;
+            prepared = false;
+        }
+        // the worker waits, so current can be used without the lock
+        if (!progress.isCancelled())
+            current.apply();
+        current = EditCommand();
+        {
+            const ScopedLock sl (lock);
+            running = false;
+        }
+        applied.signal();
+        sendChangeMessage();
+        return true;
+    }
+
+    CriticalSection lock;           // guards queued, running and prepared
+    std::deque<EditCommand> queued;
+    EditCommand current;            // the worker's until it is prepared
+    bool running;
+    bool prepared;
+    EditProgress progress;
+    WaitableEvent workAvailable;
+    WaitableEvent preparedEvent;
+    WaitableEvent applied;
+
+    JUCE_DECLARE_NON_COPYABLE (EditCommandQueue)
+};
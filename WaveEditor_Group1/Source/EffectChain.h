@@ -0,0 +1,735 @@
+/*
+  ==============================================================================
+
+    EffectChain.h
+    Created: 19 Oct 2026 7:24:13am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParallelUtils.h"
+#include "Equalizer.h"
+#include "Dynamics.h"
+
+/*! Where a block sits in the document, so effects like fades can follow
+\   the document while the preview plays at any rate
+*/
+struct ChainContext
+{
+    double position;          // document position of the first sample
+    double positionIncrement; // document samples per processed sample, negative in reverse
+    double documentSampleRate;
+    int regionStart;          // the region the chain renders to, inclusive
+    int regionEnd;
+};
+
+struct EffectParameter
+{
+    String name;
+    float minimum;
+    float maximum;
+    float defaultValue;
+    String suffix;
+    float midPoint = 0.f; // value in the middle of a skewed slider, 0 for linear
+};
+
+/*! Base class of the effects in the chain. Parameters are atomics, so the
+\   message thread sets them at any time and the audio thread reads them at
+\   the start of every block.
+*/
+class ChainEffect
+{
+public:
+    ChainEffect(std::vector<EffectParameter> parameters):
+    parameterInfos(std::move(parameters)),
+    parameterValues(new std::atomic<float>[parameterInfos.size()]),
+    bypassed(false)
+    {
+        for (size_t i=0; i<parameterInfos.size(); i++)
+            parameterValues[i].store(parameterInfos[i].defaultValue);
+    }
+    virtual ~ChainEffect(){}
+
+    virtual String getName() const = 0;
+
+    /*! Allocates for a sample rate, channel count and block size, not real-time safe
+    */
+    virtual void prepare(double sampleRate, int numChannels, int maxBlockSize) = 0;
+
+    virtual void reset() = 0;
+
+    /*! Processes numSamples samples of every channel in place, real-time safe
+    */
+    virtual void process(AudioBuffer<float>& buffer, int startSample, int numSamples, const ChainContext& context) = 0;
+
+    /*! A new instance of the same effect with the same parameters, unprepared
+    */
+    virtual std::unique_ptr<ChainEffect> clone() const = 0;
+
+    /*! False for effects that look at all channels together, e.g. linked dynamics,
+    \   which the offline render then can't split into one task per channel
+    */
+    virtual bool isChannelIndependent() const
+    {
+        return true;
+    }
+
+    /*! Samples the effect delays its output by
+    */
+    virtual int getLatency() const
+    {
+        return 0;
+    }
+
+    int getNumParameters() const
+    {
+        return static_cast<int>(parameterInfos.size());
+    }
+
+    const EffectParameter& getParameterInfo(int index) const
+    {
+        return parameterInfos[static_cast<size_t>(index)];
+    }
+
+    float getParameter(int index) const
+    {
+        return parameterValues[index].load();
+    }
+
+    void setParameter(int index, float value)
+    {
+        auto& info = getParameterInfo(index);
+        parameterValues[index].store(jlimit(info.minimum, info.maximum, value));
+    }
+
+    bool isBypassed() const
+    {
+        return bypassed.load();
+    }
+
+    void setBypassed(bool shouldBeBypassed)
+    {
+        bypassed.store(shouldBeBypassed);
+    }
+
+protected:
+    template <typename EffectType>
+    std::unique_ptr<ChainEffect> cloneWithParameters() const
+    {
+        std::unique_ptr<ChainEffect> copy (new EffectType());
+        for (int i=0; i<getNumParameters(); i++)
+            copy->setParameter(i, getParameter(i));
+        copy->setBypassed(isBypassed());
+        return copy;
+    }
+
+private:
+    std::vector<EffectParameter> parameterInfos;
+    std::unique_ptr<std::atomic<float>[]> parameterValues;
+    std::atomic<bool> bypassed;
+
+    JUCE_DECLARE_NON_COPYABLE (ChainEffect)
+};
+
+/*! Gain in decibels, ramped over each block when it changes
+*/
+class GainEffect : public ChainEffect
+{
+public:
+    enum
+    {
+        gainParameter = 0
+    };
+
+    GainEffect():
+    ChainEffect({{"Gain", -48.f, 24.f, 0.f, " dB"}}),
+    lastGain(1.f)
+    {
+    }
+
+    String getName() const override
+    {
+        return "Gain";
+    }
+
+    void prepare(double, int, int) override
+    {
+        reset();
+    }
+
+    void reset() override
+    {
+        lastGain = Decibels::decibelsToGain(getParameter(gainParameter));
+    }
+
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples, const ChainContext&) override
+    {
+        auto gain = Decibels::decibelsToGain(getParameter(gainParameter));
+        for (int channel=0; channel<buffer.getNumChannels(); channel++)
+        {
+            if (gain == lastGain)
+                buffer.applyGain(channel, startSample, numSamples, gain);
+            else
+                buffer.applyGainRamp(channel, startSample, numSamples, lastGain, gain);
+        }
+        lastGain = gain;
+    }
+
+    std::unique_ptr<ChainEffect> clone() const override
+    {
+        return cloneWithParameters<GainEffect>();
+    }
+
+private:
+    float lastGain;
+};
+
+/*! Linear fade in from the start and fade out to the end of the region the
+\   chain renders to, following the document position of every sample
+*/
+class FadeEffect : public ChainEffect
+{
+public:
+    enum
+    {
+        fadeInParameter = 0,
+        fadeOutParameter
+    };
+
+    FadeEffect():
+    ChainEffect({{"Fade In", 0.f, 10000.f, 500.f, " ms"},
+                 {"Fade Out", 0.f, 10000.f, 500.f, " ms"}})
+    {
+    }
+
+    String getName() const override
+    {
+        return "Fade";
+    }
+
+    void prepare(double, int, int maxBlockSize) override
+    {
+        gains.allocate(static_cast<size_t>(maxBlockSize), true);
+        this->maxBlockSize = maxBlockSize;
+    }
+
+    void reset() override
+    {
+    }
+
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples, const ChainContext& context) override
+    {
+        auto fadeInLength = getParameter(fadeInParameter) * 0.001 * context.documentSampleRate;
+        auto fadeOutLength = getParameter(fadeOutParameter) * 0.001 * context.documentSampleRate;
+
+        for (int offset=0; offset<numSamples; offset+=maxBlockSize)
+        {
+            auto numThisTime = jmin(maxBlockSize, numSamples - offset);
+            for (int i=0; i<numThisTime; i++)
+            {
+                auto position = context.position + (offset + i) * context.positionIncrement;
+                auto gain = 1.0;
+                if (position >= context.regionStart && position <= context.regionEnd)
+                {
+                    if (fadeInLength > 0.0)
+                        gain = jmin(gain, (position - context.regionStart) / fadeInLength);
+                    if (fadeOutLength > 0.0)
+                        gain = jmin(gain, (context.regionEnd - position) / fadeOutLength);
+                }
+                gains[i] = static_cast<float>(gain);
+            }
+            for (int channel=0; channel<buffer.getNumChannels(); channel++)
+                FloatVectorOperations::multiply(buffer.getWritePointer(channel, startSample + offset), gains.get(), numThisTime);
+        }
+    }
+
+    std::unique_ptr<ChainEffect> clone() const override
+    {
+        return cloneWithParameters<FadeEffect>();
+    }
+
+private:
+    HeapBlock<float> gains;
+    int maxBlockSize = 0;
+};
+
+/*! High pass, low shelf, two peaks, high shelf and low pass as one
+\   BiquadCascade over all channels. The high pass is off at 0 Hz and the
+\   low pass at 20 kHz, coefficients are recalculated when a parameter changes.
+*/
+class EqualizerEffect : public ChainEffect
+{
+public:
+    enum
+    {
+        highPassFrequency = 0,
+        lowShelfFrequency,
+        lowShelfGain,
+        peak1Frequency,
+        peak1Gain,
+        peak1Q,
+        peak2Frequency,
+        peak2Gain,
+        peak2Q,
+        highShelfFrequency,
+        highShelfGain,
+        lowPassFrequency,
+        numEqParameters
+    };
+
+    enum
+    {
+        numBands = 6
+    };
+
+    EqualizerEffect():
+    ChainEffect({{"HP", 0.f, 2000.f, 0.f, " Hz", 200.f},
+                 {"Low Shelf", 20.f, 2000.f, 100.f, " Hz", 200.f},
+                 {"Low Shelf Gain", -24.f, 24.f, 0.f, " dB"},
+                 {"Peak 1", 20.f, 20000.f, 500.f, " Hz", 1000.f},
+                 {"Peak 1 Gain", -24.f, 24.f, 0.f, " dB"},
+                 {"Peak 1 Q", 0.1f, 10.f, 1.f, "", 1.f},
+                 {"Peak 2", 20.f, 20000.f, 3000.f, " Hz", 1000.f},
+                 {"Peak 2 Gain", -24.f, 24.f, 0.f, " dB"},
+                 {"Peak 2 Q", 0.1f, 10.f, 1.f, "", 1.f},
+                 {"High Shelf", 1000.f, 20000.f, 8000.f, " Hz", 5000.f},
+                 {"High Shelf Gain", -24.f, 24.f, 0.f, " dB"},
+                 {"LP", 1000.f, 20000.f, 20000.f, " Hz", 5000.f}}),
+    sampleRate(44100.0)
+    {
+        for (int i=0; i<numEqParameters; i++)
+            lastValues[i] = 0.f;
+    }
+
+    String getName() const override
+    {
+        return "EQ";
+    }
+
+    void prepare(double newSampleRate, int numChannels, int) override
+    {
+        sampleRate = newSampleRate;
+        cascade.prepare(numChannels);
+        updateCoefficients();
+    }
+
+    void reset() override
+    {
+        cascade.reset();
+    }
+
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples, const ChainContext&) override
+    {
+        for (int i=0; i<numEqParameters; i++)
+        {
+            if (getParameter(i) != lastValues[i])
+            {
+                updateCoefficients();
+                break;
+            }
+        }
+        cascade.process(buffer, startSample, numSamples);
+    }
+
+    std::unique_ptr<ChainEffect> clone() const override
+    {
+        return cloneWithParameters<EqualizerEffect>();
+    }
+
+    /*! The bands for the current parameters
+    */
+    void getBands(EqBand* bands) const
+    {
+        const auto passQ = 1.0 / std::sqrt(2.0);
+        auto lowPass = getParameter(lowPassFrequency) >= getParameterInfo(lowPassFrequency).maximum
+                     ? sampleRate : static_cast<double>(getParameter(lowPassFrequency));
+        bands[0] = {EqBand::HighPass, getParameter(highPassFrequency), 0.0, passQ};
+        bands[1] = {EqBand::LowShelf, getParameter(lowShelfFrequency), getParameter(lowShelfGain), passQ};
+        bands[2] = {EqBand::Peak, getParameter(peak1Frequency), getParameter(peak1Gain), getParameter(peak1Q)};
+        bands[3] = {EqBand::Peak, getParameter(peak2Frequency), getParameter(peak2Gain), getParameter(peak2Q)};
+        bands[4] = {EqBand::HighShelf, getParameter(highShelfFrequency), getParameter(highShelfGain), passQ};
+        bands[5] = {EqBand::LowPass, lowPass, 0.0, passQ};
+    }
+
+private:
+    void updateCoefficients()
+    {
+        for (int i=0; i<numEqParameters; i++)
+            lastValues[i] = getParameter(i);
+        EqBand bands[numBands];
+        getBands(bands);
+        BiquadCoefficients stages[BiquadCascade::maxStages];
+        auto numStages = ParametricEqualizer::makeStages(bands, numBands, sampleRate, stages);
+        cascade.setCoefficients(stages, numStages);
+    }
+
+    double sampleRate;
+    BiquadCascade cascade;
+    float lastValues[numEqParameters];
+};
+
+/*! Compressor with linked detection, the lookahead delays the output
+*/
+class CompressorEffect : public ChainEffect
+{
+public:
+    enum
+    {
+        thresholdParameter = 0,
+        ratioParameter,
+        attackParameter,
+        releaseParameter,
+        kneeParameter,
+        makeupParameter,
+        lookaheadParameter
+    };
+
+    CompressorEffect():
+    ChainEffect({{"Threshold", -60.f, 0.f, -18.f, " dB"},
+                 {"Ratio", 1.f, 20.f, 4.f, ":1", 4.f},
+                 {"Attack", 0.f, 200.f, 10.f, " ms", 20.f},
+                 {"Release", 5.f, 2000.f, 150.f, " ms", 200.f},
+                 {"Knee", 0.f, 24.f, 6.f, " dB"},
+                 {"Makeup", 0.f, 24.f, 0.f, " dB"},
+                 {"Lookahead", 0.f, DynamicsSettings::maxLookaheadMs, 0.f, " ms"}})
+    {
+    }
+
+    String getName() const override
+    {
+        return "Compressor";
+    }
+
+    void prepare(double sampleRate, int numChannels, int) override
+    {
+        processor.prepare(sampleRate, numChannels);
+        processor.setSettings(getSettings());
+    }
+
+    void reset() override
+    {
+        processor.reset();
+    }
+
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples, const ChainContext&) override
+    {
+        processor.setSettings(getSettings());
+        processor.process(buffer, startSample, numSamples);
+    }
+
+    std::unique_ptr<ChainEffect> clone() const override
+    {
+        return cloneWithParameters<CompressorEffect>();
+    }
+
+    bool isChannelIndependent() const override
+    {
+        return false;
+    }
+
+    int getLatency() const override
+    {
+        return processor.getLatency();
+    }
+
+private:
+    DynamicsSettings getSettings() const
+    {
+        DynamicsSettings settings;
+        settings.thresholdDb = getParameter(thresholdParameter);
+        settings.ratio = getParameter(ratioParameter);
+        settings.attackMs = getParameter(attackParameter);
+        settings.releaseMs = getParameter(releaseParameter);
+        settings.kneeDb = getParameter(kneeParameter);
+        settings.makeupDb = getParameter(makeupParameter);
+        settings.lookaheadMs = getParameter(lookaheadParameter);
+        return settings;
+    }
+
+    DynamicsProcessor processor;
+};
+
+/*! Linked true peak limiter, the output stays below the ceiling in dBTP
+*/
+class LimiterEffect : public ChainEffect
+{
+public:
+    enum
+    {
+        ceilingParameter = 0,
+        releaseParameter,
+        lookaheadParameter
+    };
+
+    LimiterEffect():
+    ChainEffect({{"Ceiling", -24.f, 0.f, -1.f, " dBTP"},
+                 {"Release", 5.f, 2000.f, 100.f, " ms", 200.f},
+                 {"Lookahead", 0.5f, DynamicsSettings::maxLookaheadMs, 5.f, " ms"}})
+    {
+    }
+
+    String getName() const override
+    {
+        return "Limiter";
+    }
+
+    void prepare(double sampleRate, int numChannels, int) override
+    {
+        processor.prepare(sampleRate, numChannels);
+        processor.setSettings(getSettings());
+    }
+
+    void reset() override
+    {
+        processor.reset();
+    }
+
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples, const ChainContext&) override
+    {
+        processor.setSettings(getSettings());
+        processor.process(buffer, startSample, numSamples);
+    }
+
+    std::unique_ptr<ChainEffect> clone() const override
+    {
+        return cloneWithParameters<LimiterEffect>();
+    }
+
+    bool isChannelIndependent() const override
+    {
+        return false;
+    }
+
+    int getLatency() const override
+    {
+        return processor.getLatency();
+    }
+
+    /*! The settings of a limiter with a ceiling, used by the offline operation too
+    */
+    static DynamicsSettings makeSettings(float ceilingDb, float releaseMs, float lookaheadMs)
+    {
+        DynamicsSettings settings;
+        settings.thresholdDb = ceilingDb;
+        settings.ratio = DynamicsSettings::maxRatio;
+        settings.kneeDb = 0.f;
+        settings.attackMs = 0.f;
+        settings.releaseMs = releaseMs;
+        settings.lookaheadMs = lookaheadMs;
+        settings.truePeak = true;
+        return settings;
+    }
+
+private:
+    DynamicsSettings getSettings() const
+    {
+        return makeSettings(getParameter(ceilingParameter), getParameter(releaseParameter), getParameter(lookaheadParameter));
+    }
+
+    DynamicsProcessor processor;
+};
+
+/*! The non-destructive effects of a document. The message thread edits the
+\   list and publishes a copy that the audio thread picks up with a try-lock,
+\   the same way ChannelRouter hands over its matrix. The copy the audio thread
+\   drops stays in the pending list, so effects are only ever deleted on the
+\   message thread.
+*/
+class EffectChain
+{
+public:
+    enum
+    {
+        renderBlockSize = 4096
+    };
+
+    EffectChain():
+    sampleRate(44100.0),
+    numChannels(2),
+    maxBlockSize(512),
+    pendingChanged(false)
+    {
+    }
+    ~EffectChain(){}
+
+    /*! The names createEffect understands, in menu order
+    */
+    static StringArray getAvailableEffects()
+    {
+        return {"Gain", "Fade", "EQ", "Compressor", "Limiter"};
+    }
+
+    static std::unique_ptr<ChainEffect> createEffect(const String& name)
+    {
+        if (name == "Gain")
+            return std::unique_ptr<ChainEffect>(new GainEffect());
+        if (name == "Fade")
+            return std::unique_ptr<ChainEffect>(new FadeEffect());
+        if (name == "EQ")
+            return std::unique_ptr<ChainEffect>(new EqualizerEffect());
+        if (name == "Compressor")
+            return std::unique_ptr<ChainEffect>(new CompressorEffect());
+        if (name == "Limiter")
+            return std::unique_ptr<ChainEffect>(new LimiterEffect());
+        return nullptr;
+    }
+
+    /*! Prepares every effect for the playback device, not real-time safe
+    */
+    void prepare(double newSampleRate, int newNumChannels, int newMaxBlockSize)
+    {
+        sampleRate = newSampleRate;
+        numChannels = newNumChannels;
+        maxBlockSize = newMaxBlockSize;
+        for (auto& effect : effects)
+            effect->prepare(sampleRate, numChannels, maxBlockSize);
+    }
+
+    void addEffect(std::unique_ptr<ChainEffect> effect)
+    {
+        if (effect == nullptr)
+            return;
+        effect->prepare(sampleRate, numChannels, maxBlockSize);
+        effects.push_back(std::shared_ptr<ChainEffect>(std::move(effect)));
+        publish();
+    }
+
+    void removeEffect(int index)
+    {
+        if (index < 0 || index >= getNumEffects())
+            return;
+        effects.erase(effects.begin() + index);
+        publish();
+    }
+
+    void clear()
+    {
+        effects.clear();
+        publish();
+    }
+
+    int getNumEffects() const
+    {
+        return static_cast<int>(effects.size());
+    }
+
+    ChainEffect* getEffect(int index) const
+    {
+        return effects[static_cast<size_t>(index)].get();
+    }
+
+    /*! Runs the published chain over a block, real-time safe
+    */
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples, const ChainContext& context)
+    {
+        if (pendingChanged.load())
+        {
+            const SpinLock::ScopedTryLockType lock (pendingLock);
+            if (lock.isLocked())
+            {
+                activeEffects.swap(pendingEffects);
+                pendingChanged.store(false);
+            }
+        }
+
+        for (auto& effect : activeEffects)
+            if (!effect->isBypassed())
+                effect->process(buffer, startSample, numSamples, context);
+    }
+
+    /*! Applies copies of the chain to a buffer that holds the region
+    \   [regionStart, regionEnd] of the document. When every effect works per
+    \   channel, each channel runs on its own worker with its own copies.
+    \   The latency of lookahead effects is compensated, so the result lines
+    \   up with the input.
+    */
+    void render(AudioBuffer<float>& buffer, double documentSampleRate, int regionStart, int regionEnd) const
+    {
+        render(effects, buffer, documentSampleRate, regionStart, regionEnd);
+    }
+
+    /*! Copies of the effects, for rendering on another thread while the chain
+    \   is edited
+    */
+    std::vector<std::shared_ptr<ChainEffect>> cloneEffects() const
+    {
+        std::vector<std::shared_ptr<ChainEffect>> clones;
+        for (auto& effect : effects)
+            clones.push_back(std::shared_ptr<ChainEffect>(effect->clone()));
+        return clones;
+    }
+
+    static void render(const std::vector<std::shared_ptr<ChainEffect>>& effects, AudioBuffer<float>& buffer,
+                       double documentSampleRate, int regionStart, int regionEnd)
+    {
+        auto independent = std::all_of(effects.begin(), effects.end(),
+                                       [](const std::shared_ptr<ChainEffect>& effect) {return effect->isChannelIndependent(); });
+        auto numTasks = independent ? buffer.getNumChannels() : 1;
+
+        ParallelUtils::parallelFor(numTasks, [&](int task) {
+            auto firstChannel = independent ? task : 0;
+            auto numTaskChannels = independent ? 1 : buffer.getNumChannels();
+            AudioBuffer<float> channels (buffer.getArrayOfWritePointers() + firstChannel, numTaskChannels, buffer.getNumSamples());
+
+            std::vector<std::unique_ptr<ChainEffect>> copies;
+            std::vector<int> latencyBefore;
+            int latency = 0;
+            for (auto& effect : effects)
+            {
+                if (effect->isBypassed())
+                    continue;
+                copies.push_back(effect->clone());
+                copies.back()->prepare(documentSampleRate, numTaskChannels, renderBlockSize);
+                latencyBefore.push_back(latency);
+                latency += copies.back()->getLatency();
+            }
+
+            // blocks come back latency samples late, they are written that much
+            // earlier, where the input was already read, then silence flushes the tail
+            auto numSamples = buffer.getNumSamples();
+            AudioBuffer<float> block (numTaskChannels, renderBlockSize);
+            for (int start=0; start<numSamples + latency; start+=renderBlockSize)
+            {
+                auto numThisTime = jmin(static_cast<int>(renderBlockSize), numSamples + latency - start);
+                auto numInput = jlimit(0, numThisTime, numSamples - start);
+                block.clear();
+                for (int channel=0; channel<numTaskChannels && numInput>0; channel++)
+                    block.copyFrom(channel, 0, channels, channel, start, numInput);
+
+                for (size_t i=0; i<copies.size(); i++)
+                {
+                    ChainContext context {static_cast<double>(regionStart + start - latencyBefore[i]), 1.0,
+                                          documentSampleRate, regionStart, regionEnd};
+                    copies[i]->process(block, 0, numThisTime, context);
+                }
+
+                auto first = jmax(0, latency - start);
+                for (int channel=0; channel<numTaskChannels && first<numThisTime; channel++)
+                    channels.copyFrom(channel, start + first - latency, block, channel, first, numThisTime - first);
+            }
+        });
+    }
+
+private:
+    void publish()
+    {
+        const SpinLock::ScopedLockType lock (pendingLock);
+        pendingEffects = effects;
+        pendingChanged.store(true);
+    }
+
+    double sampleRate;
+    int numChannels;
+    int maxBlockSize;
+    std::vector<std::shared_ptr<ChainEffect>> effects;         // message thread
+    std::vector<std::shared_ptr<ChainEffect>> pendingEffects;  // under pendingLock
+    std::vector<std::shared_ptr<ChainEffect>> activeEffects;   // audio thread
+    SpinLock pendingLock;
+    std::atomic<bool> pendingChanged;
+
+    JUCE_DECLARE_NON_COPYABLE (EffectChain)
+};
@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+    EffectChainVisualizer.h
+    Created: 19 Oct 2026 7:24:13am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioProcessingComponent.h"
+
+/*! Edits the effect chain while it plays, one row per effect with a slider
+\   for every parameter, Render applies the chain to the marked region
+*/
+class EffectChainVisualizer : public Component
+{
+public:
+    EffectChainVisualizer(AudioProcessingComponent& c) :
+        apc(c)
+    {
+        addEffectBox.setTextWhenNothingSelected("Add Effect...");
+        addEffectBox.addItemList(EffectChain::getAvailableEffects(), 1);
+        addEffectBox.onChange = [this] {addEffectSelected(); };
+        addAndMakeVisible(addEffectBox);
+
+        renderButton.setButtonText("Render to Selection");
+        renderButton.onClick = [this] {renderButtonClicked(); };
+        addAndMakeVisible(renderButton);
+
+        rebuildRows();
+    }
+
+    void paint(Graphics& g) override
+    {
+        g.fillAll(Colour(32, 32, 32));
+        g.setColour(Colours::grey);
+        g.setFont(12.0f);
+        if (rows.isEmpty())
+            g.drawText("no effects", getLocalBounds().withTrimmedBottom(footerHeight), Justification::centred);
+    }
+
+    void resized() override
+    {
+        auto y = 10;
+        for (auto* row : rows)
+        {
+            row->nameLabel.setBounds(10, y, 100, rowHeight);
+            row->bypassButton.setBounds(getWidth() - 150, y, 70, rowHeight);
+            row->removeButton.setBounds(getWidth() - 75, y, 65, rowHeight);
+            y += rowHeight + 5;
+            for (auto* slider : row->sliders)
+            {
+                slider->setBounds(20, y, getWidth() - 30, rowHeight);
+                y += rowHeight + 5;
+            }
+            y += 5;
+        }
+        addEffectBox.setBounds(10, getHeight() - 35, 150, 25);
+        renderButton.setBounds(getWidth() - 160, getHeight() - 35, 150, 25);
+    }
+
+private:
+    enum
+    {
+        rowHeight = 22,
+        footerHeight = 45
+    };
+
+    struct EffectRow
+    {
+        Label nameLabel;
+        ToggleButton bypassButton;
+        TextButton removeButton;
+        OwnedArray<Slider> sliders;
+    };
+
+    void rebuildRows()
+    {
+        rows.clear();
+        auto& chain = apc.getEffectChain();
+        auto height = footerHeight + 10;
+        for (int index=0; index<chain.getNumEffects(); index++)
+        {
+            auto* effect = chain.getEffect(index);
+            auto* row = rows.add(new EffectRow());
+
+            row->nameLabel.setText(effect->getName(), dontSendNotification);
+            addAndMakeVisible(row->nameLabel);
+
+            row->bypassButton.setButtonText("Bypass");
+            row->bypassButton.setToggleState(effect->isBypassed(), dontSendNotification);
+            row->bypassButton.onClick = [effect, row] {effect->setBypassed(row->bypassButton.getToggleState()); };
+            addAndMakeVisible(row->bypassButton);
+
+            row->removeButton.setButtonText("Remove");
+            row->removeButton.onClick = [this, index] {removeEffect(index); };
+            addAndMakeVisible(row->removeButton);
+
+            for (int parameter=0; parameter<effect->getNumParameters(); parameter++)
+            {
+                auto& info = effect->getParameterInfo(parameter);
+                auto* slider = row->sliders.add(new Slider(info.name));
+                slider->setSliderStyle(Slider::LinearBar);
+                slider->setRange(info.minimum, info.maximum);
+                if (info.midPoint > 0.f)
+                    slider->setSkewFactorFromMidPoint(info.midPoint);
+                slider->setTextValueSuffix(info.suffix + " " + info.name.toLowerCase());
+                slider->setValue(effect->getParameter(parameter), dontSendNotification);
+                slider->setDoubleClickReturnValue(true, info.defaultValue);
+                slider->onValueChange = [effect, slider, parameter] {effect->setParameter(parameter, static_cast<float>(slider->getValue())); };
+                addAndMakeVisible(slider);
+            }
+            height += (rowHeight + 5) * (1 + effect->getNumParameters()) + 5;
+        }
+        setSize(360, jmax(120, height));
+        resized();
+        repaint();
+    }
+
+    void addEffectSelected()
+    {
+        apc.getEffectChain().addEffect(EffectChain::createEffect(addEffectBox.getText()));
+        addEffectBox.setSelectedId(0, dontSendNotification);
+        rebuildRows();
+    }
+
+    void removeEffect(int index)
+    {
+        // the button that called this is deleted in rebuildRows, so finish the click first
+        MessageManager::callAsync([safeThis = Component::SafePointer<EffectChainVisualizer>(this), index] {
+            if (safeThis != nullptr)
+            {
+                safeThis->apc.getEffectChain().removeEffect(index);
+                safeThis->rebuildRows();
+            }
+        });
+    }
+
+    void renderButtonClicked()
+    {
+        apc.renderEffectChainToMarkedRegion();
+        rebuildRows();
+    }
+
+    AudioProcessingComponent& apc;
+    ComboBox addEffectBox;
+    TextButton renderButton;
+    OwnedArray<EffectRow> rows;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EffectChainVisualizer)
+};
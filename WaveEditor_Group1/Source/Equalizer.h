@@ -0,0 +1,318 @@
+/*
+  ==============================================================================
+
+    Equalizer.h
+    Created: 19 Oct 2026 7:26:46am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParallelUtils.h"
+
+/*! One band of the parametric EQ, gain is ignored by the pass filters
+*/
+struct EqBand
+{
+    enum Type
+    {
+        HighPass = 0,
+        LowShelf,
+        Peak,
+        HighShelf,
+        LowPass
+    };
+
+    Type type;
+    double frequency;
+    double gainDb;
+    double q;
+};
+
+/*! Normalized coefficients of one biquad, from the RBJ audio EQ cookbook
+*/
+struct BiquadCoefficients
+{
+    float b0, b1, b2, a1, a2;
+
+    /*! False for bands that don't change the signal: shelves and peaks at
+    \   0 dB, a high pass at 0 Hz and a low pass at or above Nyquist
+    */
+    static bool isActive(const EqBand& band, double sampleRate)
+    {
+        switch (band.type)
+        {
+            case EqBand::HighPass:
+                return band.frequency > 0.0;
+            case EqBand::LowPass:
+                return band.frequency < 0.49 * sampleRate;
+            default:
+                return std::abs(band.gainDb) > 0.01;
+        }
+    }
+
+    static BiquadCoefficients make(const EqBand& band, double sampleRate)
+    {
+        auto frequency = jlimit(1.0, 0.49 * sampleRate, band.frequency);
+        auto w0 = MathConstants<double>::twoPi * frequency / sampleRate;
+        auto cosW0 = std::cos(w0);
+        auto alpha = std::sin(w0) / (2.0 * jmax(0.01, band.q));
+        auto A = std::pow(10.0, band.gainDb / 40.0);
+        auto twoSqrtAAlpha = 2.0 * std::sqrt(A) * alpha;
+
+        double b0, b1, b2, a0, a1, a2;
+        switch (band.type)
+        {
+            case EqBand::HighPass:
+                b0 = (1.0 + cosW0) / 2.0;
+                b1 = -(1.0 + cosW0);
+                b2 = b0;
+                a0 = 1.0 + alpha;
+                a1 = -2.0 * cosW0;
+                a2 = 1.0 - alpha;
+                break;
+            case EqBand::LowPass:
+                b0 = (1.0 - cosW0) / 2.0;
+                b1 = 1.0 - cosW0;
+                b2 = b0;
+                a0 = 1.0 + alpha;
+                a1 = -2.0 * cosW0;
+                a2 = 1.0 - alpha;
+                break;
+            case EqBand::LowShelf:
+                b0 = A * ((A + 1.0) - (A - 1.0) * cosW0 + twoSqrtAAlpha);
+                b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosW0);
+                b2 = A * ((A + 1.0) - (A - 1.0) * cosW0 - twoSqrtAAlpha);
+                a0 = (A + 1.0) + (A - 1.0) * cosW0 + twoSqrtAAlpha;
+                a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosW0);
+                a2 = (A + 1.0) + (A - 1.0) * cosW0 - twoSqrtAAlpha;
+                break;
+            case EqBand::HighShelf:
+                b0 = A * ((A + 1.0) + (A - 1.0) * cosW0 + twoSqrtAAlpha);
+                b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosW0);
+                b2 = A * ((A + 1.0) + (A - 1.0) * cosW0 - twoSqrtAAlpha);
+                a0 = (A + 1.0) - (A - 1.0) * cosW0 + twoSqrtAAlpha;
+                a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosW0);
+                a2 = (A + 1.0) - (A - 1.0) * cosW0 - twoSqrtAAlpha;
+                break;
+            case EqBand::Peak:
+            default:
+                b0 = 1.0 + alpha * A;
+                b1 = -2.0 * cosW0;
+                b2 = 1.0 - alpha * A;
+                a0 = 1.0 + alpha / A;
+                a1 = -2.0 * cosW0;
+                a2 = 1.0 - alpha / A;
+                break;
+        }
+        return {static_cast<float>(b0 / a0), static_cast<float>(b1 / a0), static_cast<float>(b2 / a0),
+                static_cast<float>(a1 / a0), static_cast<float>(a2 / a0)};
+    }
+};
+
+/*! Cascaded biquads in transposed direct form II for any number of channels.
+\   The channels are packed into groups of one SIMD register, so the lanes of
+\   a register are different channels at the same sample and every stage runs
+\   over a whole interleaved block of a group before the next stage starts.
+\   Groups are independent, so different groups can run on different threads.
+*/
+class BiquadCascade
+{
+public:
+    enum
+    {
+        maxStages = 8,
+        blockSize = 256
+    };
+
+    BiquadCascade():
+    numChannels(0),
+    numGroups(0),
+    numStages(0),
+    state(nullptr),
+    work(nullptr)
+    {
+    }
+    ~BiquadCascade(){}
+
+    /*! Allocates the state and workspaces, not real-time safe
+    */
+    void prepare(int newNumChannels)
+    {
+        numChannels = newNumChannels;
+        numGroups = (numChannels + numLanes - 1) / numLanes;
+        stateStorage.allocate(static_cast<size_t>(numGroups * maxStages * 2 * numLanes + 16), true);
+        state = alignPointer(stateStorage.get());
+        workStorage.allocate(static_cast<size_t>(numGroups * blockSize * numLanes + 16), true);
+        work = alignPointer(workStorage.get());
+        reset();
+    }
+
+    void reset()
+    {
+        if (state != nullptr)
+            FloatVectorOperations::clear(state, numGroups * maxStages * 2 * numLanes);
+    }
+
+    /*! Real-time safe, the filter state carries over to the new coefficients
+    */
+    void setCoefficients(const BiquadCoefficients* newCoefficients, int newNumStages)
+    {
+        numStages = jmin(newNumStages, static_cast<int>(maxStages));
+        for (int stage=0; stage<numStages; stage++)
+            coefficients[stage] = newCoefficients[stage];
+    }
+
+    int getNumGroups() const
+    {
+        return numGroups;
+    }
+
+    static int getNumLanes()
+    {
+        return numLanes;
+    }
+
+    /*! Filters all channels in place, real-time safe
+    */
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        for (int group=0; group<numGroups; group++)
+            processGroup(buffer, group, startSample, numSamples);
+    }
+
+    /*! Filters the channels of one group in place
+    */
+    void processGroup(AudioBuffer<float>& buffer, int group, int startSample, int numSamples)
+    {
+        if (numStages == 0)
+            return;
+        auto groupWork = work + group * blockSize * numLanes;
+        auto firstChannel = group * numLanes;
+        auto numGroupChannels = jmin(static_cast<int>(numLanes), buffer.getNumChannels() - firstChannel);
+
+        for (int offset=0; offset<numSamples; offset+=blockSize)
+        {
+            auto numThisTime = jmin(static_cast<int>(blockSize), numSamples - offset);
+            if (numLanes > 1)
+                FloatVectorOperations::clear(groupWork, numThisTime * numLanes);
+            for (int lane=0; lane<numGroupChannels; lane++)
+            {
+                auto input = buffer.getReadPointer(firstChannel + lane, startSample + offset);
+                for (int i=0; i<numThisTime; i++)
+                    groupWork[i * numLanes + lane] = input[i];
+            }
+
+            for (int stage=0; stage<numStages; stage++)
+                processStage(group, stage, groupWork, numThisTime);
+
+            for (int lane=0; lane<numGroupChannels; lane++)
+            {
+                auto output = buffer.getWritePointer(firstChannel + lane, startSample + offset);
+                for (int i=0; i<numThisTime; i++)
+                    output[i] = groupWork[i * numLanes + lane];
+            }
+        }
+    }
+
+private:
+#if JUCE_USE_SIMD
+    typedef dsp::SIMDRegister<float> Lanes;
+    enum { numLanes = static_cast<int>(Lanes::SIMDNumElements) };
+#else
+    enum { numLanes = 1 };
+#endif
+
+    static float* alignPointer(float* pointer)
+    {
+        auto address = reinterpret_cast<pointer_sized_uint>(pointer);
+        return reinterpret_cast<float*>((address + 63) & ~static_cast<pointer_sized_uint>(63));
+    }
+
+    void processStage(int group, int stage, float* samples, int numSamples)
+    {
+        auto& c = coefficients[stage];
+        auto z = state + (group * maxStages + stage) * 2 * numLanes;
+#if JUCE_USE_SIMD
+        auto b0 = Lanes::expand(c.b0), b1 = Lanes::expand(c.b1), b2 = Lanes::expand(c.b2);
+        auto a1 = Lanes::expand(c.a1), a2 = Lanes::expand(c.a2);
+        auto z1 = Lanes::fromRawArray(z);
+        auto z2 = Lanes::fromRawArray(z + numLanes);
+        for (int i=0; i<numSamples; i++)
+        {
+            auto x = Lanes::fromRawArray(samples + i * numLanes);
+            auto y = Lanes::multiplyAdd(z1, b0, x);
+            z1 = Lanes::multiplyAdd(z2, b1, x) - a1 * y;
+            z2 = b2 * x - a2 * y;
+            y.copyToRawArray(samples + i * numLanes);
+        }
+        z1.copyToRawArray(z);
+        z2.copyToRawArray(z + numLanes);
+#else
+        auto z1 = z[0];
+        auto z2 = z[1];
+        for (int i=0; i<numSamples; i++)
+        {
+            auto x = samples[i];
+            auto y = c.b0 * x + z1;
+            z1 = c.b1 * x - c.a1 * y + z2;
+            z2 = c.b2 * x - c.a2 * y;
+            samples[i] = y;
+        }
+        z[0] = z1;
+        z[1] = z2;
+#endif
+    }
+
+    int numChannels;
+    int numGroups;
+    int numStages;
+    BiquadCoefficients coefficients[maxStages];
+    HeapBlock<float> stateStorage;
+    HeapBlock<float> workStorage;
+    float* state;
+    float* work;
+
+    JUCE_DECLARE_NON_COPYABLE (BiquadCascade)
+};
+
+/*! Offline parametric EQ of a whole buffer, one worker per channel group
+*/
+class ParametricEqualizer
+{
+public:
+    /*! The cascade stages for a set of bands, bands that don't change the
+    \   signal are left out
+        @return the number of stages
+    */
+    static int makeStages(const EqBand* bands, int numBands, double sampleRate, BiquadCoefficients* stages)
+    {
+        int numStages = 0;
+        for (int i=0; i<numBands; i++)
+            if (numStages < BiquadCascade::maxStages && BiquadCoefficients::isActive(bands[i], sampleRate))
+                stages[numStages++] = BiquadCoefficients::make(bands[i], sampleRate);
+        return numStages;
+    }
+
+    static void process(AudioBuffer<float>& buffer, double sampleRate, const std::vector<EqBand>& bands)
+    {
+        BiquadCoefficients stages[BiquadCascade::maxStages];
+        auto numStages = makeStages(bands.data(), static_cast<int>(bands.size()), sampleRate, stages);
+        if (numStages == 0)
+            return;
+
+        BiquadCascade cascade;
+        cascade.prepare(buffer.getNumChannels());
+        cascade.setCoefficients(stages, numStages);
+        ParallelUtils::parallelFor(cascade.getNumGroups(), [&](int group) {
+            cascade.processGroup(buffer, group, 0, buffer.getNumSamples());
+        });
+    }
+
+private:
+    ParametricEqualizer(){};
+    ~ParametricEqualizer(){};
+};
@@ -24,6 +24,9 @@ GUIComponent::GUIComponent(AudioProcessingComponent& c) : apc(c)
 
     trackVis = new TrackVisualizer(apc);
     addAndMakeVisible(trackVis);
+
+    meterVis = new MeterVisualizer(apc);
+    addAndMakeVisible(meterVis);
 }
 
 GUIComponent::~GUIComponent()
@@ -36,6 +39,9 @@ GUIComponent::~GUIComponent()
 
     delete trackVis;
     trackVis = nullptr;
+
+    delete meterVis;
+    meterVis = nullptr;
 }
 
 void GUIComponent::paint (Graphics& g)
@@ -57,7 +63,9 @@ void GUIComponent::resized()
 {
     // This method is where you should set the bounds of any child
     // components that your component contains..
+    auto meterWidth = 110;
     tlbar->setBounds(0, 0, getWidth(), 100);
-    trackVis->setBounds(0,100,getWidth(),(getHeight()-100)/2);
-    specvis->setBounds(0, 100+(getHeight()-100)/2, getWidth(), (getHeight()-100)/2);
+    trackVis->setBounds(0,100,getWidth()-meterWidth,(getHeight()-100)/2);
+    specvis->setBounds(0, 100+(getHeight()-100)/2, getWidth()-meterWidth, (getHeight()-100)/2);
+    meterVis->setBounds(getWidth()-meterWidth, 100, meterWidth, getHeight()-100);
 }
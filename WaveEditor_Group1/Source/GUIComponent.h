@@ -14,6 +14,7 @@
 #include "ToolbarIF.h"
 #include "SpectrogramVisualizer.h"
 #include "WaveVisualizer.h"
+#include "MeterVisualizer.h"
 
 //==============================================================================
 /*
@@ -34,6 +35,7 @@ private:
     SpectrogramVisualizer *specvis;
     //WaveVisualizer *wavViewer;
     TrackVisualizer *trackVis;
+    MeterVisualizer *meterVis;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GUIComponent)
 };
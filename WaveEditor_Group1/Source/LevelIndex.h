@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+
+    LevelIndex.h
+    Created: 19 Oct 2026 6:55:24am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*! Summary of a range of samples, mergeable so it can live in a segment tree
+*/
+struct LevelSummary
+{
+    float peak = 0.f;
+    double sumOfSquares = 0.0;
+    double sum = 0.0;
+    int64 numSamples = 0;
+
+    void merge(const LevelSummary& other)
+    {
+        peak = jmax(peak, other.peak);
+        sumOfSquares += other.sumOfSquares;
+        sum += other.sum;
+        numSamples += other.numSamples;
+    }
+
+    float getRMS() const
+    {
+        if (numSamples == 0)
+            return 0.f;
+        return static_cast<float>(std::sqrt(sumOfSquares / static_cast<double>(numSamples)));
+    }
+
+    float getDC() const
+    {
+        if (numSamples == 0)
+            return 0.f;
+        return static_cast<float>(sum / static_cast<double>(numSamples));
+    }
+
+    /*! Computes the summary of numSamples samples
+    */
+    static LevelSummary fromSamples(const float* samples, int numSamples)
+    {
+        LevelSummary summary;
+        if (numSamples <= 0)
+            return summary;
+
+        auto range = FloatVectorOperations::findMinAndMax(samples, numSamples);
+        summary.peak = jmax(-range.getStart(), range.getEnd());
+
+        float sum = 0.f;
+        float squares = 0.f;
+        int i = 0;
+#if JUCE_USE_SIMD
+        // scalar up to the first aligned sample, then one register of lanes at a time
+        typedef dsp::SIMDRegister<float> Lanes;
+        for (; i<numSamples && !Lanes::isSIMDAligned(samples + i); i++)
+        {
+            sum += samples[i];
+            squares += samples[i] * samples[i];
+        }
+        auto sumLanes = Lanes::expand(0.f);
+        auto squareLanes = Lanes::expand(0.f);
+        for (; i+static_cast<int>(Lanes::SIMDNumElements)<=numSamples; i+=static_cast<int>(Lanes::SIMDNumElements))
+        {
+            auto x = Lanes::fromRawArray(samples + i);
+            sumLanes += x;
+            squareLanes = Lanes::multiplyAdd(squareLanes, x, x);
+        }
+        sum += sumLanes.sum();
+        squares += squareLanes.sum();
+#endif
+        for (; i<numSamples; i++)
+        {
+            sum += samples[i];
+            squares += samples[i] * samples[i];
+        }
+
+        summary.sum = sum;
+        summary.sumOfSquares = squares;
+        summary.numSamples = numSamples;
+        return summary;
+    }
+};
+
+/*! Per channel segment tree of block summaries (peak, sum of squares, sum),
+\   answering peak/RMS/DC queries for any range in O(log n).
+\   In-place edits only touch the edited blocks and their parents, edits that
+\   change the length rebuild the blocks from the edit position to the end.
+*/
+class LevelIndex
+{
+public:
+    LevelIndex(int samplesPerBlock = 256):
+    samplesPerBlock(samplesPerBlock),
+    numSamples(0),
+    numBlocks(0),
+    numLeaves(0)
+    {
+    }
+    ~LevelIndex(){}
+
+    void rebuild(const AudioBuffer<float>& audioBuffer)
+    {
+        trees.clear();
+        numSamples = 0;
+        numBlocks = 0;
+        numLeaves = 0;
+        resize(audioBuffer.getNumChannels(), audioBuffer.getNumSamples());
+        updateBlocks(audioBuffer, 0, numBlocks);
+    }
+
+    /*! Called after numRemoved samples starting at startSample have been replaced
+    \   by numInserted samples
+    */
+    void update(const AudioBuffer<float>& audioBuffer, int startSample, int numRemoved, int numInserted)
+    {
+        if (static_cast<int>(trees.size()) != audioBuffer.getNumChannels())
+        {
+            rebuild(audioBuffer);
+            return;
+        }
+
+        auto startBlock = jmax(0, startSample / samplesPerBlock);
+        if (numRemoved == numInserted)
+        {
+            auto endBlock = jmin(numBlocks, (startSample + numInserted + samplesPerBlock - 1) / samplesPerBlock);
+            updateBlocks(audioBuffer, startBlock, endBlock);
+        }
+        else
+        {
+            auto oldNumLeaves = numLeaves;
+            resize(audioBuffer.getNumChannels(), audioBuffer.getNumSamples());
+            if (numLeaves != oldNumLeaves)
+                startBlock = 0;
+            updateBlocks(audioBuffer, startBlock, numLeaves);
+        }
+    }
+
+    /*! Returns the summary of one channel in [startSample, startSample+numSamplesToQuery)
+    */
+    LevelSummary getLevels(const AudioBuffer<float>& audioBuffer, int channel, int startSample, int numSamplesToQuery) const
+    {
+        LevelSummary summary;
+        if (channel >= static_cast<int>(trees.size()))
+            return summary;
+
+        auto start = jlimit(0, numSamples, startSample);
+        auto end = jlimit(start, numSamples, startSample + numSamplesToQuery);
+        if (start == end)
+            return summary;
+
+        auto readPointer = audioBuffer.getReadPointer(channel);
+        auto firstFullBlock = (start + samplesPerBlock - 1) / samplesPerBlock;
+        auto lastFullBlock = end / samplesPerBlock;
+
+        if (firstFullBlock >= lastFullBlock) // the range doesn't cover a whole block
+            return LevelSummary::fromSamples(readPointer + start, end - start);
+
+        summary = LevelSummary::fromSamples(readPointer + start, firstFullBlock * samplesPerBlock - start);
+        summary.merge(queryBlocks(trees[static_cast<size_t>(channel)], firstFullBlock, lastFullBlock));
+        summary.merge(LevelSummary::fromSamples(readPointer + lastFullBlock * samplesPerBlock,
+                                                end - lastFullBlock * samplesPerBlock));
+        return summary;
+    }
+
+    /*! Returns the summary of all channels combined
+    */
+    LevelSummary getLevels(const AudioBuffer<float>& audioBuffer, int startSample, int numSamplesToQuery) const
+    {
+        LevelSummary summary;
+        for (int channel=0; channel<static_cast<int>(trees.size()); channel++)
+            summary.merge(getLevels(audioBuffer, channel, startSample, numSamplesToQuery));
+        return summary;
+    }
+
+    int getSamplesPerBlock() const
+    {
+        return samplesPerBlock;
+    }
+
+    int getNumChannels() const
+    {
+        return static_cast<int>(trees.size());
+    }
+
+    int getNumBlocks() const
+    {
+        return numBlocks;
+    }
+
+    /*! Returns the summary of a single block, O(1)
+    */
+    const LevelSummary& getBlockLevels(int channel, int blockIndex) const
+    {
+        return trees[static_cast<size_t>(channel)][static_cast<size_t>(numLeaves + blockIndex)];
+    }
+
+private:
+    typedef std::vector<LevelSummary> Tree;
+
+    void resize(int numChannels, int newNumSamples)
+    {
+        numSamples = newNumSamples;
+        numBlocks = (numSamples + samplesPerBlock - 1) / samplesPerBlock;
+        auto newNumLeaves = 1;
+        while (newNumLeaves < numBlocks)
+            newNumLeaves *= 2;
+        if (newNumLeaves != numLeaves || static_cast<int>(trees.size()) != numChannels)
+        {
+            numLeaves = newNumLeaves;
+            trees.assign(static_cast<size_t>(numChannels), Tree(static_cast<size_t>(2 * numLeaves)));
+        }
+    }
+
+    /*! Recomputes the leaves in [startBlock, endBlock) and their parents
+    */
+    void updateBlocks(const AudioBuffer<float>& audioBuffer, int startBlock, int endBlock)
+    {
+        if (startBlock >= endBlock)
+            return;
+
+        for (int channel=0; channel<static_cast<int>(trees.size()); channel++)
+        {
+            auto& tree = trees[static_cast<size_t>(channel)];
+            auto readPointer = audioBuffer.getReadPointer(channel);
+            for (int block=startBlock; block<endBlock; block++)
+            {
+                auto blockStart = block * samplesPerBlock;
+                auto blockLength = jmax(0, jmin(samplesPerBlock, numSamples - blockStart));
+                tree[static_cast<size_t>(numLeaves + block)] = LevelSummary::fromSamples(readPointer + blockStart, blockLength);
+            }
+
+            // walk up level by level, only recomputing the parents of changed leaves
+            auto low = (numLeaves + startBlock) / 2;
+            auto high = (numLeaves + endBlock - 1) / 2;
+            while (low >= 1)
+            {
+                for (int node=low; node<=high; node++)
+                {
+                    auto merged = tree[static_cast<size_t>(2 * node)];
+                    merged.merge(tree[static_cast<size_t>(2 * node + 1)]);
+                    tree[static_cast<size_t>(node)] = merged;
+                }
+                low /= 2;
+                high /= 2;
+            }
+        }
+    }
+
+    /*! Merges the leaves in [startBlock, endBlock)
+    */
+    LevelSummary queryBlocks(const Tree& tree, int startBlock, int endBlock) const
+    {
+        LevelSummary summary;
+        auto low = startBlock + numLeaves;
+        auto high = endBlock + numLeaves;
+        while (low < high)
+        {
+            if (low & 1)
+                summary.merge(tree[static_cast<size_t>(low++)]);
+            if (high & 1)
+                summary.merge(tree[static_cast<size_t>(--high)]);
+            low /= 2;
+            high /= 2;
+        }
+        return summary;
+    }
+
+    int samplesPerBlock;
+    int numSamples;
+    int numBlocks;
+    int numLeaves;
+    std::vector<Tree> trees;
+};
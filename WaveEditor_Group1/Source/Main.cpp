@@ -18,6 +18,8 @@
 #ifdef RUN_TEST
 #include "UnitTest.h"
 #endif
+#include "Benchmark.h"
+#include "SampleRateConverter.h"
 
 //==============================================================================
 class WaveEditor_Group1Application  : public JUCEApplication
@@ -31,13 +33,51 @@ public:
     bool moreThanOneInstanceAllowed() override       { return true; }
     
     //==============================================================================
-    void initialise (const String&) override
+    void initialise (const String& commandLine) override
     {
         // This method is where you should put your application's initialisation code..
 #ifdef RUN_TEST
     UnitTestRunner runner;
     runner.runAllTests();
 #endif
+        // whole arguments, so e.g. a file name containing an option doesn't trigger it
+        auto arguments = StringArray::fromTokens(commandLine, true);
+
+        // headless benchmark run, see Benchmark.h for the options
+        if (arguments.contains("--benchmark"))
+        {
+            KoolEditBenchmark benchmark;
+            benchmark.parseCommandLine(commandLine);
+            benchmark.runAll();
+            benchmark.writeResults();
+            setApplicationReturnValue(0);
+            quit();
+            return;
+        }
+
+        // headless sample rate conversion: --convert input.wav output.wav --rate=48000
+        if (arguments.contains("--convert"))
+        {
+            auto index = arguments.indexOf("--convert");
+            double targetRate = 0.0;
+            for (auto& argument : arguments)
+                if (argument.startsWith("--rate="))
+                    targetRate = argument.fromFirstOccurrenceOf("=", false, false).getDoubleValue();
+
+            String error;
+            if (index < 0 || index + 2 >= arguments.size() || targetRate <= 0)
+                error = "usage: --convert input.wav output.wav --rate=48000";
+            else
+                error = SampleRateConverter::convertFile(File::getCurrentWorkingDirectory().getChildFile(arguments[index + 1].unquoted()),
+                                                         File::getCurrentWorkingDirectory().getChildFile(arguments[index + 2].unquoted()),
+                                                         targetRate);
+            if (error.isNotEmpty())
+                std::cerr << error << std::endl;
+            setApplicationReturnValue(error.isEmpty() ? 0 : 1);
+            quit();
+            return;
+        }
+
         splash = new SplashScreen("koolEdit", 
             ImageFileFormat::loadFrom(buttonAssets::koolEdit2020_logo_png, (size_t)buttonAssets::koolEdit2020_logo_pngSize), 
             true);
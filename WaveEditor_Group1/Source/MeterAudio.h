@@ -9,3 +9,655 @@
 */
 
 #pragma once
+
+#include <JuceHeader.h>
+#include "ParallelUtils.h"
+#include "LevelIndex.h"
+
+/*! Two cascaded biquads implementing the ITU-R BS.1770 K-weighting curve
+\   (high shelf + RLB high pass), with coefficients for any sample rate
+*/
+class KWeightingFilter
+{
+public:
+    KWeightingFilter()
+    {
+        setSampleRate(48000.0);
+    }
+
+    void setSampleRate(double sampleRate)
+    {
+        // stage 1: high shelf
+        auto f0 = 1681.974450955533;
+        auto gain = 3.999843853973347;
+        auto q = 0.7071752369554196;
+        auto k = std::tan(MathConstants<double>::pi * f0 / sampleRate);
+        auto vh = std::pow(10.0, gain / 20.0);
+        auto vb = std::pow(vh, 0.4996667741545416);
+        auto a0 = 1.0 + k / q + k * k;
+        shelfB[0] = (vh + vb * k / q + k * k) / a0;
+        shelfB[1] = 2.0 * (k * k - vh) / a0;
+        shelfB[2] = (vh - vb * k / q + k * k) / a0;
+        shelfA[1] = 2.0 * (k * k - 1.0) / a0;
+        shelfA[2] = (1.0 - k / q + k * k) / a0;
+
+        // stage 2: high pass
+        f0 = 38.13547087602444;
+        q = 0.5003270373238773;
+        k = std::tan(MathConstants<double>::pi * f0 / sampleRate);
+        a0 = 1.0 + k / q + k * k;
+        highPassA[1] = 2.0 * (k * k - 1.0) / a0;
+        highPassA[2] = (1.0 - k / q + k * k) / a0;
+
+        reset();
+    }
+
+    void reset()
+    {
+        shelfState[0] = shelfState[1] = 0.0;
+        highPassState[0] = highPassState[1] = 0.0;
+    }
+
+    /*! Filters numSamples samples and returns the sum of squares of the output
+    */
+    double processSumOfSquares(const float* samples, int numSamples)
+    {
+        double sumOfSquares = 0.0;
+        auto s0 = shelfState[0], s1 = shelfState[1];
+        auto h0 = highPassState[0], h1 = highPassState[1];
+        for (int i=0; i<numSamples; i++)
+        {
+            double x = samples[i];
+            auto y = shelfB[0] * x + s0;
+            s0 = shelfB[1] * x - shelfA[1] * y + s1;
+            s1 = shelfB[2] * x - shelfA[2] * y;
+
+            auto z = y + h0;
+            h0 = -2.0 * y - highPassA[1] * z + h1;
+            h1 = y - highPassA[2] * z;
+
+            sumOfSquares += z * z;
+        }
+        shelfState[0] = s0;
+        shelfState[1] = s1;
+        highPassState[0] = h0;
+        highPassState[1] = h1;
+        return sumOfSquares;
+    }
+
+private:
+    double shelfB[3];
+    double shelfA[3];
+    double highPassA[3];
+    double shelfState[2];
+    double highPassState[2];
+};
+
+/*! 4x oversampling true peak detector (polyphase windowed sinc interpolation)
+*/
+class TruePeakDetector
+{
+public:
+    enum
+    {
+        oversampling = 4,
+        tapsPerPhase = 12
+    };
+
+    TruePeakDetector()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(history, history + 2 * tapsPerPhase, 0.f);
+        historyPos = 0;
+    }
+
+    /*! Streaming version for the audio thread, returns the oversampled peak of the samples
+    */
+    float process(const float* samples, int numSamples)
+    {
+        auto& table = getTable();
+        float peak = 0.f;
+        for (int i=0; i<numSamples; i++)
+        {
+            historyPos = (historyPos + 1) % tapsPerPhase;
+            history[historyPos] = samples[i];
+            history[historyPos + tapsPerPhase] = samples[i];
+            peak = jmax(peak, interpolatedPeak(table, history + historyPos + 1));
+        }
+        return peak;
+    }
+
+    /*! Streaming version that writes the oversampled peak around every sample,
+    \   getLatency() samples after the sample it belongs to
+    */
+    void processEach(const float* samples, float* peaks, int numSamples)
+    {
+        auto& table = getTable();
+        for (int i=0; i<numSamples; i++)
+        {
+            historyPos = (historyPos + 1) % tapsPerPhase;
+            history[historyPos] = samples[i];
+            history[historyPos + tapsPerPhase] = samples[i];
+            peaks[i] = interpolatedPeak(table, history + historyPos + 1);
+        }
+    }
+
+    static int getLatency()
+    {
+        return tapsPerPhase / 2;
+    }
+
+    /*! Offline version: returns the oversampled peak of data[startSample, endSample)
+    \   where data holds numSamples samples. Each phase is run as an FIR over a
+    \   block of samples, and blocks that cannot exceed currentPeak
+    \   (block magnitude * interpolator gain) are skipped.
+    */
+    static float findTruePeak(const float* data, int numSamples, int startSample, int endSample, float currentPeak)
+    {
+        auto& table = getTable();
+        const int blockSize = 256;
+        float edgeWindow[blockSize + tapsPerPhase - 1];
+        float values[blockSize];
+        endSample = jmin(endSample, numSamples);
+
+        for (int blockStart=startSample; blockStart<endSample; blockStart+=blockSize)
+        {
+            auto blockLength = jmin(blockSize, endSample - blockStart);
+            auto windowStart = blockStart - (tapsPerPhase - 1);
+            auto windowLength = blockLength + tapsPerPhase - 1;
+            auto window = data + windowStart;
+            if (windowStart < 0) // zero pad before the first sample
+            {
+                for (int j=0; j<windowLength; j++)
+                    edgeWindow[j] = (windowStart + j >= 0) ? data[windowStart + j] : 0.f;
+                window = edgeWindow;
+            }
+
+            // phase 0 reproduces the samples themselves
+            auto range = FloatVectorOperations::findMinAndMax(window, windowLength);
+            auto magnitude = jmax(-range.getStart(), range.getEnd());
+            currentPeak = jmax(currentPeak, magnitude);
+            if (magnitude * table.maxGain <= currentPeak)
+                continue;
+
+            for (int phase=1; phase<oversampling; phase++)
+            {
+                FloatVectorOperations::clear(values, blockLength);
+                for (int j=0; j<tapsPerPhase; j++)
+                    FloatVectorOperations::addWithMultiply(values, window + j, table.taps[j][phase], blockLength);
+                range = FloatVectorOperations::findMinAndMax(values, blockLength);
+                currentPeak = jmax(currentPeak, -range.getStart(), range.getEnd());
+            }
+        }
+        return currentPeak;
+    }
+
+private:
+    struct Table
+    {
+        // taps[j][phase] multiplies window[j] (oldest sample first), the phases
+        // are innermost so all of them are computed together in vector lanes
+        float taps[tapsPerPhase][oversampling];
+        float maxGain;
+    };
+
+    static const Table& getTable()
+    {
+        static const Table table = createTable();
+        return table;
+    }
+
+    static Table createTable()
+    {
+        Table table;
+        const int length = oversampling * tapsPerPhase;
+        const double centre = length / 2;
+        table.maxGain = 0.f;
+        for (int phase=0; phase<oversampling; phase++)
+        {
+            float gain = 0.f;
+            for (int k=0; k<tapsPerPhase; k++)
+            {
+                auto n = k * oversampling + phase;
+                auto x = (n - centre) / oversampling;
+                auto sinc = x == 0.0 ? 1.0 : std::sin(MathConstants<double>::pi * x) / (MathConstants<double>::pi * x);
+                auto window = 0.42 - 0.5 * std::cos(2.0 * MathConstants<double>::pi * n / length)
+                                   + 0.08 * std::cos(4.0 * MathConstants<double>::pi * n / length);
+                auto tap = static_cast<float>(sinc * window);
+                table.taps[tapsPerPhase - 1 - k][phase] = tap;
+                gain += std::abs(tap);
+            }
+            table.maxGain = jmax(table.maxGain, gain);
+        }
+        return table;
+    }
+
+    /*! window holds tapsPerPhase samples, oldest first
+    */
+    static float interpolatedPeak(const Table& table, const float* window)
+    {
+        float values[oversampling] = {};
+        for (int j=0; j<tapsPerPhase; j++)
+            for (int phase=0; phase<oversampling; phase++)
+                values[phase] += table.taps[j][phase] * window[j];
+
+        float peak = 0.f;
+        for (int phase=0; phase<oversampling; phase++)
+            peak = jmax(peak, std::abs(values[phase]));
+        return peak;
+    }
+
+    float history[2 * tapsPerPhase];
+    int historyPos;
+};
+
+/*! Result of an offline loudness measurement, in LUFS and dBTP
+*/
+struct LoudnessResult
+{
+    float integratedLoudness;
+    float maxMomentaryLoudness;
+    float maxShortTermLoudness;
+    float truePeak;
+};
+
+/*! EBU R128 loudness meter.
+\   process() is meant for the audio callback: it never allocates or locks and
+\   publishes momentary (400ms), short-term (3s) and integrated loudness plus the
+\   true peak through atomics. measure() analyses a whole buffer offline, in
+\   parallel chunks of 100ms blocks.
+*/
+class LoudnessMeter
+{
+public:
+    enum
+    {
+        maxChannels = 16,
+        numShortTermBlocks = 30, // 3s of 100ms blocks
+        numMomentaryBlocks = 4,  // 400ms of 100ms blocks
+        numHistogramBins = 800   // -70 to +10 LUFS in 0.1 LU steps
+    };
+
+    LoudnessMeter()
+    {
+        prepare(48000.0);
+    }
+
+    /*! Sets the sample rate and clears the measurement, call it while the
+    \   audio thread isn't processing
+    */
+    void prepare(double sampleRate)
+    {
+        subBlockLength = jmax(1, roundToInt(0.1 * sampleRate));
+        for (auto& filter : filters)
+            filter.setSampleRate(sampleRate);
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto& filter : filters)
+            filter.reset();
+        for (auto& detector : truePeakDetectors)
+            detector.reset();
+        std::fill(blockPowers, blockPowers + numShortTermBlocks, 0.0);
+        std::fill(histogramCounts, histogramCounts + numHistogramBins, 0);
+        std::fill(histogramPowers, histogramPowers + numHistogramBins, 0.0);
+        numBlocks = 0;
+        currentEnergy = 0.0;
+        currentNumSamples = 0;
+        currentTruePeak = 0.f;
+
+        momentaryLoudness.store(getSilenceLoudness());
+        shortTermLoudness.store(getSilenceLoudness());
+        integratedLoudness.store(getSilenceLoudness());
+        truePeak.store(getSilenceLoudness());
+    }
+
+    /*! Real-time safe, feed it the file channels that are being played,
+    \   before they are routed to the outputs, so the channel weights apply
+    */
+    void process(const AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        auto numChannels = jmin(buffer.getNumChannels(), static_cast<int>(maxChannels));
+        int done = 0;
+        while (done < numSamples)
+        {
+            auto numThisTime = jmin(numSamples - done, subBlockLength - currentNumSamples);
+            for (int channel=0; channel<numChannels; channel++)
+            {
+                auto readPointer = buffer.getReadPointer(channel, startSample + done);
+                auto weight = getChannelWeight(channel, numChannels);
+                auto sumOfSquares = filters[channel].processSumOfSquares(readPointer, numThisTime);
+                currentEnergy += weight * sumOfSquares;
+                currentTruePeak = jmax(currentTruePeak, truePeakDetectors[channel].process(readPointer, numThisTime));
+            }
+            done += numThisTime;
+            currentNumSamples += numThisTime;
+            if (currentNumSamples == subBlockLength)
+                finishBlock();
+        }
+        truePeak.store(Decibels::gainToDecibels(currentTruePeak, getSilenceLoudness()));
+    }
+
+    float getMomentaryLoudness() const
+    {
+        return momentaryLoudness.load();
+    }
+
+    float getShortTermLoudness() const
+    {
+        return shortTermLoudness.load();
+    }
+
+    float getIntegratedLoudness() const
+    {
+        return integratedLoudness.load();
+    }
+
+    /*! Returns the true peak in dBTP since the last reset
+    */
+    float getTruePeak() const
+    {
+        return truePeak.load();
+    }
+
+    /*! Measures numSamples samples of buffer starting at startSample
+    */
+    static LoudnessResult measure(const AudioBuffer<float>& buffer, int startSample, int numSamples, double sampleRate)
+    {
+        auto blockLength = jmax(1, roundToInt(0.1 * sampleRate));
+        auto numChannels = buffer.getNumChannels();
+        auto numBlocks = numSamples / blockLength;
+        auto prerollLength = roundToInt(0.2 * sampleRate); // lets the filters settle at chunk borders
+
+        std::vector<double> powers(static_cast<size_t>(numBlocks), 0.0);
+        std::vector<float> channelPeaks(static_cast<size_t>(numChannels), 0.f);
+        SpinLock peakLock;
+
+        // the chunks are independent: each one warms its own filters up on the samples before it
+        ParallelUtils::parallelForChunks(jmax(1, numBlocks), 50, [&](int firstBlock, int numChunkBlocks) {
+            auto chunkStart = firstBlock * blockLength;
+            auto chunkEnd = (firstBlock + numChunkBlocks >= numBlocks) ? numSamples : chunkStart + numChunkBlocks * blockLength;
+            for (int channel=0; channel<numChannels; channel++)
+            {
+                auto data = buffer.getReadPointer(channel, startSample);
+                auto weight = getChannelWeight(channel, numChannels);
+                KWeightingFilter filter;
+                filter.setSampleRate(sampleRate);
+                auto prerollStart = jmax(0, chunkStart - prerollLength);
+                filter.processSumOfSquares(data + prerollStart, chunkStart - prerollStart);
+                for (int block=firstBlock; block<jmin(numBlocks, firstBlock+numChunkBlocks); block++)
+                    powers[static_cast<size_t>(block)] += weight * filter.processSumOfSquares(data + block * blockLength, blockLength) / blockLength;
+
+                auto peak = TruePeakDetector::findTruePeak(data, numSamples, chunkStart, chunkEnd, 0.f);
+                const SpinLock::ScopedLockType lock (peakLock);
+                channelPeaks[static_cast<size_t>(channel)] = jmax(channelPeaks[static_cast<size_t>(channel)], peak);
+            }
+        });
+
+        LoudnessResult result;
+        result.truePeak = getSilenceLoudness();
+        for (auto peak : channelPeaks)
+            result.truePeak = jmax(result.truePeak, Decibels::gainToDecibels(peak, getSilenceLoudness()));
+
+        // 400ms gating blocks overlapping by 75%, then absolute and relative gating
+        std::vector<double> gatingPowers;
+        double windowPower = 0.0;
+        double shortTermPower = 0.0;
+        result.maxMomentaryLoudness = getSilenceLoudness();
+        result.maxShortTermLoudness = getSilenceLoudness();
+        for (int block=0; block<numBlocks; block++)
+        {
+            windowPower += powers[static_cast<size_t>(block)];
+            shortTermPower += powers[static_cast<size_t>(block)];
+            if (block >= numMomentaryBlocks)
+                windowPower -= powers[static_cast<size_t>(block - numMomentaryBlocks)];
+            if (block >= numShortTermBlocks)
+                shortTermPower -= powers[static_cast<size_t>(block - numShortTermBlocks)];
+
+            if (block >= numMomentaryBlocks - 1)
+            {
+                auto power = windowPower / numMomentaryBlocks;
+                gatingPowers.push_back(power);
+                result.maxMomentaryLoudness = jmax(result.maxMomentaryLoudness, powerToLoudness(power));
+            }
+            if (block >= numShortTermBlocks - 1)
+                result.maxShortTermLoudness = jmax(result.maxShortTermLoudness, powerToLoudness(shortTermPower / numShortTermBlocks));
+        }
+        result.integratedLoudness = getGatedLoudness(gatingPowers);
+        return result;
+    }
+
+    /*! BS.1770 channel weights, the surround channels of a 5.1 layout get +1.5 dB and the LFE is ignored
+    */
+    static double getChannelWeight(int channel, int numChannels)
+    {
+        if (numChannels == 6)
+        {
+            if (channel == 3)
+                return 0.0;
+            if (channel >= 4)
+                return 1.41;
+        }
+        return 1.0;
+    }
+
+    static float powerToLoudness(double power)
+    {
+        if (power <= 0.0)
+            return getSilenceLoudness();
+        return jmax(getSilenceLoudness(), static_cast<float>(-0.691 + 10.0 * std::log10(power)));
+    }
+
+    static float getSilenceLoudness()
+    {
+        return -100.f;
+    }
+
+private:
+    static float getGatedLoudness(const std::vector<double>& gatingPowers)
+    {
+        double sum = 0.0;
+        int count = 0;
+        for (auto power : gatingPowers)
+        {
+            if (powerToLoudness(power) > -70.f)
+            {
+                sum += power;
+                count++;
+            }
+        }
+        if (count == 0)
+            return getSilenceLoudness();
+
+        auto relativeGate = powerToLoudness(sum / count) - 10.f;
+        sum = 0.0;
+        count = 0;
+        for (auto power : gatingPowers)
+        {
+            auto loudness = powerToLoudness(power);
+            if (loudness > -70.f && loudness > relativeGate)
+            {
+                sum += power;
+                count++;
+            }
+        }
+        if (count == 0)
+            return getSilenceLoudness();
+        return powerToLoudness(sum / count);
+    }
+
+    void finishBlock()
+    {
+        blockPowers[numBlocks % numShortTermBlocks] = currentEnergy / subBlockLength;
+        numBlocks++;
+        currentEnergy = 0.0;
+        currentNumSamples = 0;
+
+        double momentaryPower = 0.0;
+        double shortTermPower = 0.0;
+        for (int i=0; i<numShortTermBlocks; i++)
+        {
+            auto power = blockPowers[(numBlocks - 1 - i + numShortTermBlocks) % numShortTermBlocks];
+            if (i < numMomentaryBlocks)
+                momentaryPower += power;
+            shortTermPower += power;
+        }
+        momentaryPower /= numMomentaryBlocks;
+        shortTermPower /= numShortTermBlocks;
+        momentaryLoudness.store(powerToLoudness(momentaryPower));
+        shortTermLoudness.store(powerToLoudness(shortTermPower));
+
+        if (numBlocks < numMomentaryBlocks)
+            return;
+
+        // the gating blocks go into a fixed size histogram, so nothing grows while playing
+        auto loudness = powerToLoudness(momentaryPower);
+        if (loudness > -70.f)
+        {
+            auto bin = jlimit(0, numHistogramBins - 1, static_cast<int>((loudness + 70.f) * 10.f));
+            histogramCounts[bin]++;
+            histogramPowers[bin] += momentaryPower;
+        }
+        integratedLoudness.store(getHistogramLoudness());
+    }
+
+    float getHistogramLoudness() const
+    {
+        double sum = 0.0;
+        int64 count = 0;
+        for (int bin=0; bin<numHistogramBins; bin++)
+        {
+            sum += histogramPowers[bin];
+            count += histogramCounts[bin];
+        }
+        if (count == 0)
+            return getSilenceLoudness();
+
+        auto relativeGate = powerToLoudness(sum / static_cast<double>(count)) - 10.f;
+        auto firstBin = jlimit(0, static_cast<int>(numHistogramBins), static_cast<int>(std::ceil((relativeGate + 70.f) * 10.f)));
+        sum = 0.0;
+        count = 0;
+        for (int bin=firstBin; bin<numHistogramBins; bin++)
+        {
+            sum += histogramPowers[bin];
+            count += histogramCounts[bin];
+        }
+        if (count == 0)
+            return getSilenceLoudness();
+        return powerToLoudness(sum / static_cast<double>(count));
+    }
+
+    KWeightingFilter filters[maxChannels];
+    TruePeakDetector truePeakDetectors[maxChannels];
+
+    int subBlockLength;
+    double blockPowers[numShortTermBlocks];
+    int64 numBlocks;
+    double currentEnergy;
+    int currentNumSamples;
+    float currentTruePeak;
+
+    int64 histogramCounts[numHistogramBins];
+    double histogramPowers[numHistogramBins];
+
+    std::atomic<float> momentaryLoudness {0.f};
+    std::atomic<float> shortTermLoudness {0.f};
+    std::atomic<float> integratedLoudness {0.f};
+    std::atomic<float> truePeak {0.f};
+
+    JUCE_DECLARE_NON_COPYABLE (LoudnessMeter)
+};
+
+/*! Per channel peak and RMS meter for the audio callback.
+\   Each block is reduced with the vectorized LevelSummary pass, then the
+\   results are published through atomics: the peak is accumulated until the
+\   meter component reads it, the RMS is smoothed over a 300ms window.
+*/
+class LevelMeter
+{
+public:
+    enum
+    {
+        maxChannels = 16
+    };
+
+    LevelMeter():
+    sampleRate(48000.0),
+    numChannels(0)
+    {
+        reset();
+    }
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        reset();
+    }
+
+    void reset()
+    {
+        for (int channel=0; channel<maxChannels; channel++)
+        {
+            meanSquares[channel] = 0.0;
+            peaks[channel].store(0.f);
+            rmsLevels[channel].store(0.f);
+        }
+    }
+
+    /*! Real-time safe, no allocation or locking
+    */
+    void process(const AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        auto channels = jmin(buffer.getNumChannels(), static_cast<int>(maxChannels));
+        auto smoothing = std::exp(-numSamples / (0.3 * sampleRate));
+        for (int channel=0; channel<channels; channel++)
+        {
+            auto levels = LevelSummary::fromSamples(buffer.getReadPointer(channel, startSample), numSamples);
+
+            auto previousPeak = peaks[channel].load();
+            while (levels.peak > previousPeak && !peaks[channel].compare_exchange_weak(previousPeak, levels.peak))
+            {
+            }
+
+            auto meanSquare = levels.sumOfSquares / numSamples;
+            meanSquares[channel] = smoothing * meanSquares[channel] + (1.0 - smoothing) * meanSquare;
+            rmsLevels[channel].store(static_cast<float>(std::sqrt(meanSquares[channel])));
+        }
+        numChannels.store(channels);
+    }
+
+    int getNumChannels() const
+    {
+        return numChannels.load();
+    }
+
+    /*! Returns the highest sample since the last call and starts collecting again
+    */
+    float getAndResetPeak(int channel)
+    {
+        return peaks[channel].exchange(0.f);
+    }
+
+    float getRMS(int channel) const
+    {
+        return rmsLevels[channel].load();
+    }
+
+private:
+    double sampleRate;
+    double meanSquares[maxChannels]; // only touched by the audio thread
+    std::atomic<float> peaks[maxChannels];
+    std::atomic<float> rmsLevels[maxChannels];
+    std::atomic<int> numChannels;
+
+    JUCE_DECLARE_NON_COPYABLE (LevelMeter)
+};
@@ -9,3 +9,182 @@
 */
 
 #pragma once
+
+#include <JuceHeader.h>
+#include "AudioProcessingComponent.h"
+
+class MeterVisualizer : public Component,
+                        private Timer
+{
+public:
+    MeterVisualizer(AudioProcessingComponent& c) :
+        apc(c),
+        fileLoudness(LoudnessMeter::getSilenceLoudness()),
+        fileTruePeak(LoudnessMeter::getSilenceLoudness()),
+        fileMeasured(false),
+        numMeterChannels(0)
+    {
+        for (int channel=0; channel<LevelMeter::maxChannels; channel++)
+        {
+            peakLevels[channel] = 0.f;
+            rmsLevels[channel] = 0.f;
+            peakHoldLevels[channel] = 0.f;
+            peakHoldTicks[channel] = 0;
+        }
+
+        setOpaque(true);
+        measureButton.setButtonText("Measure");
+        measureButton.setTooltip("measure the loudness of the whole file");
+        measureButton.onClick = [this] {measureButtonClicked(); };
+        addAndMakeVisible(measureButton);
+
+        startTimerHz(refreshRate);
+    }
+
+    ~MeterVisualizer()
+    {
+    }
+
+    void paint(Graphics& g) override
+    {
+        g.fillAll(Colour(32, 32, 32));
+
+        g.setColour(Colours::white);
+        g.setFont(12.0f);
+        auto textArea = getLocalBounds().reduced(5).withTrimmedBottom(30);
+        auto lineHeight = 16;
+
+        g.drawText("Loudness (LUFS)", textArea.removeFromTop(lineHeight), Justification::centredLeft);
+        paintValue(g, textArea.removeFromTop(lineHeight), "M", apc.getMomentaryLoudness());
+        paintValue(g, textArea.removeFromTop(lineHeight), "S", apc.getShortTermLoudness());
+        paintValue(g, textArea.removeFromTop(lineHeight), "I", apc.getIntegratedLoudness());
+        paintValue(g, textArea.removeFromTop(lineHeight), "TP", apc.getTruePeak());
+
+        if (fileMeasured)
+        {
+            textArea.removeFromTop(lineHeight / 2);
+            g.setColour(Colours::white);
+            g.drawText("File", textArea.removeFromTop(lineHeight), Justification::centredLeft);
+            paintValue(g, textArea.removeFromTop(lineHeight), "I", fileLoudness);
+            paintValue(g, textArea.removeFromTop(lineHeight), "TP", fileTruePeak);
+        }
+
+        paintLevelBars(g, textArea.withTrimmedTop(lineHeight / 2));
+    }
+
+    void resized() override
+    {
+        measureButton.setBounds(getLocalBounds().reduced(5).removeFromBottom(25));
+    }
+
+private:
+    enum
+    {
+        refreshRate = 30,
+        peakHoldLength = refreshRate * 3 / 2
+    };
+
+    /*! Reads the meter values published by the audio thread while playing,
+    \   otherwise shows the levels of the marked region from the level index
+    */
+    void timerCallback() override
+    {
+        auto& levelMeter = apc.getLevelMeter();
+        auto playing = apc.getState() == AudioProcessingComponent::Playing;
+        numMeterChannels = playing ? levelMeter.getNumChannels() : jmin(apc.getNumChannels(), static_cast<int>(LevelMeter::maxChannels));
+
+        for (int channel=0; channel<numMeterChannels; channel++)
+        {
+            if (playing)
+            {
+                // peaks fall by about 20 dB per second between blocks
+                auto decayedPeak = peakLevels[channel] * std::pow(0.1f, 1.f / refreshRate);
+                peakLevels[channel] = jmax(levelMeter.getAndResetPeak(channel), decayedPeak);
+                rmsLevels[channel] = levelMeter.getRMS(channel);
+            }
+            else
+            {
+                auto levels = apc.getMarkedRegionLevels(channel);
+                peakLevels[channel] = levels.peak;
+                rmsLevels[channel] = levels.getRMS();
+            }
+
+            if (peakLevels[channel] >= peakHoldLevels[channel] || --peakHoldTicks[channel] <= 0)
+            {
+                peakHoldLevels[channel] = peakLevels[channel];
+                peakHoldTicks[channel] = peakHoldLength;
+            }
+        }
+
+        repaint();
+    }
+
+    /*! Draws one vertical bar per channel, RMS solid, peak translucent
+    \   and the held peak as a line, on a -60 to 0 dBFS scale
+    */
+    void paintLevelBars(Graphics& g, Rectangle<int> area)
+    {
+        if (numMeterChannels == 0 || area.getHeight() <= 0)
+            return;
+
+        auto barWidth = area.getWidth() / numMeterChannels;
+        for (int channel=0; channel<numMeterChannels; channel++)
+        {
+            auto bar = area.removeFromLeft(barWidth).reduced(1, 0).toFloat();
+            g.setColour(Colour(48, 48, 48));
+            g.fillRect(bar);
+
+            g.setColour(Colours::limegreen.withAlpha(0.4f));
+            g.fillRect(bar.withTop(bar.getBottom() - bar.getHeight() * levelToProportion(peakLevels[channel])));
+            g.setColour(Colours::limegreen);
+            g.fillRect(bar.withTop(bar.getBottom() - bar.getHeight() * levelToProportion(rmsLevels[channel])));
+
+            g.setColour(peakHoldLevels[channel] >= 1.f ? Colours::red : Colours::white);
+            auto holdY = bar.getBottom() - bar.getHeight() * levelToProportion(peakHoldLevels[channel]);
+            g.drawHorizontalLine(roundToInt(holdY), bar.getX(), bar.getRight());
+        }
+    }
+
+    static float levelToProportion(float level)
+    {
+        return jlimit(0.f, 1.f, (Decibels::gainToDecibels(level, -60.f) + 60.f) / 60.f);
+    }
+
+    void paintValue(Graphics& g, Rectangle<int> area, const String& name, float value)
+    {
+        g.setColour(Colours::grey);
+        g.drawText(name, area.removeFromLeft(25), Justification::centredLeft);
+        g.setColour(Colours::white);
+        if (value <= LoudnessMeter::getSilenceLoudness())
+            g.drawText("-inf", area, Justification::centredRight);
+        else
+            g.drawText(String(value, 1), area, Justification::centredRight);
+    }
+
+    void measureButtonClicked()
+    {
+        if (apc.getNumChannels() == 0)
+            return;
+
+        auto result = apc.measureLoudness();
+        fileLoudness = result.integratedLoudness;
+        fileTruePeak = result.truePeak;
+        fileMeasured = true;
+        repaint();
+    }
+
+    AudioProcessingComponent& apc;
+    TextButton measureButton;
+
+    float fileLoudness;
+    float fileTruePeak;
+    bool fileMeasured;
+
+    int numMeterChannels;
+    float peakLevels[LevelMeter::maxChannels];
+    float rmsLevels[LevelMeter::maxChannels];
+    float peakHoldLevels[LevelMeter::maxChannels];
+    int peakHoldTicks[LevelMeter::maxChannels];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MeterVisualizer)
+};
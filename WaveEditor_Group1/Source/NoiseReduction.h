@@ -0,0 +1,233 @@
+/*
+  ==============================================================================
+
+    NoiseReduction.h
+    Created: 19 Oct 2026 7:32:52am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParallelUtils.h"
+
+/*! Mean noise power of every FFT bin, one spectrum per channel
+*/
+class NoiseProfile
+{
+public:
+    enum
+    {
+        fftOrder = 11,
+        fftSize = 1 << fftOrder,
+        numBins = fftSize / 2 + 1,
+        hop = fftSize / 4
+    };
+
+    NoiseProfile():
+    numChannels(0)
+    {
+    }
+
+    bool isEmpty() const
+    {
+        return numChannels == 0;
+    }
+
+    int getNumChannels() const
+    {
+        return numChannels;
+    }
+
+    /*! The noise power of the bins of a channel, channels the profile
+    \   doesn't have use the ones it has in turn
+    */
+    const float* getPowers(int channel) const
+    {
+        return powers.data() + (channel % numChannels) * numBins;
+    }
+
+    /*! Averages the power spectra of the Hann windowed frames of the buffer,
+    \   a buffer shorter than one frame is zero padded
+    */
+    void capture(const AudioBuffer<float>& buffer)
+    {
+        numChannels = buffer.getNumChannels();
+        powers.assign(static_cast<size_t>(numChannels * numBins), 0.f);
+        if (numChannels == 0)
+            return;
+
+        dsp::FFT fft (fftOrder);
+        HeapBlock<float> work (static_cast<size_t>(2 * fftSize), true);
+        auto window = getWindow();
+        auto numFrames = jmax(1, (buffer.getNumSamples() - fftSize) / hop + 1);
+        for (int channel=0; channel<numChannels; channel++)
+        {
+            auto channelPowers = powers.data() + channel * numBins;
+            for (int frame=0; frame<numFrames; frame++)
+            {
+                auto numFrameSamples = jmin(static_cast<int>(fftSize), buffer.getNumSamples() - frame * hop);
+                FloatVectorOperations::clear(work.get(), 2 * fftSize);
+                FloatVectorOperations::multiply(work.get(), buffer.getReadPointer(channel, frame * hop), window, numFrameSamples);
+                fft.performRealOnlyForwardTransform(work.get(), true);
+                for (int bin=0; bin<numBins; bin++)
+                    channelPowers[bin] += (work[2 * bin] * work[2 * bin] + work[2 * bin + 1] * work[2 * bin + 1]) / numFrames;
+            }
+        }
+    }
+
+    /*! Periodic Hann, which sums to 1.5 at 4x overlap when applied twice
+    */
+    static const float* getWindow()
+    {
+        static const std::vector<float> window = [] {
+            std::vector<float> values (static_cast<size_t>(fftSize));
+            for (int i=0; i<fftSize; i++)
+                values[static_cast<size_t>(i)] = static_cast<float>(0.5 - 0.5 * std::cos(MathConstants<double>::twoPi * i / fftSize));
+            return values;
+        }();
+        return window.data();
+    }
+
+private:
+    int numChannels;
+    std::vector<float> powers;
+};
+
+/*! Power spectral subtraction against a NoiseProfile. Each bin keeps the
+\   share of its power that is above the scaled noise power, a Wiener style
+\   gain that is smoothed over neighbouring bins against musical noise and
+\   never goes below the reduction floor.
+\
+\   The gain of a frame only depends on that frame, so the frames are split
+\   into batches that run on parallel workers. A batch writes only the output
+\   samples it owns and recomputes the few frames that overlap the batch
+\   before it. Every worker allocates its FFT and buffers once.
+*/
+class SpectralNoiseReducer
+{
+public:
+    enum
+    {
+        framesPerBatch = 128
+    };
+
+    /*! Reduces the noise of input into output, which has the same size but
+    \   must not share its samples
+        @param float how far noise is pushed down, in dB
+        @param float how many times the profile power is subtracted
+    */
+    static void process(const AudioBuffer<float>& input, AudioBuffer<float>& output, const NoiseProfile& profile,
+                        float reductionDb, float sensitivity)
+    {
+        if (profile.isEmpty())
+            return;
+
+        const int fftSize = NoiseProfile::fftSize;
+        const int hop = NoiseProfile::hop;
+        auto numSamples = input.getNumSamples();
+        auto numChannels = jmin(input.getNumChannels(), output.getNumChannels());
+        auto samplesPerBatch = framesPerBatch * hop;
+        auto numBatchesPerChannel = (numSamples + samplesPerBatch - 1) / samplesPerBatch;
+        auto numBatches = numChannels * numBatchesPerChannel;
+        auto floorGain = Decibels::decibelsToGain(-std::abs(reductionDb));
+
+        std::atomic<int> nextBatch (0);
+        ParallelUtils::parallelFor(jmin(numBatches, ParallelUtils::getNumWorkers()), [&](int) {
+            Workspace workspace (samplesPerBatch + 2 * fftSize);
+            int batch;
+            while ((batch = nextBatch.fetch_add(1)) < numBatches)
+            {
+                auto channel = batch / numBatchesPerChannel;
+                auto batchStart = (batch % numBatchesPerChannel) * samplesPerBatch;
+                auto batchLength = jmin(samplesPerBatch, numSamples - batchStart);
+                processBatch(workspace, input.getReadPointer(channel), numSamples, profile.getPowers(channel),
+                             floorGain, sensitivity, batchStart, batchLength, output.getWritePointer(channel, batchStart));
+            }
+        });
+    }
+
+private:
+    struct Workspace
+    {
+        Workspace(int accumulatorSize):
+        fft(NoiseProfile::fftOrder),
+        work(static_cast<size_t>(2 * NoiseProfile::fftSize), true),
+        gains(static_cast<size_t>(NoiseProfile::numBins), true),
+        smoothedGains(static_cast<size_t>(NoiseProfile::numBins), true),
+        accumulator(static_cast<size_t>(accumulatorSize), true),
+        accumulatorSize(accumulatorSize)
+        {
+        }
+
+        dsp::FFT fft;
+        HeapBlock<float> work;
+        HeapBlock<float> gains;
+        HeapBlock<float> smoothedGains;
+        HeapBlock<float> accumulator;
+        int accumulatorSize;
+    };
+
+    /*! Frame k covers [k * hop - fftSize + hop, k * hop + hop), so every output
+    \   sample gets all four overlapping frames, even at the edges
+    */
+    static void processBatch(Workspace& workspace, const float* input, int numSamples, const float* noisePowers,
+                             float floorGain, float sensitivity, int batchStart, int batchLength, float* output)
+    {
+        const int fftSize = NoiseProfile::fftSize;
+        const int hop = NoiseProfile::hop;
+        const int numBins = NoiseProfile::numBins;
+        auto window = NoiseProfile::getWindow();
+        auto work = workspace.work.get();
+        auto accumulatorStart = batchStart - fftSize + hop;
+        FloatVectorOperations::clear(workspace.accumulator.get(), workspace.accumulatorSize);
+
+        auto firstFrame = batchStart / hop;
+        auto lastFrame = (batchStart + batchLength - 1 + fftSize - hop) / hop;
+        for (int frame=firstFrame; frame<=lastFrame; frame++)
+        {
+            auto frameStart = frame * hop - fftSize + hop;
+            auto first = jlimit(0, fftSize, -frameStart);
+            auto last = jlimit(first, fftSize, numSamples - frameStart);
+            FloatVectorOperations::clear(work, 2 * fftSize);
+            if (last > first)
+                FloatVectorOperations::multiply(work + first, input + frameStart + first, window + first, last - first);
+            workspace.fft.performRealOnlyForwardTransform(work, true);
+
+            for (int bin=0; bin<numBins; bin++)
+            {
+                auto power = work[2 * bin] * work[2 * bin] + work[2 * bin + 1] * work[2 * bin + 1];
+                auto noise = sensitivity * noisePowers[bin];
+                workspace.gains[bin] = power > noise ? 1.f - noise / power : 0.f;
+            }
+            workspace.smoothedGains[0] = workspace.gains[0];
+            workspace.smoothedGains[numBins - 1] = workspace.gains[numBins - 1];
+            for (int bin=1; bin<numBins-1; bin++)
+                workspace.smoothedGains[bin] = 0.25f * workspace.gains[bin - 1] + 0.5f * workspace.gains[bin] + 0.25f * workspace.gains[bin + 1];
+
+            for (int bin=0; bin<numBins; bin++)
+            {
+                auto gain = jmax(floorGain, workspace.smoothedGains[bin]);
+                work[2 * bin] *= gain;
+                work[2 * bin + 1] *= gain;
+            }
+            // the inverse transform expects the full conjugate symmetric spectrum
+            for (int bin=numBins; bin<fftSize; bin++)
+            {
+                work[2 * bin] = work[2 * (fftSize - bin)];
+                work[2 * bin + 1] = -work[2 * (fftSize - bin) + 1];
+            }
+            workspace.fft.performRealOnlyInverseTransform(work);
+
+            FloatVectorOperations::multiply(work, window, fftSize);
+            FloatVectorOperations::addWithMultiply(workspace.accumulator.get() + (frameStart - accumulatorStart), work, 1.f / 1.5f, fftSize);
+        }
+
+        FloatVectorOperations::copy(output, workspace.accumulator.get() + (batchStart - accumulatorStart), batchLength);
+    }
+
+    SpectralNoiseReducer(){};
+    ~SpectralNoiseReducer(){};
+};
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    NoiseReductionVisualizer.h
+    Created: 19 Oct 2026 7:32:52am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioProcessingComponent.h"
+
+/*! Capture takes the noise profile from the current selection, Apply
+\   reduces the noise in whatever is selected then
+*/
+class NoiseReductionVisualizer : public Component
+{
+public:
+    NoiseReductionVisualizer(AudioProcessingComponent& c) :
+        apc(c)
+    {
+        captureButton.setButtonText("Capture Noise Profile");
+        captureButton.onClick = [this] {captureButtonClicked(); };
+        addAndMakeVisible(captureButton);
+
+        reductionSlider.setSliderStyle(Slider::LinearBar);
+        reductionSlider.setRange(0.0, 40.0, 0.5);
+        reductionSlider.setTextValueSuffix(" dB reduction");
+        reductionSlider.setValue(12.0, dontSendNotification);
+        reductionSlider.setDoubleClickReturnValue(true, 12.0);
+        addAndMakeVisible(reductionSlider);
+
+        sensitivitySlider.setSliderStyle(Slider::LinearBar);
+        sensitivitySlider.setRange(0.5, 4.0, 0.1);
+        sensitivitySlider.setTextValueSuffix("x noise");
+        sensitivitySlider.setValue(1.5, dontSendNotification);
+        sensitivitySlider.setDoubleClickReturnValue(true, 1.5);
+        addAndMakeVisible(sensitivitySlider);
+
+        applyButton.setButtonText("Apply");
+        applyButton.onClick = [this] {apc.reduceNoiseInMarkedRegion(static_cast<float>(reductionSlider.getValue()),
+                                                                    static_cast<float>(sensitivitySlider.getValue())); };
+        addAndMakeVisible(applyButton);
+
+        updateButtons();
+        setSize(320, 165);
+    }
+
+    void paint(Graphics& g) override
+    {
+        g.fillAll(Colour(32, 32, 32));
+        g.setColour(Colours::grey);
+        g.setFont(12.0f);
+        g.drawText(apc.hasNoiseProfile() ? "profile captured" : "select noise only, then capture",
+                   10, 40, getWidth() - 20, 20, Justification::centredLeft);
+        g.drawText("amount", 10, 65, 50, 25, Justification::centredLeft);
+        g.drawText("subtract", 10, 95, 50, 25, Justification::centredLeft);
+    }
+
+    void resized() override
+    {
+        captureButton.setBounds(10, 10, getWidth() - 20, 25);
+        reductionSlider.setBounds(60, 65, getWidth() - 70, 25);
+        sensitivitySlider.setBounds(60, 95, getWidth() - 70, 25);
+        applyButton.setBounds(getWidth() - 110, getHeight() - 35, 100, 25);
+    }
+
+private:
+    void captureButtonClicked()
+    {
+        apc.captureNoiseProfile();
+        updateButtons();
+        repaint();
+    }
+
+    void updateButtons()
+    {
+        applyButton.setEnabled(apc.hasNoiseProfile());
+    }
+
+    AudioProcessingComponent& apc;
+    TextButton captureButton;
+    Slider reductionSlider;
+    Slider sensitivitySlider;
+    TextButton applyButton;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoiseReductionVisualizer)
+};
@@ -0,0 +1,414 @@
+/*
+  ==============================================================================
+
+    OnsetIndex.h
+    Created: 19 Oct 2026 7:45:31am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParallelUtils.h"
+
+struct OnsetSettings
+{
+    float threshold = 0.15f;        // flux above the local mean that makes an onset
+    double minIntervalMs = 50.0;    // onsets closer than this to the previous one are dropped
+};
+
+/*! Onset detection by spectral flux: the rise of the log magnitude spectrum
+\   of the channel mix from one frame to the next, summed over the bins.
+\   Onsets are local maxima of the flux that rise above the mean flux around
+\   them by the threshold. Frame k covers [k * hop, k * hop + fftSize), the
+\   same grid for any range, so detecting a range gives the same onsets as
+\   detecting the whole file.
+*/
+class OnsetDetector
+{
+public:
+    enum
+    {
+        fftOrder = 10,
+        fftSize = 1 << fftOrder,
+        numBins = fftSize / 2 + 1,
+        hop = fftSize / 4,
+        peakRadius = 3,             // frames an onset must be the maximum of on both sides
+        meanRadius = 16,            // frames on both sides of the local mean
+        positionOffset = fftSize / 2 + hop  // from the frame start to where a sharp attack makes the flux peak
+    };
+
+    /*! Number of samples around a range whose audio changes the onsets in it
+    */
+    static int getContextLength()
+    {
+        return fftSize + meanRadius * hop;
+    }
+
+    /*! Spectral flux of frames [firstFrame, firstFrame+numFrames), the frames
+    \   are split into chunks that run in parallel
+    */
+    static void computeFlux(const AudioBuffer<float>& audio, int firstFrame, int numFrames, float* flux)
+    {
+        ParallelUtils::parallelForChunks(numFrames, 32, [&](int start, int length) {
+            dsp::FFT fft (fftOrder);
+            HeapBlock<float> work (static_cast<size_t>(2 * fftSize), true);
+            HeapBlock<float> previous (static_cast<size_t>(numBins), true);
+            HeapBlock<float> current (static_cast<size_t>(numBins), true);
+            // the flux of the first frame needs the spectrum of the one before it
+            computeMagnitudes(audio, firstFrame + start - 1, fft, work, previous);
+            for (int i=start; i<start+length; i++)
+            {
+                computeMagnitudes(audio, firstFrame + i, fft, work, current);
+                float sum = 0.f;
+                for (int bin=0; bin<numBins; bin++)
+                    sum += jmax(0.f, current[bin] - previous[bin]);
+                flux[i] = sum / numBins;
+                previous.swapWith(current);
+            }
+        });
+    }
+
+    /*! Appends the onsets in [startSample, startSample+numSamples) to onsets,
+    \   sorted
+    */
+    static void detect(const AudioBuffer<float>& audio, int startSample, int numSamples, double sampleRate,
+                       const OnsetSettings& settings, std::vector<int>& onsets)
+    {
+        // frames running past the end see the audio cut off, which reads as an attack
+        auto numFullFrames = (audio.getNumSamples() - fftSize) / hop + 1;
+        auto firstFrame = jmax(0, divideRoundingUp(startSample - positionOffset, hop));
+        auto endFrame = jlimit(firstFrame, jmax(firstFrame, numFullFrames), divideRoundingUp(startSample + numSamples - positionOffset, hop));
+        if (firstFrame >= endFrame)
+            return;
+
+        // the flux with enough frames around the range for the peak and mean windows
+        auto fluxStart = jmax(0, firstFrame - static_cast<int>(meanRadius));
+        auto fluxEnd = endFrame + meanRadius;
+        std::vector<float> flux (static_cast<size_t>(fluxEnd - fluxStart));
+        computeFlux(audio, fluxStart, fluxEnd - fluxStart, flux.data());
+        auto fluxAt = [&flux, fluxStart](int frame) { return frame < fluxStart ? 0.f : flux[static_cast<size_t>(frame - fluxStart)]; };
+
+        auto minInterval = static_cast<int>(settings.minIntervalMs * sampleRate / 1000.0);
+        auto lastOnset = onsets.empty() ? std::numeric_limits<int>::min() / 2 : onsets.back();
+        for (int frame=firstFrame; frame<endFrame; frame++)
+        {
+            auto value = fluxAt(frame);
+            auto isPeak = value > 0.f;
+            for (int i=1; isPeak && i<=peakRadius; i++)
+                isPeak = value > fluxAt(frame - i) && value >= fluxAt(frame + i);
+            if (!isPeak)
+                continue;
+
+            float mean = 0.f;
+            for (int i=-meanRadius; i<=meanRadius; i++)
+                mean += fluxAt(frame + i);
+            mean /= 2 * meanRadius + 1;
+            auto position = frame * hop + positionOffset;
+            if (value > mean + settings.threshold && position - lastOnset >= minInterval)
+            {
+                onsets.push_back(position);
+                lastOnset = position;
+            }
+        }
+    }
+
+private:
+    static int divideRoundingUp(int value, int divisor)
+    {
+        return value >= 0 ? (value + divisor - 1) / divisor : -((-value) / divisor);
+    }
+
+    /*! Log magnitudes of one Hann windowed frame of the channel mix, zero
+    \   outside the audio
+    */
+    static void computeMagnitudes(const AudioBuffer<float>& audio, int frame, dsp::FFT& fft, float* work, float* magnitudes)
+    {
+        auto window = getWindow();
+        auto frameStart = frame * hop;
+        auto first = jlimit(0, static_cast<int>(fftSize), -frameStart);
+        auto last = jlimit(first, static_cast<int>(fftSize), audio.getNumSamples() - frameStart);
+        FloatVectorOperations::clear(work, 2 * fftSize);
+        if (last > first)
+        {
+            auto gain = 1.f / audio.getNumChannels();
+            for (int channel=0; channel<audio.getNumChannels(); channel++)
+                FloatVectorOperations::addWithMultiply(work + first, audio.getReadPointer(channel, frameStart + first), gain, last - first);
+            FloatVectorOperations::multiply(work + first, window + first, last - first);
+        }
+        fft.performFrequencyOnlyForwardTransform(work);
+        for (int bin=0; bin<numBins; bin++)
+            magnitudes[bin] = std::log(1.f + 10.f * work[bin]);
+    }
+
+    static const float* getWindow()
+    {
+        static const std::vector<float> window = [] {
+            std::vector<float> values (static_cast<size_t>(fftSize));
+            for (int i=0; i<fftSize; i++)
+                values[static_cast<size_t>(i)] = static_cast<float>(0.5 - 0.5 * std::cos(MathConstants<double>::twoPi * i / fftSize));
+            return values;
+        }();
+        return window.data();
+    }
+
+    OnsetDetector(){};
+    ~OnsetDetector(){};
+};
+
+/*! Sorted onset positions of the document, detected by a background thread.
+\   The file is detected in segments, and an edit only queues the audio it
+\   changed plus the context around it, while the onsets after it move with
+\   the audio (they keep the frame grid they were found on, so they can be up
+\   to a hop away from where a fresh detection would put them). Queries are
+\   safe from the message thread at any time and see the onsets found so far.
+\
+\   The thread reads the audio buffer, so stopBuilding() must be called
+\   before the buffer is changed and update() after.
+*/
+class OnsetIndex : private Thread
+{
+public:
+    enum
+    {
+        samplesPerSegment = 1 << 17
+    };
+
+    OnsetIndex():
+    Thread("Onset Index"),
+    source(nullptr),
+    sampleRate(0.0)
+    {
+    }
+
+    ~OnsetIndex()
+    {
+        stopBuilding();
+    }
+
+    void rebuild(const AudioBuffer<float>& audioBuffer, double newSampleRate)
+    {
+        stopBuilding();
+        source = &audioBuffer;
+        sampleRate = newSampleRate;
+        {
+            const ScopedLock sl (lock);
+            onsets.clear();
+            pending.clear();
+            if (source->getNumSamples() > 0 && source->getNumChannels() > 0)
+                pending.push_back({0, source->getNumSamples()});
+        }
+        startThread(3);
+    }
+
+    void setSettings(const OnsetSettings& newSettings)
+    {
+        stopBuilding();
+        settings = newSettings;
+        if (source != nullptr)
+            rebuild(*source, sampleRate);
+    }
+
+    const OnsetSettings& getSettings() const
+    {
+        return settings;
+    }
+
+    /*! Called after numRemoved samples starting at startSample have been
+    \   replaced by numInserted samples
+    */
+    void update(int startSample, int numRemoved, int numInserted, double newSampleRate)
+    {
+        stopBuilding();
+        if (source == nullptr)
+            return;
+        if (newSampleRate != sampleRate)
+        {
+            rebuild(*source, newSampleRate);
+            return;
+        }
+
+        auto delta = numInserted - numRemoved;
+        auto removedEnd = startSample + numRemoved;
+        auto movePosition = [startSample, removedEnd, delta](int position) {
+            if (position < startSample)
+                return position;
+            return position >= removedEnd ? position + delta : startSample;
+        };
+        {
+            const ScopedLock sl (lock);
+            // onsets in the replaced audio are gone, later ones move with the audio
+            std::vector<int> moved;
+            moved.reserve(onsets.size());
+            for (auto onset : onsets)
+                if (onset < startSample || onset >= removedEnd)
+                    moved.push_back(movePosition(onset));
+            onsets.swap(moved);
+
+            for (auto& range : pending)
+                range = {movePosition(range.getStart()), movePosition(range.getEnd())};
+            auto context = OnsetDetector::getContextLength();
+            pending.push_back({jmax(0, startSample - context), jmin(source->getNumSamples(), startSample + numInserted + context)});
+            mergePending();
+        }
+        startThread(3);
+    }
+
+    /*! Like update() for in-place edits of several ranges, with one restart
+    \   of the background pass
+    */
+    void update(const std::vector<Range<int>>& changedRanges)
+    {
+        stopBuilding();
+        if (source == nullptr)
+            return;
+        {
+            const ScopedLock sl (lock);
+            auto context = OnsetDetector::getContextLength();
+            for (auto& range : changedRanges)
+                pending.push_back({jmax(0, range.getStart() - context), jmin(source->getNumSamples(), range.getEnd() + context)});
+            mergePending();
+        }
+        startThread(3);
+    }
+
+    /*! Call before the audio buffer is changed
+    */
+    void stopBuilding()
+    {
+        stopThread(2000);
+    }
+
+    /*! Waits for the background pass, returns true if every pending range is done
+    */
+    bool waitUntilBuilt(int timeOutMilliseconds)
+    {
+        return waitForThreadToExit(timeOutMilliseconds);
+    }
+
+    /*! Number of samples still waiting for detection
+    */
+    int getNumPendingSamples() const
+    {
+        const ScopedLock sl (lock);
+        int numPending = 0;
+        for (auto& range : pending)
+            numPending += range.getLength();
+        return numPending;
+    }
+
+    /*! The onsets in [startSample, startSample+numSamples)
+    */
+    std::vector<int> getOnsets(int startSample, int numSamples) const
+    {
+        const ScopedLock sl (lock);
+        auto first = std::lower_bound(onsets.begin(), onsets.end(), startSample);
+        auto last = std::lower_bound(first, onsets.end(), startSample + numSamples);
+        return std::vector<int>(first, last);
+    }
+
+    /*! The onset nearest to position and at most maxDistance samples away,
+    \   -1 if there is none
+    */
+    int getNearest(int position, int maxDistance) const
+    {
+        const ScopedLock sl (lock);
+        auto after = std::lower_bound(onsets.begin(), onsets.end(), position);
+        auto nearest = -1;
+        if (after != onsets.end() && *after - position <= maxDistance)
+            nearest = *after;
+        if (after != onsets.begin() && position - *(after - 1) <= maxDistance
+            && (nearest < 0 || position - *(after - 1) <= nearest - position))
+            nearest = *(after - 1);
+        return nearest;
+    }
+
+    /*! The audio from the onset at or before position up to the next onset,
+    \   from the start or to the end of the file where there is none
+    */
+    Range<int> getSliceAt(int position) const
+    {
+        const ScopedLock sl (lock);
+        auto next = std::upper_bound(onsets.begin(), onsets.end(), position);
+        auto start = next == onsets.begin() ? 0 : *(next - 1);
+        auto end = next == onsets.end() ? (source == nullptr ? 0 : source->getNumSamples()) : *next;
+        return {start, jmax(start, end)};
+    }
+
+private:
+    void mergePending()
+    {
+        std::sort(pending.begin(), pending.end(), [](const Range<int>& a, const Range<int>& b) { return a.getStart() < b.getStart(); });
+        std::vector<Range<int>> merged;
+        for (auto& range : pending)
+        {
+            if (range.isEmpty())
+                continue;
+            if (!merged.empty() && range.getStart() <= merged.back().getEnd())
+                merged.back() = merged.back().getUnionWith(range);
+            else
+                merged.push_back(range);
+        }
+        pending.swap(merged);
+    }
+
+    void run() override
+    {
+        for (;;)
+        {
+            Range<int> segment;
+            {
+                const ScopedLock sl (lock);
+                if (pending.empty())
+                    return;
+                segment = pending.front().withLength(jmin(pending.front().getLength(), static_cast<int>(samplesPerSegment)));
+            }
+
+            std::vector<int> found;
+            OnsetDetector::detect(*source, segment.getStart(), segment.getLength(), sampleRate, settings, found);
+            if (threadShouldExit())
+                return;
+
+            const ScopedLock sl (lock);
+            auto first = std::lower_bound(onsets.begin(), onsets.end(), segment.getStart());
+            auto last = std::lower_bound(first, onsets.end(), segment.getEnd());
+            auto index = static_cast<size_t>(first - onsets.begin());
+            first = onsets.erase(first, last);
+            onsets.insert(first, found.begin(), found.end());
+            enforceMinInterval(index == 0 ? 0 : index - 1, index + found.size() + 1);
+
+            pending.front().setStart(segment.getEnd());
+            if (pending.front().isEmpty())
+                pending.erase(pending.begin());
+        }
+    }
+
+    /*! Drops onsets closer than the minimum interval to the one before them,
+    \   around the seams of a detected segment
+    */
+    void enforceMinInterval(size_t first, size_t last)
+    {
+        auto minInterval = static_cast<int>(settings.minIntervalMs * sampleRate / 1000.0);
+        for (size_t i=first+1; i<=last && i<onsets.size(); )
+        {
+            if (onsets[i] - onsets[i - 1] < minInterval)
+            {
+                onsets.erase(onsets.begin() + static_cast<std::ptrdiff_t>(i));
+                last--;
+            }
+            else
+                i++;
+        }
+    }
+
+    const AudioBuffer<float>* source;
+    double sampleRate;
+    OnsetSettings settings;
+    CriticalSection lock;           // guards onsets and pending
+    std::vector<int> onsets;
+    std::vector<Range<int>> pending;
+
+    JUCE_DECLARE_NON_COPYABLE (OnsetIndex)
+};
@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    ParallelUtils.h
+    Created: 19 Oct 2026 7:01:02am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class ParallelUtils
+{
+public:
+    /*! Runs task(0) ... task(numTasks-1) on the shared thread pool and returns
+    \   when all of them are done. The calling thread works on the tasks too, so
+    \   it is safe to call this from inside another task.
+    */
+    static void parallelFor(int numTasks, const std::function<void(int)>& task)
+    {
+        if (numTasks <= 0)
+            return;
+        if (numTasks == 1)
+        {
+            task(0);
+            return;
+        }
+
+        auto state = std::make_shared<SharedState>();
+        state->task = task;
+        state->numTasks = numTasks;
+
+        auto runTasks = [state]()
+        {
+            for (;;)
+            {
+                auto taskIndex = state->nextTask++;
+                if (taskIndex >= state->numTasks)
+                    return;
+                state->task(taskIndex);
+                if (++state->numCompleted == state->numTasks)
+                    state->finished.signal();
+            }
+        };
+
+        auto& pool = getThreadPool();
+        auto numHelpers = jmin(numTasks, pool.getNumThreads()) - 1;
+        for (int i=0; i<numHelpers; i++)
+            pool.addJob(std::function<void()>(runTasks));
+
+        runTasks();
+        state->finished.wait();
+    }
+
+    /*! Splits [0, numItems) into chunks of at least minChunkSize items and
+    \   runs task(start, length) for every chunk in parallel
+    */
+    static void parallelForChunks(int numItems, int minChunkSize, const std::function<void(int, int)>& task)
+    {
+        if (numItems <= 0)
+            return;
+        auto numChunks = jlimit(1, getNumWorkers() * 4, numItems / jmax(1, minChunkSize));
+        auto chunkSize = (numItems + numChunks - 1) / numChunks;
+        numChunks = (numItems + chunkSize - 1) / chunkSize;
+        parallelFor(numChunks, [&task, numItems, chunkSize](int chunk) {
+            auto start = chunk * chunkSize;
+            task(start, jmin(chunkSize, numItems - start));
+        });
+    }
+
+    static int getNumWorkers()
+    {
+        return getThreadPool().getNumThreads();
+    }
+
+    static ThreadPool& getThreadPool()
+    {
+        static ThreadPool pool (jmax(1, SystemStats::getNumCpus()));
+        return pool;
+    }
+
+private:
+    struct SharedState
+    {
+        std::function<void(int)> task;
+        std::atomic<int> nextTask {0};
+        std::atomic<int> numCompleted {0};
+        int numTasks = 0;
+        WaitableEvent finished;
+    };
+
+    ParallelUtils(){};
+    ~ParallelUtils(){};
+};
@@ -0,0 +1,285 @@
+/*
+  ==============================================================================
+
+    PlaybackReader.h
+    Created: 19 Oct 2026 7:14:57am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*! Stages the samples the playback resampler reads next. With looping on,
+\   the stream wraps from the loop end to the loop start at the exact sample,
+\   so the resampler sees one continuous signal and its history carries over
+\   the loop point. The optional crossfade blends the last samples before the
+\   loop end with the samples leading up to the loop start, so the stream
+\   arrives at the loop start already on the material that follows it.
+\   When there is less audio before the loop start than the crossfade needs,
+\   e.g. a loop from the start of the file, the fade moves behind the wrap:
+\   the first samples of the loop fade in over the audio that follows the
+\   loop end. That blend is also heard the first time the loop start plays.
+\
+\   In reverse the stream runs backwards from the sample before position and
+\   everything is mirrored: the wrap goes from the loop start to the loop end
+\   and the fade in material is the audio just after the loop end, or the
+\   fade moves behind the wrap when the loop reaches the end of the file.
+*/
+class PlaybackReader
+{
+public:
+    enum
+    {
+        fadeTableSize = 1024
+    };
+
+    PlaybackReader()
+    {
+        // quarter sine, the fade in gain, the fade out gain is read backwards
+        for (int i=0; i<fadeTableSize; i++)
+            fadeTable[i] = std::sin(MathConstants<float>::halfPi * i / (fadeTableSize - 1));
+    }
+    ~PlaybackReader(){}
+
+    /*! Allocates the staging buffer, not real-time safe
+    */
+    void prepare(int numChannels, int maxSamples)
+    {
+        stagingBuffer.setSize(numChannels, maxSamples);
+        stagingBuffer.clear();
+    }
+
+    int getCapacity() const
+    {
+        return stagingBuffer.getNumSamples();
+    }
+
+    const AudioBuffer<float>& getBuffer() const
+    {
+        return stagingBuffer;
+    }
+
+    /*! Copies up to numSamples samples of the stream starting at position into
+    \   the staging buffer. Without looping the stream runs to the end of the
+    \   source (or its start in reverse), with looping it never ends. Real-time safe.
+        @return the number of samples staged
+    */
+    int read(const AudioBuffer<float>& source, int position, int loopStart, int loopEnd,
+             bool looping, int crossfadeLength, int numSamples, bool reverse = false)
+    {
+        numSamples = jmin(numSamples, stagingBuffer.getNumSamples());
+        looping = looping && loopEnd > loopStart;
+        if (reverse)
+            return readReverse(source, position, loopStart, loopEnd, looping, crossfadeLength, numSamples);
+
+        auto numChannels = jmin(source.getNumChannels(), stagingBuffer.getNumChannels());
+        auto fadeAfterWrap = false;
+        if (looping)
+        {
+            // the pre-roll before the loop start is the fade in material,
+            // without enough of it the audio after the loop end fades out instead
+            auto postRoll = source.getNumSamples() - loopEnd;
+            fadeAfterWrap = loopStart < crossfadeLength && postRoll > loopStart;
+            crossfadeLength = jmin(crossfadeLength, fadeAfterWrap ? postRoll : loopStart, loopEnd - loopStart);
+            position = wrap(position, loopStart, loopEnd);
+        }
+
+        int numStaged = 0;
+        while (numStaged < numSamples)
+        {
+            auto segmentEnd = looping ? loopEnd : source.getNumSamples();
+            if (position >= segmentEnd || position < 0)
+                break;
+
+            auto numThisTime = jmin(numSamples - numStaged, segmentEnd - position);
+            for (int channel=0; channel<numChannels; channel++)
+                stagingBuffer.copyFrom(channel, numStaged, source, channel, position, numThisTime);
+
+            if (looping && crossfadeLength > 0 && fadeAfterWrap)
+                applyCrossfadeAfterWrap(source, numChannels, position, numThisTime, numStaged, loopStart, loopEnd, crossfadeLength);
+            else if (looping && crossfadeLength > 0)
+                applyCrossfade(source, numChannels, position, numThisTime, numStaged, loopStart, loopEnd, crossfadeLength);
+
+            numStaged += numThisTime;
+            position += numThisTime;
+            if (looping && position == loopEnd)
+                position = loopStart;
+        }
+        return numStaged;
+    }
+
+    /*! The stream position numSamples samples after position
+    */
+    static int advance(int position, int numSamples, int loopStart, int loopEnd, bool looping, bool reverse = false)
+    {
+        looping = looping && loopEnd > loopStart;
+        if (reverse)
+        {
+            position -= numSamples;
+            return looping ? wrapReverse(position, loopStart, loopEnd) : position;
+        }
+        position += numSamples;
+        return looping ? wrap(position, loopStart, loopEnd) : position;
+    }
+
+private:
+    /*! Positions at or past the loop end map back into the loop
+    */
+    static int wrap(int position, int loopStart, int loopEnd)
+    {
+        if (position < loopEnd)
+            return position;
+        return loopStart + (position - loopEnd) % (loopEnd - loopStart);
+    }
+
+    /*! In reverse the next sample is position - 1, so positions at or before
+    \   the loop start map back into (loopStart, loopEnd]
+    */
+    static int wrapReverse(int position, int loopStart, int loopEnd)
+    {
+        if (position > loopStart)
+            return position;
+        return loopEnd - (loopStart - position) % (loopEnd - loopStart);
+    }
+
+    int readReverse(const AudioBuffer<float>& source, int position, int loopStart, int loopEnd,
+                    bool looping, int crossfadeLength, int numSamples)
+    {
+        auto numChannels = jmin(source.getNumChannels(), stagingBuffer.getNumChannels());
+        auto fadeAfterWrap = false;
+        if (looping)
+        {
+            auto postRoll = source.getNumSamples() - loopEnd;
+            fadeAfterWrap = postRoll < crossfadeLength && loopStart > postRoll;
+            crossfadeLength = jmin(crossfadeLength, fadeAfterWrap ? loopStart : postRoll, loopEnd - loopStart);
+            position = wrapReverse(position, loopStart, loopEnd);
+        }
+
+        int numStaged = 0;
+        while (numStaged < numSamples)
+        {
+            auto segmentStart = looping ? loopStart : 0;
+            if (position <= segmentStart || position > source.getNumSamples())
+                break;
+
+            auto numThisTime = jmin(numSamples - numStaged, position - segmentStart);
+            for (int channel=0; channel<numChannels; channel++)
+            {
+                auto sourcePointer = source.getReadPointer(channel, position - numThisTime);
+                auto destPointer = stagingBuffer.getWritePointer(channel, numStaged);
+                for (int i=0; i<numThisTime; i++)
+                    destPointer[i] = sourcePointer[numThisTime - 1 - i];
+            }
+
+            if (looping && crossfadeLength > 0 && fadeAfterWrap)
+                applyReverseCrossfadeAfterWrap(source, numChannels, position, numThisTime, numStaged, loopStart, loopEnd, crossfadeLength);
+            else if (looping && crossfadeLength > 0)
+                applyReverseCrossfade(source, numChannels, position, numThisTime, numStaged, loopStart, loopEnd, crossfadeLength);
+
+            numStaged += numThisTime;
+            position -= numThisTime;
+            if (looping && position == loopStart)
+                position = loopEnd;
+        }
+        return numStaged;
+    }
+
+    float getFadeInGain(float proportion) const
+    {
+        auto index = proportion * (fadeTableSize - 1);
+        auto lower = jlimit(0, static_cast<int>(fadeTableSize) - 2, static_cast<int>(index));
+        return fadeTable[lower] + (fadeTable[lower + 1] - fadeTable[lower]) * (index - lower);
+    }
+
+    /*! Equal power blend of the staged samples inside [loopEnd - crossfadeLength, loopEnd)
+    \   with the samples the same distance before the loop start
+    */
+    void applyCrossfade(const AudioBuffer<float>& source, int numChannels, int position, int numSamples,
+                        int stagingOffset, int loopStart, int loopEnd, int crossfadeLength)
+    {
+        auto fadeStart = loopEnd - crossfadeLength;
+        auto first = jmax(position, fadeStart);
+        auto last = jmin(position + numSamples, loopEnd);
+        for (int i=first; i<last; i++)
+        {
+            auto proportion = (i - fadeStart + 0.5f) / crossfadeLength;
+            auto fadeIn = getFadeInGain(proportion);
+            auto fadeOut = getFadeInGain(1.f - proportion);
+            auto preRoll = loopStart - crossfadeLength + (i - fadeStart);
+            for (int channel=0; channel<numChannels; channel++)
+                stagingBuffer.setSample(channel, stagingOffset + i - position,
+                                        source.getSample(channel, i) * fadeOut + source.getSample(channel, preRoll) * fadeIn);
+        }
+    }
+
+    /*! The mirror image of applyCrossfade: samples inside [loopStart, loopStart + crossfadeLength)
+    \   blend with the samples the same distance after the loop end
+    */
+    void applyReverseCrossfade(const AudioBuffer<float>& source, int numChannels, int position, int numSamples,
+                               int stagingOffset, int loopStart, int loopEnd, int crossfadeLength)
+    {
+        auto fadeEnd = loopStart + crossfadeLength;
+        auto first = jmax(position - numSamples, loopStart);
+        auto last = jmin(position, fadeEnd);
+        for (int i=first; i<last; i++)
+        {
+            auto proportion = (fadeEnd - i - 0.5f) / crossfadeLength;
+            auto fadeIn = getFadeInGain(proportion);
+            auto fadeOut = getFadeInGain(1.f - proportion);
+            auto postRoll = loopEnd + (i - loopStart);
+            for (int channel=0; channel<numChannels; channel++)
+                stagingBuffer.setSample(channel, stagingOffset + (position - 1 - i),
+                                        source.getSample(channel, i) * fadeOut + source.getSample(channel, postRoll) * fadeIn);
+        }
+    }
+
+    /*! For loops without pre-roll: samples inside [loopStart, loopStart + crossfadeLength)
+    \   fade in over the samples the same distance after the loop end
+    */
+    void applyCrossfadeAfterWrap(const AudioBuffer<float>& source, int numChannels, int position, int numSamples,
+                                 int stagingOffset, int loopStart, int loopEnd, int crossfadeLength)
+    {
+        auto fadeEnd = loopStart + crossfadeLength;
+        auto first = jmax(position, loopStart);
+        auto last = jmin(position + numSamples, fadeEnd);
+        for (int i=first; i<last; i++)
+        {
+            auto proportion = (i - loopStart + 0.5f) / crossfadeLength;
+            auto fadeIn = getFadeInGain(proportion);
+            auto fadeOut = getFadeInGain(1.f - proportion);
+            auto postRoll = loopEnd + (i - loopStart);
+            for (int channel=0; channel<numChannels; channel++)
+                stagingBuffer.setSample(channel, stagingOffset + i - position,
+                                        source.getSample(channel, i) * fadeIn + source.getSample(channel, postRoll) * fadeOut);
+        }
+    }
+
+    /*! The mirror image of applyCrossfadeAfterWrap: samples inside [loopEnd - crossfadeLength, loopEnd)
+    \   fade in over the samples the same distance before the loop start
+    */
+    void applyReverseCrossfadeAfterWrap(const AudioBuffer<float>& source, int numChannels, int position, int numSamples,
+                                        int stagingOffset, int loopStart, int loopEnd, int crossfadeLength)
+    {
+        auto fadeStart = loopEnd - crossfadeLength;
+        auto first = jmax(position - numSamples, fadeStart);
+        auto last = jmin(position, loopEnd);
+        for (int i=first; i<last; i++)
+        {
+            auto proportion = (loopEnd - i - 0.5f) / crossfadeLength;
+            auto fadeIn = getFadeInGain(proportion);
+            auto fadeOut = getFadeInGain(1.f - proportion);
+            auto preRoll = loopStart - (loopEnd - i);
+            for (int channel=0; channel<numChannels; channel++)
+                stagingBuffer.setSample(channel, stagingOffset + (position - 1 - i),
+                                        source.getSample(channel, i) * fadeIn + source.getSample(channel, preRoll) * fadeOut);
+        }
+    }
+
+    AudioBuffer<float> stagingBuffer;
+    float fadeTable[fadeTableSize];
+
+    JUCE_DECLARE_NON_COPYABLE (PlaybackReader)
+};
@@ -0,0 +1,509 @@
+/*
+  ==============================================================================
+
+    RegionList.h
+    Created: 19 Oct 2026 7:51:42am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*! A named range of the document, a marker when the range is empty
+*/
+struct Region
+{
+    int id = -1;
+    String name;
+    Range<int> range;
+
+    bool isMarker() const
+    {
+        return range.isEmpty();
+    }
+};
+
+/*! Named regions and markers in an interval tree: a treap ordered by start
+\   position where every node knows the largest end in its subtree, so a
+\   query only walks the branches that can overlap it. Shifting everything
+\   after an edit is a split, a lazy offset on one subtree and a merge, so
+\   it costs O(log n) no matter how many regions move. Queries and edits
+\   cost O(log n) for every region they report or have to cut.
+\
+\   A marker counts as covering its one sample in queries.
+*/
+class RegionList
+{
+public:
+    RegionList():
+    root(-1),
+    numRegions(0)
+    {
+    }
+    ~RegionList(){}
+
+    /*! Adds a region and returns its id, which stays valid until it is removed
+    */
+    int add(const String& name, Range<int> range)
+    {
+        auto id = allocateNode();
+        auto& node = nodes[static_cast<size_t>(id)];
+        node.name = name;
+        node.start = range.getStart();
+        node.end = range.getEnd();
+        insertNode(id);
+        numRegions++;
+        return id;
+    }
+
+    bool remove(int id)
+    {
+        if (!contains(id))
+            return false;
+        eraseNode(id);
+        nodes[static_cast<size_t>(id)].used = false;
+        nodes[static_cast<size_t>(id)].name.clear();
+        freeNodes.push_back(id);
+        numRegions--;
+        return true;
+    }
+
+    bool setRange(int id, Range<int> range)
+    {
+        if (!contains(id))
+            return false;
+        eraseNode(id);
+        auto& node = nodes[static_cast<size_t>(id)];
+        node.start = range.getStart();
+        node.end = range.getEnd();
+        insertNode(id);
+        return true;
+    }
+
+    bool setName(int id, const String& name)
+    {
+        if (!contains(id))
+            return false;
+        nodes[static_cast<size_t>(id)].name = name;
+        return true;
+    }
+
+    bool contains(int id) const
+    {
+        return id >= 0 && id < static_cast<int>(nodes.size()) && nodes[static_cast<size_t>(id)].used;
+    }
+
+    /*! The region with this id, O(log n)
+    */
+    Region get(int id) const
+    {
+        if (!contains(id))
+            return {};
+        auto offset = getAncestorShift(id);
+        auto& node = nodes[static_cast<size_t>(id)];
+        return {id, node.name, {node.start + offset, node.end + offset}};
+    }
+
+    int size() const
+    {
+        return numRegions;
+    }
+
+    void clear()
+    {
+        nodes.clear();
+        freeNodes.clear();
+        root = -1;
+        numRegions = 0;
+    }
+
+    /*! The regions overlapping [range.start, range.end), sorted by start
+    */
+    std::vector<Region> getOverlapping(Range<int> range) const
+    {
+        std::vector<Region> regions;
+        collectOverlapping(root, 0, range.getStart(), range.getEnd(), regions);
+        return regions;
+    }
+
+    std::vector<Region> getAll() const
+    {
+        return getOverlapping({std::numeric_limits<int>::min(), std::numeric_limits<int>::max()});
+    }
+
+    /*! The region with a start or end at most tolerance samples from
+    \   position, the nearest one wins. Otherwise the shortest region that
+    \   contains position. -1 if there is neither.
+    */
+    int hitTest(int position, int tolerance) const
+    {
+        auto best = -1;
+        auto bestDistance = tolerance + 1;
+        for (auto& region : getOverlapping({position - tolerance - 1, position + tolerance + 1}))
+        {
+            auto distance = jmin(std::abs(region.range.getStart() - position), std::abs(region.range.getEnd() - position));
+            if (distance < bestDistance)
+            {
+                best = region.id;
+                bestDistance = distance;
+            }
+        }
+        if (best >= 0)
+            return best;
+
+        auto shortest = std::numeric_limits<int>::max();
+        for (auto& region : getOverlapping({position, position + 1}))
+        {
+            if (region.range.getLength() < shortest)
+            {
+                best = region.id;
+                shortest = region.range.getLength();
+            }
+        }
+        return best;
+    }
+
+    /*! Called after numRemoved samples starting at startSample have been
+    \   replaced by numInserted samples. Regions after the edit move with the
+    \   audio, regions reaching into it are cut or stretched, and what was
+    \   inside the removed audio collapses to its start.
+    */
+    void update(int startSample, int numRemoved, int numInserted)
+    {
+        auto removedEnd = startSample + numRemoved;
+        auto delta = numInserted - numRemoved;
+        if (delta == 0 || root < 0)
+            return;
+
+        // the regions the edit cuts through change shape, take them out first
+        std::vector<Region> cut;
+        collectOverlapping(root, 0, startSample, removedEnd, cut);
+        for (auto& region : cut)
+            eraseNode(region.id);
+
+        // everything starting after the removed audio moves by the same amount
+        int before, after;
+        split(root, removedEnd, std::numeric_limits<int>::min(), before, after);
+        applyShift(after, delta);
+        root = merge(before, after);
+        setRoot(root);
+
+        auto moveStart = [startSample, removedEnd, delta](int position) {
+            if (position < startSample)
+                return position;
+            return position >= removedEnd ? position + delta : startSample;
+        };
+        auto moveEnd = [startSample, removedEnd, delta](int position) {
+            if (position <= startSample)
+                return position;
+            return position >= removedEnd ? position + delta : startSample;
+        };
+        for (auto& region : cut)
+        {
+            auto& node = nodes[static_cast<size_t>(region.id)];
+            node.start = moveStart(region.range.getStart());
+            node.end = region.isMarker() ? node.start : jmax(node.start, moveEnd(region.range.getEnd()));
+            insertNode(region.id);
+        }
+    }
+
+    /*! The regions an edit removing numRemoved samples at startSample cuts
+    \   or collapses, which update can't undo by moving them back. Take them
+    \   before the edit to put them back with restore.
+    */
+    std::vector<Region> getReshapedBy(int startSample, int numRemoved) const
+    {
+        if (numRemoved <= 0)
+            return {};
+        return getOverlapping({startSample, startSample + numRemoved});
+    }
+
+    /*! The regions as they are now, e.g. after an edit reshaped them
+    */
+    std::vector<Region> getCurrent(const std::vector<Region>& regions) const
+    {
+        std::vector<Region> current;
+        for (auto& region : regions)
+            if (contains(region.id))
+                current.push_back(get(region.id));
+        return current;
+    }
+
+    /*! Puts the regions back to the ranges they have in the list, skipping
+    \   the ones that were removed since
+    */
+    void restore(const std::vector<Region>& regions)
+    {
+        for (auto& region : regions)
+            setRange(region.id, region.range);
+    }
+
+    /*! Adds the regions as cue points to the metadata of a wave file. Every
+    \   region gets a cue point and a label, regions with a length also get a
+    \   labelled text chunk with that length.
+    */
+    void addToWavMetadata(StringPairArray& metadata) const
+    {
+        auto regions = getAll();
+        int numRanges = 0;
+        for (size_t i=0; i<regions.size(); i++)
+        {
+            auto& region = regions[i];
+            auto identifier = String(static_cast<int>(i) + 1);
+            auto cue = "Cue" + String(static_cast<int>(i));
+            metadata.set(cue + "Identifier", identifier);
+            metadata.set(cue + "Order", identifier);
+            metadata.set(cue + "ChunkID", String(static_cast<int>(dataChunkId)));
+            metadata.set(cue + "ChunkStart", "0");
+            metadata.set(cue + "BlockStart", "0");
+            metadata.set(cue + "Offset", String(region.range.getStart()));
+
+            auto label = "CueLabel" + String(static_cast<int>(i));
+            metadata.set(label + "Identifier", identifier);
+            metadata.set(label + "Text", region.name);
+
+            if (!region.isMarker())
+            {
+                auto text = "CueRegion" + String(numRanges++);
+                metadata.set(text + "Identifier", identifier);
+                metadata.set(text + "SampleLength", String(region.range.getLength()));
+                metadata.set(text + "Purpose", String(static_cast<int>(regionPurposeId)));
+                metadata.set(text + "Country", "0");
+                metadata.set(text + "Language", "0");
+                metadata.set(text + "Dialect", "0");
+                metadata.set(text + "CodePage", "0");
+                metadata.set(text + "Text", region.name);
+            }
+        }
+        metadata.set("NumCuePoints", String(static_cast<int>(regions.size())));
+        metadata.set("NumCueLabels", String(static_cast<int>(regions.size())));
+        metadata.set("NumCueRegions", String(numRanges));
+    }
+
+    /*! Replaces the regions with the cue points of a wave file's metadata
+    */
+    void loadFromWavMetadata(const StringPairArray& metadata)
+    {
+        clear();
+        std::map<int, String> names;
+        for (int i=0; i<metadata.getValue("NumCueLabels", "0").getIntValue(); i++)
+        {
+            auto label = "CueLabel" + String(i);
+            names[metadata.getValue(label + "Identifier", "0").getIntValue()] = metadata.getValue(label + "Text", {});
+        }
+        std::map<int, int> lengths;
+        for (int i=0; i<metadata.getValue("NumCueRegions", "0").getIntValue(); i++)
+        {
+            auto text = "CueRegion" + String(i);
+            lengths[metadata.getValue(text + "Identifier", "0").getIntValue()] = metadata.getValue(text + "SampleLength", "0").getIntValue();
+        }
+        for (int i=0; i<metadata.getValue("NumCuePoints", "0").getIntValue(); i++)
+        {
+            auto cue = "Cue" + String(i);
+            auto identifier = metadata.getValue(cue + "Identifier", "0").getIntValue();
+            auto start = metadata.getValue(cue + "Offset", "0").getIntValue();
+            auto name = names.count(identifier) > 0 ? names[identifier] : "Marker " + String(i + 1);
+            add(name, {start, start + (lengths.count(identifier) > 0 ? lengths[identifier] : 0)});
+        }
+    }
+
+private:
+    enum : uint32
+    {
+        dataChunkId = 0x61746164,       // "data" read as a little endian number
+        regionPurposeId = 0x206e6772    // "rgn "
+    };
+
+    struct Node
+    {
+        String name;
+        int start = 0;
+        int end = 0;
+        int maxEnd = 0;         // largest query end in the subtree
+        int shift = 0;          // not yet added to the children
+        int left = -1;
+        int right = -1;
+        int parent = -1;
+        uint32 priority = 0;
+        bool used = false;
+    };
+
+    /*! Markers cover their sample in queries
+    */
+    static int getQueryEnd(const Node& node)
+    {
+        return jmax(node.end, node.start + 1);
+    }
+
+    int allocateNode()
+    {
+        int id;
+        if (!freeNodes.empty())
+        {
+            id = freeNodes.back();
+            freeNodes.pop_back();
+        }
+        else
+        {
+            id = static_cast<int>(nodes.size());
+            nodes.emplace_back();
+        }
+        auto& node = nodes[static_cast<size_t>(id)];
+        node.used = true;
+        node.priority = static_cast<uint32>(random.nextInt());
+        return id;
+    }
+
+    void applyShift(int node, int delta)
+    {
+        if (node < 0)
+            return;
+        auto& n = nodes[static_cast<size_t>(node)];
+        n.start += delta;
+        n.end += delta;
+        n.maxEnd += delta;
+        n.shift += delta;
+    }
+
+    void pushShift(int node)
+    {
+        auto& n = nodes[static_cast<size_t>(node)];
+        if (n.shift == 0)
+            return;
+        applyShift(n.left, n.shift);
+        applyShift(n.right, n.shift);
+        n.shift = 0;
+    }
+
+    void pull(int node)
+    {
+        auto& n = nodes[static_cast<size_t>(node)];
+        n.maxEnd = getQueryEnd(n);
+        for (auto child : {n.left, n.right})
+        {
+            if (child < 0)
+                continue;
+            n.maxEnd = jmax(n.maxEnd, nodes[static_cast<size_t>(child)].maxEnd);
+            nodes[static_cast<size_t>(child)].parent = node;
+        }
+    }
+
+    void setRoot(int node)
+    {
+        root = node;
+        if (root >= 0)
+            nodes[static_cast<size_t>(root)].parent = -1;
+    }
+
+    /*! Splits the tree into the nodes ordered before (start, id) and the rest
+    */
+    void split(int node, int start, int id, int& before, int& after)
+    {
+        if (node < 0)
+        {
+            before = after = -1;
+            return;
+        }
+        pushShift(node);
+        auto& n = nodes[static_cast<size_t>(node)];
+        if (n.start < start || (n.start == start && node < id))
+        {
+            int left, right;
+            split(n.right, start, id, left, right);
+            nodes[static_cast<size_t>(node)].right = left;
+            pull(node);
+            before = node;
+            after = right;
+        }
+        else
+        {
+            int left, right;
+            split(n.left, start, id, left, right);
+            nodes[static_cast<size_t>(node)].left = right;
+            pull(node);
+            before = left;
+            after = node;
+        }
+    }
+
+    int merge(int left, int right)
+    {
+        if (left < 0)
+            return right;
+        if (right < 0)
+            return left;
+        if (nodes[static_cast<size_t>(left)].priority > nodes[static_cast<size_t>(right)].priority)
+        {
+            pushShift(left);
+            nodes[static_cast<size_t>(left)].right = merge(nodes[static_cast<size_t>(left)].right, right);
+            pull(left);
+            return left;
+        }
+        pushShift(right);
+        nodes[static_cast<size_t>(right)].left = merge(left, nodes[static_cast<size_t>(right)].left);
+        pull(right);
+        return right;
+    }
+
+    /*! Inserts a node whose start and end are set, as a single node tree
+    */
+    void insertNode(int id)
+    {
+        auto& node = nodes[static_cast<size_t>(id)];
+        node.left = node.right = -1;
+        node.shift = 0;
+        pull(id);
+        int before, after;
+        split(root, node.start, id, before, after);
+        setRoot(merge(merge(before, id), after));
+    }
+
+    /*! Takes a node out of the tree, leaving its real start and end in it
+    */
+    void eraseNode(int id)
+    {
+        auto region = get(id);
+        int before, rest, single, after;
+        split(root, region.range.getStart(), id, before, rest);
+        split(rest, region.range.getStart(), id + 1, single, after);
+        jassert (single == id);
+        setRoot(merge(before, after));
+        auto& node = nodes[static_cast<size_t>(id)];
+        node.start = region.range.getStart();
+        node.end = region.range.getEnd();
+    }
+
+    /*! Sum of the shifts the ancestors of a node still owe it
+    */
+    int getAncestorShift(int id) const
+    {
+        auto offset = 0;
+        for (auto node = nodes[static_cast<size_t>(id)].parent; node >= 0; node = nodes[static_cast<size_t>(node)].parent)
+            offset += nodes[static_cast<size_t>(node)].shift;
+        return offset;
+    }
+
+    void collectOverlapping(int node, int offset, int start, int end, std::vector<Region>& regions) const
+    {
+        if (node < 0)
+            return;
+        auto& n = nodes[static_cast<size_t>(node)];
+        if (n.maxEnd + offset <= start)
+            return;
+        collectOverlapping(n.left, offset + n.shift, start, end, regions);
+        if (n.start + offset >= end)
+            return;
+        if (getQueryEnd(n) + offset > start)
+            regions.push_back({node, n.name, {n.start + offset, n.end + offset}});
+        collectOverlapping(n.right, offset + n.shift, start, end, regions);
+    }
+
+    std::vector<Node> nodes;        // indexed by region id
+    std::vector<int> freeNodes;
+    int root;
+    int numRegions;
+    Random random;
+};
@@ -0,0 +1,433 @@
+/*
+  ==============================================================================
+
+    Resampler.h
+    Created: 19 Oct 2026 7:08:15am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*! Precomputed Kaiser windowed sinc filter, numPhases+1 rows of numTaps
+\   coefficients for fractional positions 0, 1/numPhases, ... 1 between the two
+\   middle taps, plus the difference to the next row for interpolating between
+\   phases. Tables are shared between all resamplers with the same cutoff.
+*/
+class SincTable
+{
+public:
+    enum
+    {
+        numTaps = 32,
+        numPhases = 256
+    };
+
+    /*! Builds the table, cutoff is relative to the input Nyquist frequency
+    */
+    SincTable(float cutoff):
+    cutoff(cutoff)
+    {
+        storage.allocate(static_cast<size_t>(2 * (numPhases + 1) * numTaps + 16), true);
+        rows = alignPointer(storage.get());
+        deltas = rows + (numPhases + 1) * numTaps;
+
+        const double beta = 8.0;
+        const double halfLength = numTaps / 2;
+        for (int phase=0; phase<=numPhases; phase++)
+        {
+            auto row = rows + phase * numTaps;
+            auto fraction = static_cast<double>(phase) / numPhases;
+            double sum = 0.0;
+            for (int tap=0; tap<numTaps; tap++)
+            {
+                auto x = tap - (halfLength - 1.0) - fraction;
+                auto windowPosition = x / halfLength;
+                auto window = std::abs(windowPosition) >= 1.0 ? 0.0
+                            : besselI0(beta * std::sqrt(1.0 - windowPosition * windowPosition)) / besselI0(beta);
+                auto value = cutoff * sinc(cutoff * x) * window;
+                row[tap] = static_cast<float>(value);
+                sum += value;
+            }
+            // unity gain at DC for every phase
+            for (int tap=0; tap<numTaps; tap++)
+                row[tap] = static_cast<float>(row[tap] / sum);
+        }
+
+        for (int phase=0; phase<numPhases; phase++)
+            for (int tap=0; tap<numTaps; tap++)
+                deltas[phase * numTaps + tap] = rows[(phase + 1) * numTaps + tap] - rows[phase * numTaps + tap];
+        FloatVectorOperations::clear(deltas + numPhases * numTaps, numTaps);
+    }
+    ~SincTable(){}
+
+    /*! Returns the shared table for a cutoff, building it on first use.
+    \   Not real-time safe, call it when preparing.
+    */
+    static std::shared_ptr<const SincTable> get(float cutoff)
+    {
+        // a hundredth is plenty of resolution for an anti-aliasing cutoff
+        auto key = roundToInt(cutoff * 100.f);
+        static CriticalSection lock;
+        static std::vector<std::shared_ptr<const SincTable>> tables;
+
+        const ScopedLock scopedLock (lock);
+        for (auto& table : tables)
+            if (roundToInt(table->cutoff * 100.f) == key)
+                return table;
+
+        tables.push_back(std::make_shared<const SincTable>(key / 100.f));
+        return tables.back();
+    }
+
+    const float* getRow(int phase) const
+    {
+        return rows + phase * numTaps;
+    }
+
+    const float* getDeltaRow(int phase) const
+    {
+        return deltas + phase * numTaps;
+    }
+
+    float getCutoff() const
+    {
+        return cutoff;
+    }
+
+    /*! Rounds a pointer up to a 16 float boundary, enough for any SIMD width
+    */
+    static float* alignPointer(float* pointer)
+    {
+        auto address = reinterpret_cast<pointer_sized_uint>(pointer);
+        return reinterpret_cast<float*>((address + 63) & ~static_cast<pointer_sized_uint>(63));
+    }
+
+private:
+    static double sinc(double x)
+    {
+        if (std::abs(x) < 1e-9)
+            return 1.0;
+        return std::sin(MathConstants<double>::pi * x) / (MathConstants<double>::pi * x);
+    }
+
+    static double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k=1; k<32; k++)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    float cutoff;
+    HeapBlock<float> storage;
+    float* rows;
+    float* deltas;
+
+    JUCE_DECLARE_NON_COPYABLE (SincTable)
+};
+
+/*! Streaming multichannel resampler for playback with selectable quality.
+\   Works like JUCE's interpolators: it keeps a history of the last input
+\   samples, consumes as many input samples as the speed ratio requires and
+\   returns how many it used, so the caller can advance its read position.
+\
+\   The channels are processed in groups, one channel per SIMD lane, so every
+\   tap is a single multiply-add for a whole group and the coefficients are
+\   computed once per output sample for all channels.
+*/
+class PlaybackResampler
+{
+public:
+    enum Quality
+    {
+        Linear = 0,
+        CatmullRom,
+        WindowedSinc
+    };
+
+    PlaybackResampler():
+    quality(CatmullRom),
+    numChannels(0),
+    numGroups(0),
+    numTaps(4),
+    writeIndex(0),
+    subSamplePos(1.0),
+    history(nullptr),
+    coefficients(nullptr),
+    laneOutput(nullptr),
+    pendingTableChanged(false)
+    {
+        sincTable = SincTable::get(defaultCutoff);
+    }
+    ~PlaybackResampler(){}
+
+    /*! Allocates the history for a number of channels, not real-time safe
+    */
+    void prepare(int newNumChannels)
+    {
+        numChannels = newNumChannels;
+        numGroups = (numChannels + numLanes - 1) / numLanes;
+        historyStorage.allocate(static_cast<size_t>(numGroups * 2 * maxTaps * numLanes + 16), true);
+        history = SincTable::alignPointer(historyStorage.get());
+        workStorage.allocate(static_cast<size_t>(maxTaps + numLanes + 32), true);
+        coefficients = SincTable::alignPointer(workStorage.get());
+        laneOutput = SincTable::alignPointer(coefficients + maxTaps);
+        inputPointers.allocate(static_cast<size_t>(jmax(1, numChannels)), true);
+        outputPointers.allocate(static_cast<size_t>(jmax(1, numChannels)), true);
+        for (int step=0; step<numSpeedSteps; step++)
+            speedTables[step] = SincTable::get(defaultCutoff / static_cast<float>(std::pow(speedStepRatio, step)));
+        reset();
+    }
+
+    /*! Chooses the anti-aliasing cutoff of the sinc filter for the playback
+    \   speed ratio (input samples per output sample), not real-time safe.
+    \   Can be called while playing, the audio thread picks the table up at
+    \   the start of the next process call.
+    */
+    void setSpeedRatio(double speedRatio)
+    {
+        auto cutoff = defaultCutoff * static_cast<float>(jmin(1.0, 1.0 / jmax(1.0e-3, speedRatio)));
+        auto table = SincTable::get(cutoff);
+
+        // this also releases the table the audio thread handed back
+        const SpinLock::ScopedLockType lock (pendingLock);
+        pendingTable = std::move(table);
+        pendingTableChanged.store(true);
+    }
+
+    /*! Real-time safe version of setSpeedRatio for varispeed, picks the
+    \   prepared table for the next higher step of speed, so the cutoff is
+    \   never above what the ratio needs
+    */
+    void selectSpeedRatio(double speedRatio)
+    {
+        takePendingTable();
+        if (speedTables[0] == nullptr)
+            return;
+        auto step = speedRatio <= 1.0 ? 0 : static_cast<int>(std::ceil(std::log(speedRatio) / std::log(speedStepRatio) - 1.0e-6));
+        auto& table = speedTables[jmin(step, static_cast<int>(numSpeedSteps) - 1)];
+        if (sincTable != table)
+            sincTable = table;
+    }
+
+    /*! Real-time safe, clears the history when the quality changes
+    */
+    void setQuality(Quality newQuality)
+    {
+        if (newQuality == quality)
+            return;
+        quality = newQuality;
+        reset();
+    }
+
+    Quality getQuality() const
+    {
+        return quality;
+    }
+
+    /*! Delay of the output in input samples
+    */
+    int getLatency() const
+    {
+        return numTaps / 2;
+    }
+
+    void reset()
+    {
+        switch (quality)
+        {
+            case Linear:        numTaps = 2; break;
+            case CatmullRom:    numTaps = 4; break;
+            case WindowedSinc:  numTaps = SincTable::numTaps; break;
+            default:            numTaps = 4; break;
+        }
+        if (history != nullptr)
+            FloatVectorOperations::clear(history, numGroups * 2 * maxTaps * numLanes);
+        writeIndex = 0;
+        subSamplePos = 1.0;
+    }
+
+    /*! Produces numOutputSamples samples for every prepared channel
+        @param double input samples per output sample
+        @param int the number of input samples that can be read from inputStartSample,
+               silence is used after that
+        @return the number of input samples consumed
+    */
+    int process(double speedRatio,
+                const AudioBuffer<float>& input, int inputStartSample, int numInputSamplesAvailable,
+                AudioBuffer<float>& output, int outputStartSample, int numOutputSamples)
+    {
+        jassert(input.getNumChannels() >= numChannels);
+        takePendingTable();
+        for (int channel=0; channel<numChannels; channel++)
+        {
+            inputPointers[channel] = input.getReadPointer(channel, inputStartSample);
+            outputPointers[channel] = channel < output.getNumChannels()
+                                    ? output.getWritePointer(channel, outputStartSample) : nullptr;
+        }
+
+        int numUsed = 0;
+        for (int i=0; i<numOutputSamples; i++)
+        {
+            while (subSamplePos >= 1.0)
+            {
+                pushSample(numUsed < numInputSamplesAvailable ? numUsed : -1);
+                numUsed++;
+                subSamplePos -= 1.0;
+            }
+
+            computeCoefficients(static_cast<float>(subSamplePos));
+
+            for (int group=0; group<numGroups; group++)
+            {
+                applyFilter(group);
+                for (int lane=0; lane<numLanes; lane++)
+                {
+                    auto channel = group * numLanes + lane;
+                    if (channel < numChannels && outputPointers[channel] != nullptr)
+                        outputPointers[channel][i] = laneOutput[lane];
+                }
+            }
+
+            subSamplePos += speedRatio;
+        }
+        return numUsed;
+    }
+
+private:
+    /*! Swaps in the table from setSpeedRatio, real-time safe. The old table
+    \   goes back to the pending slot so it is released on the message thread.
+    */
+    void takePendingTable()
+    {
+        if (!pendingTableChanged.load())
+            return;
+        const SpinLock::ScopedTryLockType lock (pendingLock);
+        if (lock.isLocked())
+        {
+            std::swap(sincTable, pendingTable);
+            pendingTableChanged.store(false);
+        }
+    }
+
+#if JUCE_USE_SIMD
+    typedef dsp::SIMDRegister<float> Lanes;
+    enum { numLanes = static_cast<int>(Lanes::SIMDNumElements) };
+#else
+    enum { numLanes = 1 };
+#endif
+
+    enum
+    {
+        maxTaps = SincTable::numTaps,
+        numSpeedSteps = 13 // up to 1.25^12, about 14.5 input samples per output sample
+    };
+
+    static constexpr float defaultCutoff = 0.9f;
+    static constexpr double speedStepRatio = 1.25;
+
+    /*! The history is a ring of numTaps slots written twice, so the last
+    \   numTaps samples are always contiguous from writeIndex
+    */
+    float* getSlot(int group, int slot) const
+    {
+        return history + (group * 2 * maxTaps + slot) * numLanes;
+    }
+
+    void pushSample(int inputIndex)
+    {
+        for (int group=0; group<numGroups; group++)
+        {
+            auto first = getSlot(group, writeIndex);
+            auto second = getSlot(group, writeIndex + numTaps);
+            for (int lane=0; lane<numLanes; lane++)
+            {
+                auto channel = group * numLanes + lane;
+                auto value = (channel < numChannels && inputIndex >= 0) ? inputPointers[channel][inputIndex] : 0.f;
+                first[lane] = value;
+                second[lane] = value;
+            }
+        }
+        writeIndex = (writeIndex + 1) % numTaps;
+    }
+
+    /*! Coefficients from the oldest to the newest sample, for a position
+    \   between the two middle samples of the window
+    */
+    void computeCoefficients(float t)
+    {
+        switch (quality)
+        {
+            case Linear:
+                coefficients[0] = 1.f - t;
+                coefficients[1] = t;
+                break;
+            case WindowedSinc:
+            {
+                auto scaledPosition = t * SincTable::numPhases;
+                auto phase = jlimit(0, static_cast<int>(SincTable::numPhases), static_cast<int>(scaledPosition));
+                FloatVectorOperations::copy(coefficients, sincTable->getRow(phase), numTaps);
+                FloatVectorOperations::addWithMultiply(coefficients, sincTable->getDeltaRow(phase),
+                                                       scaledPosition - phase, numTaps);
+                break;
+            }
+            case CatmullRom:
+            default:
+            {
+                auto t2 = t * t;
+                auto t3 = t2 * t;
+                coefficients[0] = 0.5f * (-t + 2.f * t2 - t3);
+                coefficients[1] = 0.5f * (2.f - 5.f * t2 + 3.f * t3);
+                coefficients[2] = 0.5f * (t + 4.f * t2 - 3.f * t3);
+                coefficients[3] = 0.5f * (t3 - t2);
+                break;
+            }
+        }
+    }
+
+    void applyFilter(int group)
+    {
+        auto window = getSlot(group, writeIndex);
+#if JUCE_USE_SIMD
+        auto sum = Lanes::expand(0.f);
+        for (int tap=0; tap<numTaps; tap++)
+            sum = Lanes::multiplyAdd(sum, Lanes::fromRawArray(window + tap * numLanes), Lanes::expand(coefficients[tap]));
+        sum.copyToRawArray(laneOutput);
+#else
+        auto sum = 0.f;
+        for (int tap=0; tap<numTaps; tap++)
+            sum += window[tap] * coefficients[tap];
+        laneOutput[0] = sum;
+#endif
+    }
+
+    Quality quality;
+    int numChannels;
+    int numGroups;
+    int numTaps;
+    int writeIndex;
+    double subSamplePos;
+
+    std::shared_ptr<const SincTable> sincTable;         // audio thread only
+    std::shared_ptr<const SincTable> pendingTable;      // under pendingLock
+    SpinLock pendingLock;
+    std::atomic<bool> pendingTableChanged;
+    std::shared_ptr<const SincTable> speedTables[numSpeedSteps]; // kept alive by the SincTable cache too
+    HeapBlock<float> historyStorage;
+    HeapBlock<float> workStorage;
+    HeapBlock<const float*> inputPointers;
+    HeapBlock<float*> outputPointers;
+    float* history;
+    float* coefficients;
+    float* laneOutput;
+
+    JUCE_DECLARE_NON_COPYABLE (PlaybackResampler)
+};
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    RoutingVisualizer.h
+    Created: 19 Oct 2026 7:11:12am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioProcessingComponent.h"
+
+/*! Editor for the channel routing matrix, one gain slider per
+\   output (row) and file channel (column)
+*/
+class RoutingVisualizer : public Component
+{
+public:
+    RoutingVisualizer(AudioProcessingComponent& c) :
+        apc(c),
+        numInputs(apc.getChannelRouter().getNumInputs()),
+        numOutputs(apc.getChannelRouter().getNumOutputs())
+    {
+        for (int output=0; output<numOutputs; output++)
+        {
+            for (int input=0; input<numInputs; input++)
+            {
+                auto slider = gainSliders.add(new Slider(Slider::LinearBar, Slider::TextBoxLeft));
+                slider->setRange(0.0, 1.0, 0.01);
+                slider->setValue(apc.getChannelRouter().getGain(output, input), dontSendNotification);
+                slider->setTooltip("file channel " + String(input + 1) + " to output " + String(output + 1));
+                slider->onValueChange = [this, slider, output, input] {
+                    apc.getChannelRouter().setGain(output, input, static_cast<float>(slider->getValue()));
+                };
+                addAndMakeVisible(slider);
+            }
+        }
+
+        defaultButton.setButtonText("Default");
+        defaultButton.onClick = [this] {defaultButtonClicked(); };
+        addAndMakeVisible(defaultButton);
+
+        setSize(jmax(200, labelWidth + numInputs * cellWidth + 20),
+                jmax(100, (numOutputs + 1) * cellHeight + 55));
+    }
+
+    ~RoutingVisualizer()
+    {
+    }
+
+    void paint(Graphics& g) override
+    {
+        g.fillAll(Colour(32, 32, 32));
+        g.setColour(Colours::grey);
+        g.setFont(12.0f);
+
+        if (numInputs == 0 || numOutputs == 0)
+        {
+            g.drawText("No file loaded", getLocalBounds(), Justification::centred);
+            return;
+        }
+
+        for (int input=0; input<numInputs; input++)
+            g.drawText("In " + String(input + 1), 10 + labelWidth + input * cellWidth, 10, cellWidth, cellHeight,
+                       Justification::centred);
+        for (int output=0; output<numOutputs; output++)
+            g.drawText("Out " + String(output + 1), 10, 10 + (output + 1) * cellHeight, labelWidth, cellHeight,
+                       Justification::centredLeft);
+    }
+
+    void resized() override
+    {
+        for (int output=0; output<numOutputs; output++)
+            for (int input=0; input<numInputs; input++)
+                gainSliders[output * numInputs + input]->setBounds(10 + labelWidth + input * cellWidth + 1,
+                                                                   10 + (output + 1) * cellHeight + 1,
+                                                                   cellWidth - 2, cellHeight - 2);
+        defaultButton.setBounds(10, getHeight() - 35, 100, 25);
+    }
+
+private:
+    enum
+    {
+        labelWidth = 50,
+        cellWidth = 56,
+        cellHeight = 24
+    };
+
+    void defaultButtonClicked()
+    {
+        auto& router = apc.getChannelRouter();
+        router.resetToDefault();
+        for (int output=0; output<numOutputs; output++)
+            for (int input=0; input<numInputs; input++)
+                gainSliders[output * numInputs + input]->setValue(router.getGain(output, input), dontSendNotification);
+    }
+
+    AudioProcessingComponent& apc;
+    int numInputs;
+    int numOutputs;
+    OwnedArray<Slider> gainSliders;
+    TextButton defaultButton;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RoutingVisualizer)
+};
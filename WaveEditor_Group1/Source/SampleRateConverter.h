@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    SampleRateConverter.h
+    Created: 19 Oct 2026 7:09:55am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Resampler.h"
+#include "ParallelUtils.h"
+
+/*! Offline sample rate conversion with the windowed sinc table.
+\   Every output sample is computed directly from its position in the input,
+\   so channels and time segments are independent: a segment simply reads the
+\   input samples around its range, overlapping its neighbours by the filter
+\   length, and the result is identical however the work is split.
+*/
+class SampleRateConverter
+{
+public:
+    enum
+    {
+        samplesPerSegment = 65536 // output samples per parallel task
+    };
+
+    static int64 getConvertedLength(int64 numSamples, double sourceRate, double targetRate)
+    {
+        return static_cast<int64>(std::ceil(numSamples * targetRate / sourceRate));
+    }
+
+    /*! Converts the whole source buffer into dest, in parallel
+    */
+    static void process(const AudioBuffer<float>& source, double sourceRate, double targetRate, AudioBuffer<float>& dest)
+    {
+        auto numOutputSamples = static_cast<int>(getConvertedLength(source.getNumSamples(), sourceRate, targetRate));
+        dest.setSize(source.getNumChannels(), numOutputSamples);
+        convertBlock(source, 0, sourceRate, targetRate, dest, 0, numOutputSamples);
+    }
+
+    /*! Streams a file through the converter into a WAV file, a segment at a
+    \   time, so files of any length can be converted without a document
+        @return an error message, empty on success
+    */
+    static String convertFile(const File& inputFile, const File& outputFile, double targetRate, int bitsPerSample = 24)
+    {
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        std::unique_ptr<AudioFormatReader> reader (formatManager.createReaderFor(inputFile));
+        if (reader == nullptr)
+            return "Can't read " + inputFile.getFullPathName();
+
+        auto numChannels = static_cast<int>(reader->numChannels);
+        auto sourceRate = reader->sampleRate;
+        auto ratio = sourceRate / targetRate;
+
+        outputFile.deleteFile();
+        WavAudioFormat format;
+        std::unique_ptr<AudioFormatWriter> writer (format.createWriterFor(new FileOutputStream(outputFile), targetRate,
+                                                                          static_cast<unsigned int>(numChannels),
+                                                                          bitsPerSample, {}, 0));
+        if (writer == nullptr)
+            return "Can't write " + outputFile.getFullPathName();
+
+        // a few segments per worker in every block, so all cores stay busy
+        auto outputBlockSize = samplesPerSegment * jmax(4, ParallelUtils::getNumWorkers() * 2);
+        auto numOutputSamples = getConvertedLength(reader->lengthInSamples, sourceRate, targetRate);
+        AudioBuffer<float> inputBlock;
+        AudioBuffer<float> outputBlock (numChannels, outputBlockSize);
+
+        for (int64 outputStart=0; outputStart<numOutputSamples; outputStart+=outputBlockSize)
+        {
+            auto numThisTime = static_cast<int>(jmin(static_cast<int64>(outputBlockSize), numOutputSamples - outputStart));
+
+            // the input range of this block plus the filter margins on both sides
+            auto inputStart = static_cast<int64>(std::floor(outputStart * ratio)) - SincTable::numTaps / 2;
+            auto inputEnd = static_cast<int64>(std::floor((outputStart + numThisTime - 1) * ratio)) + SincTable::numTaps / 2 + 1;
+            auto numInput = static_cast<int>(inputEnd - inputStart);
+            inputBlock.setSize(numChannels, numInput, false, false, true);
+            reader->read(&inputBlock, 0, numInput, inputStart, true, true); // reads outside the file are silent
+
+            convertBlock(inputBlock, inputStart, sourceRate, targetRate, outputBlock, outputStart, numThisTime);
+            if (!writer->writeFromAudioSampleBuffer(outputBlock, 0, numThisTime))
+                return "Write failed: " + outputFile.getFullPathName();
+        }
+        return {};
+    }
+
+    /*! Computes output samples [outputStart, outputStart+numOutput) of one channel.
+        @param const float* source samples [inputOffset, inputOffset+numInput),
+               anything outside that range is treated as silence
+    */
+    static void convertRange(const SincTable& table, double ratio,
+                             const float* input, int64 inputOffset, int numInput,
+                             float* output, int64 outputStart, int numOutput)
+    {
+        const int numTaps = SincTable::numTaps;
+        const int halfTaps = numTaps / 2;
+        float coefficients[numTaps];
+
+        for (int i=0; i<numOutput; i++)
+        {
+            auto position = (outputStart + i) * ratio;
+            auto base = static_cast<int64>(std::floor(position));
+            auto scaledFraction = static_cast<float>((position - base) * SincTable::numPhases);
+            auto phase = jlimit(0, static_cast<int>(SincTable::numPhases), static_cast<int>(scaledFraction));
+            FloatVectorOperations::copy(coefficients, table.getRow(phase), numTaps);
+            FloatVectorOperations::addWithMultiply(coefficients, table.getDeltaRow(phase), scaledFraction - phase, numTaps);
+
+            // first tap in the local input
+            auto first = base - (halfTaps - 1) - inputOffset;
+            if (first >= 0 && first + numTaps <= numInput)
+            {
+                auto window = input + first;
+                float sums[4] = {0.f, 0.f, 0.f, 0.f};
+                for (int tap=0; tap<numTaps; tap+=4)
+                    for (int lane=0; lane<4; lane++)
+                        sums[lane] += window[tap + lane] * coefficients[tap + lane];
+                output[i] = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+            }
+            else // at the edges of the input
+            {
+                auto sum = 0.f;
+                for (int tap=0; tap<numTaps; tap++)
+                {
+                    auto index = first + tap;
+                    if (index >= 0 && index < numInput)
+                        sum += input[index] * coefficients[tap];
+                }
+                output[i] = sum;
+            }
+        }
+    }
+
+private:
+    /*! Converts every channel of a block, with one parallel task per channel and segment
+        @param int64 the source position of the first sample in input
+        @param int64 the output position of the first sample written to output
+    */
+    static void convertBlock(const AudioBuffer<float>& input, int64 inputOffset, double sourceRate, double targetRate,
+                             AudioBuffer<float>& output, int64 outputStart, int numOutput)
+    {
+        auto ratio = sourceRate / targetRate;
+        auto table = SincTable::get(0.9f * static_cast<float>(jmin(1.0, 1.0 / ratio)));
+        auto numChannels = jmin(input.getNumChannels(), output.getNumChannels());
+        auto numSegments = (numOutput + samplesPerSegment - 1) / samplesPerSegment;
+
+        ParallelUtils::parallelFor(numChannels * numSegments, [&](int task) {
+            auto channel = task / numSegments;
+            auto segmentStart = (task % numSegments) * samplesPerSegment;
+            convertRange(*table, ratio,
+                         input.getReadPointer(channel), inputOffset, input.getNumSamples(),
+                         output.getWritePointer(channel, segmentStart), outputStart + segmentStart,
+                         jmin(static_cast<int>(samplesPerSegment), numOutput - segmentStart));
+        });
+    }
+
+    SampleRateConverter(){};
+    ~SampleRateConverter(){};
+};
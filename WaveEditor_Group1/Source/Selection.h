@@ -13,6 +13,11 @@
 #include <JuceHeader.h>
 #include "AudioProcessingComponent.h"
 #include "WaveVisualizer.h"
+#include "TimeStretchVisualizer.h"
+#include "EffectChainVisualizer.h"
+#include "NoiseReductionVisualizer.h"
+#include "StripSilenceVisualizer.h"
+#include "SliceExportVisualizer.h"
 
 class Selection : public Component
 {
@@ -168,10 +173,24 @@ private:
         apc.setPositionInS(AudioProcessingComponent::MarkerStart, startPos);
         apc.setPositionInS(AudioProcessingComponent::MarkerEnd, endPos);
         apc.setPositionInS(AudioProcessingComponent::Cursor, startPos);
+        // onsets first, then the zero crossing next to the onset
+        apc.snapToOnset(AudioProcessingComponent::MarkerStart, getSnapDistanceInS());
+        apc.snapToOnset(AudioProcessingComponent::MarkerEnd, getSnapDistanceInS());
+        apc.snapToOnset(AudioProcessingComponent::Cursor, getSnapDistanceInS());
+        apc.snapToZeroCrossing(AudioProcessingComponent::MarkerStart, getSnapDistanceInS());
+        apc.snapToZeroCrossing(AudioProcessingComponent::MarkerEnd, getSnapDistanceInS());
+        apc.snapToZeroCrossing(AudioProcessingComponent::Cursor, getSnapDistanceInS());
 
         setSelectionSize();
     }
 
+    /*! Snapping reaches at least one pixel, or 10 ms when zoomed in
+    */
+    double getSnapDistanceInS()
+    {
+        return jmax(0.01, apc.getLengthInS() / jmax(1, getWidth()));
+    }
+
     /*! Called when existing selection is being moved
     \   Sets markers in APC
     \   calls setSelectionSize to redefine selectionBounds
@@ -245,10 +264,18 @@ private:
         //with cursor mouse
         if (event.mods.isLeftButtonDown())
         {
+            //alt + drag scrubs without touching the selection
+            if (event.mods.isAltDown())
+            {
+                apc.startScrubbing(getPositionInS(event.getMouseDownX()));
+                return;
+            }
             if (!apc.isMouseNormal())
             {
                 float ratio = float(event.getMouseDownX()) / float(getWidth());
                 apc.setPositionInS(AudioProcessingComponent::Cursor, ratio * apc.getLengthInS());
+                apc.snapToOnset(AudioProcessingComponent::Cursor, getSnapDistanceInS());
+                apc.snapToZeroCrossing(AudioProcessingComponent::Cursor, getSnapDistanceInS());
                 apc.setPositionInS(AudioProcessingComponent::MarkerStart, 0);
                 apc.setPositionInS(AudioProcessingComponent::MarkerEnd, apc.getLengthInS());
 
@@ -271,6 +298,13 @@ private:
                 popupMenu.addItem("Fade In", [this]() {apc.fadeInMarkedRegion(); });
                 popupMenu.addItem("Fade Out", [this]() {apc.fadeOutMarkedRegion(); });
                 popupMenu.addItem("Normalize", [this]() {apc.normalizeMarkedRegion(); });
+                popupMenu.addItem("Loudness Normalize (-23 LUFS)", [this]() {apc.loudnessNormalizeMarkedRegion(-23.f); });
+                popupMenu.addItem("Limit (-1 dBTP)", [this]() {apc.limitMarkedRegion(-1.f); });
+                popupMenu.addItem("Time Stretch / Pitch Shift...", [this]() {showTimeStretchPanel(); });
+                popupMenu.addItem("Noise Reduction...", [this]() {showNoiseReductionPanel(); });
+                popupMenu.addItem("Strip Silence...", [this]() {showStripSilencePanel(); });
+                popupMenu.addItem("Export Slices...", [this]() {showSliceExportPanel(); });
+                popupMenu.addItem("Add Region", [this]() {apc.addRegionFromMarkedRegion(); });
             }
             // these funtionalities are not limited inside the selected bounds
             if (apc.isPasteEnabled())
@@ -278,6 +312,35 @@ private:
                 popupMenu.addItem("Paste", [this]() {apc.pasteFromCursor(); });
                 popupMenu.addItem("Insert", [this]() {apc.insertFromCursor(); });
             }
+            popupMenu.addItem("Effect Chain...", apc.getNumChannels() > 0, false, [this]() {showEffectChainPanel(); });
+            auto clickedRegion = apc.getRegionAt(getPositionInS(event.getMouseDownX()), getSnapDistanceInS() * 3);
+            popupMenu.addItem("Add Marker at Cursor", apc.getNumChannels() > 0, false, [this]() {apc.addMarkerAtCursor(); });
+            if (clickedRegion >= 0)
+            {
+                popupMenu.addItem("Rename " + apc.getRegionList().get(clickedRegion).name + "...", [this, clickedRegion]() {renameRegion(clickedRegion); });
+                popupMenu.addItem("Remove " + apc.getRegionList().get(clickedRegion).name, [this, clickedRegion]() {apc.removeRegion(clickedRegion); });
+            }
+            // one edit over every region, undone at once
+            PopupMenu allRegionsMenu;
+            allRegionsMenu.addItem("Mute", [this]() {apc.muteAllRegions(); });
+            allRegionsMenu.addItem("Fade In", [this]() {apc.fadeInAllRegions(); });
+            allRegionsMenu.addItem("Fade Out", [this]() {apc.fadeOutAllRegions(); });
+            allRegionsMenu.addItem("Normalize", [this]() {apc.normalizeAllRegions(); });
+            popupMenu.addSubMenu("All Regions", allRegionsMenu, apc.getRegionList().size() > 0);
+            popupMenu.addItem("Select Slice at Cursor", apc.getNumChannels() > 0, false, [this]() {
+                apc.selectOnsetSliceAtCursor();
+                setSelectionSize();
+            });
+            popupMenu.addItem("Snap to Zero Crossings", true, apc.isSnapToZeroCrossingsEnabled(),
+                              [this]() {apc.setSnapToZeroCrossings(!apc.isSnapToZeroCrossingsEnabled()); });
+            popupMenu.addItem("Snap to Onsets", true, apc.isSnapToOnsetsEnabled(),
+                              [this]() {apc.setSnapToOnsets(!apc.isSnapToOnsetsEnabled()); });
+            // sample rate conversion always applies to the whole file
+            PopupMenu sampleRateMenu;
+            for (auto rate : {22050.0, 32000.0, 44100.0, 48000.0, 88200.0, 96000.0})
+                sampleRateMenu.addItem(String(rate, 0) + " Hz", apc.getNumChannels() > 0, rate == apc.getSampleRate(),
+                                       [this, rate]() {apc.convertSampleRate(rate); });
+            popupMenu.addSubMenu("Convert Sample Rate", sampleRateMenu);
             popupMenu.show();
         }
     }
@@ -288,6 +351,11 @@ private:
     */
     void mouseDrag(const MouseEvent& event) override
     {
+        if (apc.isScrubbing())
+        {
+            apc.scrubTo(getPositionInS(event.getMouseDownX() + event.getDistanceFromDragStartX()));
+            return;
+        }
         if (apc.isMouseNormal())
             slideBounds(event);
         else
@@ -296,6 +364,17 @@ private:
         repaint();
     }
 
+    /*! Double click selects the region under the mouse
+    */
+    void mouseDoubleClick(const MouseEvent& event) override
+    {
+        auto region = apc.getRegionAt(getPositionInS(event.getMouseDownX()), getSnapDistanceInS() * 3);
+        if (region < 0)
+            return;
+        apc.selectRegion(region);
+        setSelectionSize();
+    }
+
     void mouseEnter(const MouseEvent& event) override
     {
         //automatically change the cursor to IBeam style when over the waveform
@@ -314,9 +393,86 @@ private:
 
     void mouseUp(const MouseEvent& event) override
     {
+        if (apc.isScrubbing())
+            apc.stopScrubbing();
         isMouseDown = false;
     }
 
+    void showTimeStretchPanel()
+    {
+        DialogWindow::LaunchOptions options;
+        options.content.setOwned(new TimeStretchVisualizer(apc));
+        options.dialogTitle = "Time Stretch / Pitch Shift";
+        options.dialogBackgroundColour = Colour(32, 32, 32);
+        options.escapeKeyTriggersCloseButton = true;
+        options.useNativeTitleBar = true;
+        options.resizable = false;
+        options.launchAsync();
+    }
+
+    void showNoiseReductionPanel()
+    {
+        DialogWindow::LaunchOptions options;
+        options.content.setOwned(new NoiseReductionVisualizer(apc));
+        options.dialogTitle = "Noise Reduction";
+        options.dialogBackgroundColour = Colour(32, 32, 32);
+        options.escapeKeyTriggersCloseButton = true;
+        options.useNativeTitleBar = true;
+        options.resizable = false;
+        options.launchAsync();
+    }
+
+    void showStripSilencePanel()
+    {
+        DialogWindow::LaunchOptions options;
+        options.content.setOwned(new StripSilenceVisualizer(apc));
+        options.dialogTitle = "Strip Silence";
+        options.dialogBackgroundColour = Colour(32, 32, 32);
+        options.escapeKeyTriggersCloseButton = true;
+        options.useNativeTitleBar = true;
+        options.resizable = false;
+        options.launchAsync();
+    }
+
+    void renameRegion(int id)
+    {
+        AlertWindow window("Rename", {}, AlertWindow::NoIcon);
+        window.addTextEditor("name", apc.getRegionList().get(id).name);
+        window.addButton("OK", 1, KeyPress(KeyPress::returnKey));
+        window.addButton("Cancel", 0, KeyPress(KeyPress::escapeKey));
+        if (window.runModalLoop() == 1)
+            apc.renameRegion(id, window.getTextEditorContents("name"));
+    }
+
+    void showSliceExportPanel()
+    {
+        DialogWindow::LaunchOptions options;
+        options.content.setOwned(new SliceExportVisualizer(apc));
+        options.dialogTitle = "Export Slices";
+        options.dialogBackgroundColour = Colour(32, 32, 32);
+        options.escapeKeyTriggersCloseButton = true;
+        options.useNativeTitleBar = true;
+        options.resizable = false;
+        options.launchAsync();
+    }
+
+    void showEffectChainPanel()
+    {
+        DialogWindow::LaunchOptions options;
+        options.content.setOwned(new EffectChainVisualizer(apc));
+        options.dialogTitle = "Effect Chain";
+        options.dialogBackgroundColour = Colour(32, 32, 32);
+        options.escapeKeyTriggersCloseButton = true;
+        options.useNativeTitleBar = true;
+        options.resizable = false;
+        options.launchAsync();
+    }
+
+    double getPositionInS(int x)
+    {
+        return jlimit(0.0, 1.0, x / static_cast<double>(jmax(1, getWidth()))) * apc.getLengthInS();
+    }
+
     AudioProcessingComponent& apc;
     AudioThumbnail& thumb;
     PopupMenu popupMenu;
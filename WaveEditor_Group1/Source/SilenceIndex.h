@@ -0,0 +1,221 @@
+/*
+  ==============================================================================
+
+    SilenceIndex.h
+    Created: 19 Oct 2026 7:36:57am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LevelIndex.h"
+
+/*! A span is silent once the block RMS of every channel falls below the
+\   threshold, and stays silent until one rises above threshold + hysteresis
+*/
+struct SilenceSettings
+{
+    float thresholdDb = -50.f;
+    float hysteresisDb = 6.f;
+    double minDurationMs = 300.0;
+};
+
+/*! Sorted silent spans of the document, built from the block summaries of a
+\   LevelIndex, so no pass over the samples is needed. The spans are kept in
+\   blocks without the minimum duration, which is applied by the queries.
+\   After an edit only the spans from the edit onwards are scanned again, and
+\   an in-place edit stops scanning as soon as the state after the edit
+\   matches the spans it had before.
+*/
+class SilenceIndex
+{
+public:
+    SilenceIndex():
+    sampleRate(0.0),
+    numSamples(0),
+    samplesPerBlock(1),
+    enterLevel(0.f),
+    exitLevel(0.f)
+    {
+    }
+    ~SilenceIndex(){}
+
+    void setSettings(const SilenceSettings& newSettings, const LevelIndex& levelIndex, int newNumSamples)
+    {
+        settings = newSettings;
+        rebuild(levelIndex, newNumSamples);
+    }
+
+    /*! Only the minimum duration depends on it, so no scan is needed
+    */
+    void setSampleRate(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+    }
+
+    const SilenceSettings& getSettings() const
+    {
+        return settings;
+    }
+
+    void rebuild(const LevelIndex& levelIndex, int newNumSamples)
+    {
+        numSamples = newNumSamples;
+        samplesPerBlock = levelIndex.getSamplesPerBlock();
+        // compare mean squares, so no square root or log per block
+        enterLevel = Decibels::decibelsToGain(settings.thresholdDb * 2.f, -400.f);
+        exitLevel = Decibels::decibelsToGain((settings.thresholdDb + jmax(0.f, settings.hysteresisDb)) * 2.f, -400.f);
+        spans.clear();
+        scan(levelIndex, 0, Span());
+    }
+
+    /*! Called after the LevelIndex has been updated for an edit in which
+    \   numRemoved samples starting at startSample were replaced by numInserted
+    */
+    void update(const LevelIndex& levelIndex, int newNumSamples, int startSample, int numRemoved, int numInserted)
+    {
+        if (levelIndex.getSamplesPerBlock() != samplesPerBlock)
+        {
+            rebuild(levelIndex, newNumSamples);
+            return;
+        }
+        numSamples = newNumSamples;
+
+        // the state at the edit only depends on the span that reaches it
+        auto editBlock = jmax(0, startSample / samplesPerBlock);
+        auto first = std::lower_bound(spans.begin(), spans.end(), editBlock,
+                                      [](const Span& span, int block) { return span.endBlock < block; });
+        auto restartBlock = first != spans.end() ? jmin(editBlock, first->startBlock) : editBlock;
+
+        // spans after an in-place edit are still valid, and can be reused once the scan catches up
+        Span resume;
+        std::vector<Span> tail;
+        if (numRemoved == numInserted)
+        {
+            resume.startBlock = (startSample + numInserted + samplesPerBlock - 1) / samplesPerBlock;
+            for (auto span = first; span != spans.end(); span++)
+                if (span->endBlock >= resume.startBlock)
+                    tail.push_back(*span);
+        }
+        spans.erase(first, spans.end());
+        scan(levelIndex, restartBlock, resume, &tail);
+    }
+
+    /*! The silent spans of at least the minimum duration that intersect
+    \   [startSample, startSample+numSamplesToQuery), clipped to it
+    */
+    std::vector<Range<int>> getSpans(int startSample, int numSamplesToQuery) const
+    {
+        std::vector<Range<int>> result;
+        Range<int> query (startSample, startSample + numSamplesToQuery);
+        auto minBlocks = getMinDurationInBlocks();
+        auto first = std::lower_bound(spans.begin(), spans.end(), startSample / samplesPerBlock,
+                                      [](const Span& span, int block) { return span.endBlock <= block; });
+        for (auto span = first; span != spans.end() && span->startBlock * samplesPerBlock < query.getEnd(); span++)
+        {
+            if (span->endBlock - span->startBlock < minBlocks)
+                continue;
+            auto clipped = getSpanRange(*span).getIntersectionWith(query);
+            if (!clipped.isEmpty())
+                result.push_back(clipped);
+        }
+        return result;
+    }
+
+    std::vector<Range<int>> getSpans() const
+    {
+        return getSpans(0, numSamples);
+    }
+
+private:
+    /*! Silent blocks [startBlock, endBlock)
+    */
+    struct Span
+    {
+        int startBlock = 0;
+        int endBlock = 0;
+    };
+
+    int getMinDurationInBlocks() const
+    {
+        auto minSamples = settings.minDurationMs * sampleRate / 1000.0;
+        return jmax(1, static_cast<int>(std::ceil(minSamples / samplesPerBlock)));
+    }
+
+    Range<int> getSpanRange(const Span& span) const
+    {
+        return {span.startBlock * samplesPerBlock, jmin(numSamples, span.endBlock * samplesPerBlock)};
+    }
+
+    /*! The loudest mean square of all channels in one block
+    */
+    static float getBlockLevel(const LevelIndex& levelIndex, int block)
+    {
+        float level = 0.f;
+        for (int channel=0; channel<levelIndex.getNumChannels(); channel++)
+        {
+            auto& summary = levelIndex.getBlockLevels(channel, block);
+            if (summary.numSamples > 0)
+                level = jmax(level, static_cast<float>(summary.sumOfSquares / static_cast<double>(summary.numSamples)));
+        }
+        return level;
+    }
+
+    /*! Runs the hysteresis from startBlock, which must not be silent
+    \   through the block before it. With a tail, the scan stops at the first
+    \   block from resume.startBlock on that is loud in both the old and new
+    \   state and appends the tail spans from there.
+    */
+    void scan(const LevelIndex& levelIndex, int startBlock, Span resume, std::vector<Span>* tail = nullptr)
+    {
+        auto numBlocks = jmin(levelIndex.getNumBlocks(), (numSamples + samplesPerBlock - 1) / samplesPerBlock);
+        auto canResume = tail != nullptr && resume.startBlock > 0;
+        size_t nextTailSpan = 0;
+        bool silent = false;
+        Span current;
+        for (int block=startBlock; block<numBlocks; block++)
+        {
+            if (canResume && !silent && block >= resume.startBlock)
+            {
+                // an old span is still silent going into its end block
+                while (nextTailSpan < tail->size() && (*tail)[nextTailSpan].endBlock < block)
+                    nextTailSpan++;
+                auto oldSilent = nextTailSpan < tail->size() && (*tail)[nextTailSpan].startBlock < block;
+                if (!oldSilent)
+                {
+                    spans.insert(spans.end(), tail->begin() + static_cast<std::ptrdiff_t>(nextTailSpan), tail->end());
+                    return;
+                }
+            }
+
+            auto level = getBlockLevel(levelIndex, block);
+            if (!silent && level < enterLevel)
+            {
+                silent = true;
+                current.startBlock = block;
+            }
+            else if (silent && level > exitLevel)
+            {
+                silent = false;
+                current.endBlock = block;
+                spans.push_back(current);
+            }
+        }
+        if (silent)
+        {
+            current.endBlock = numBlocks;
+            spans.push_back(current);
+        }
+    }
+
+    SilenceSettings settings;
+    double sampleRate;
+    int numSamples;
+    int samplesPerBlock;
+    float enterLevel;   // mean square that starts a silent span
+    float exitLevel;    // mean square that ends it
+    std::vector<Span> spans;
+};
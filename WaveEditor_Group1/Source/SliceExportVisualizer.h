@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    SliceExportVisualizer.h
+    Created: 19 Oct 2026 7:48:15am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioProcessingComponent.h"
+
+/*! Exports the selection cut at its onsets, or between its silent spans, to
+\   one file per slice, with the progress of the running export
+*/
+class SliceExportVisualizer : public Component,
+                              private Timer
+{
+public:
+    SliceExportVisualizer(AudioProcessingComponent& c) :
+        apc(c),
+        progress(0.0),
+        progressBar(progress)
+    {
+        sliceModeBox.addItem("Slice at Onsets", onsetSlices);
+        sliceModeBox.addItem("Slice between Silences", nonSilentSlices);
+        sliceModeBox.addItem("Selection as One File", selectionSlice);
+        sliceModeBox.setSelectedId(onsetSlices, dontSendNotification);
+        sliceModeBox.onChange = [this] {repaint(); };
+        addAndMakeVisible(sliceModeBox);
+
+        nameTemplateEditor.setText(SliceExportSettings().nameTemplate, false);
+        nameTemplateEditor.setTooltip("{index}, {start} and {end} are replaced for every slice");
+        addAndMakeVisible(nameTemplateEditor);
+
+        directory = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("Slices");
+        directoryButton.setButtonText("Folder...");
+        directoryButton.onClick = [this] {chooseDirectory(); };
+        addAndMakeVisible(directoryButton);
+
+        exportButton.setButtonText("Export");
+        exportButton.onClick = [this] {exportButtonClicked(); };
+        addAndMakeVisible(exportButton);
+
+        addAndMakeVisible(progressBar);
+
+        setSize(360, 170);
+        startTimerHz(10);
+    }
+
+    void paint(Graphics& g) override
+    {
+        g.fillAll(Colour(32, 32, 32));
+        g.setColour(Colours::grey);
+        g.setFont(12.0f);
+        g.drawText(directory.getFullPathName(), 10, 70, getWidth() - 110, 25, Justification::centredLeft, true);
+
+        auto& exporter = apc.getSliceExporter();
+        String status;
+        if (exporter.isExporting())
+            status = String(exporter.getNumFilesWritten()) + " files written";
+        else
+            status = String(getSlices().size()) + " slices";
+        if (exporter.getFailedFiles().size() > 0)
+            status += ", " + String(exporter.getFailedFiles().size()) + " failed";
+        g.drawText(status, 10, 135, getWidth() - 120, 25, Justification::centredLeft);
+    }
+
+    void resized() override
+    {
+        sliceModeBox.setBounds(10, 10, getWidth() - 20, 25);
+        nameTemplateEditor.setBounds(10, 40, getWidth() - 20, 25);
+        directoryButton.setBounds(getWidth() - 90, 70, 80, 25);
+        progressBar.setBounds(10, 100, getWidth() - 20, 25);
+        exportButton.setBounds(getWidth() - 110, 135, 100, 25);
+    }
+
+private:
+    enum SliceMode
+    {
+        onsetSlices = 1,
+        nonSilentSlices,
+        selectionSlice
+    };
+
+    std::vector<Range<int>> getSlices()
+    {
+        switch (sliceModeBox.getSelectedId())
+        {
+            case onsetSlices:
+                return apc.getMarkedRegionOnsetSlices();
+            case nonSilentSlices:
+                return apc.getMarkedRegionNonSilentSlices();
+            default:
+                return {apc.getMarkedRegion()};
+        }
+    }
+
+    void chooseDirectory()
+    {
+        FileChooser chooser("Export slices to...", directory);
+        if (chooser.browseForDirectory())
+        {
+            directory = chooser.getResult();
+            repaint();
+        }
+    }
+
+    void exportButtonClicked()
+    {
+        auto& exporter = apc.getSliceExporter();
+        if (exporter.isExporting())
+        {
+            exporter.cancel();
+            return;
+        }
+
+        SliceExportSettings settings;
+        settings.directory = directory;
+        settings.nameTemplate = nameTemplateEditor.getText();
+        apc.exportSlices(getSlices(), settings);
+    }
+
+    void timerCallback() override
+    {
+        auto& exporter = apc.getSliceExporter();
+        progress = exporter.getProgress();
+        exportButton.setButtonText(exporter.isExporting() ? "Cancel" : "Export");
+        repaint();
+    }
+
+    AudioProcessingComponent& apc;
+    double progress;    // read by the progress bar
+    ComboBox sliceModeBox;
+    TextEditor nameTemplateEditor;
+    File directory;
+    TextButton directoryButton;
+    TextButton exportButton;
+    ProgressBar progressBar;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SliceExportVisualizer)
+};
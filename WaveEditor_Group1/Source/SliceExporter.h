@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    SliceExporter.h
+    Created: 19 Oct 2026 7:48:15am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct SliceExportSettings
+{
+    File directory;
+    String nameTemplate = "slice_{index}";  // {index}, {start} and {end} are replaced per slice, _{index} is appended if it's missing
+    int bitsPerSample = 24;
+};
+
+/*! Writes every slice of the document to its own wave file, on a fixed pool
+\   of worker threads that each keep one file open at a time. The samples go
+\   from the document to the writers in blocks of samplesPerWrite without
+\   being copied, so the memory used doesn't depend on the number or length
+\   of the slices and the export is limited by the disk.
+\
+\   The workers read the audio buffer, so cancel() must be called before the
+\   buffer is changed. Files finished before that are kept.
+*/
+class SliceExporter : private Thread
+{
+public:
+    enum
+    {
+        samplesPerWrite = 1 << 15,
+        streamBufferSize = 1 << 18
+    };
+
+    SliceExporter(int numWorkers = 4):
+    Thread("Slice Exporter"),
+    workers(numWorkers),
+    source(nullptr),
+    sampleRate(0.0),
+    totalSamples(0),
+    samplesWritten(0),
+    numFilesWritten(0),
+    nextSlice(0),
+    numRunning(0)
+    {
+    }
+
+    ~SliceExporter()
+    {
+        cancel();
+    }
+
+    /*! Starts writing the slices in the background, returns false if an
+    \   export is still running or the directory can't be created
+    */
+    bool start(const AudioBuffer<float>& audioBuffer, double newSampleRate,
+               const std::vector<Range<int>>& newSlices, const SliceExportSettings& newSettings)
+    {
+        if (isThreadRunning() || !newSettings.directory.createDirectory())
+            return false;
+
+        source = &audioBuffer;
+        sampleRate = newSampleRate;
+        slices = newSlices;
+        settings = newSettings;
+        totalSamples = 0;
+        for (auto& slice : slices)
+            totalSamples += slice.getLength();
+        samplesWritten = 0;
+        numFilesWritten = 0;
+        {
+            const ScopedLock sl (failedLock);
+            failedFiles.clear();
+        }
+        startThread(3);
+        return true;
+    }
+
+    /*! Stops the export and deletes the files that were being written. The
+    \   workers stop after their current block, so this waits for them rather
+    \   than killing the thread under running jobs.
+    */
+    void cancel()
+    {
+        stopThread(-1);
+    }
+
+    bool isExporting() const
+    {
+        return isThreadRunning();
+    }
+
+    bool waitUntilFinished(int timeOutMilliseconds)
+    {
+        return waitForThreadToExit(timeOutMilliseconds);
+    }
+
+    /*! Fraction of the samples written, from 0 to 1
+    */
+    double getProgress() const
+    {
+        return totalSamples > 0 ? static_cast<double>(samplesWritten.load()) / static_cast<double>(totalSamples) : 1.0;
+    }
+
+    int getNumFilesWritten() const
+    {
+        return numFilesWritten.load();
+    }
+
+    StringArray getFailedFiles() const
+    {
+        const ScopedLock sl (failedLock);
+        return failedFiles;
+    }
+
+    /*! The file name of slice index (counted from 0) out of numSlices, the
+    \   index is counted from 1 and padded to the same width for every slice.
+    \   A template without {index} gets it appended, so the slices never
+    \   overwrite each other.
+    */
+    static String createFileName(const String& nameTemplate, int index, int numSlices, Range<int> slice)
+    {
+        auto numDigits = String(jmax(1, numSlices)).length();
+        auto uniqueTemplate = nameTemplate;
+        if (!uniqueTemplate.contains("{index}"))
+            uniqueTemplate += "_{index}";
+        auto name = uniqueTemplate.replace("{index}", String(index + 1).paddedLeft('0', numDigits))
+                                .replace("{start}", String(slice.getStart()))
+                                .replace("{end}", String(slice.getEnd()));
+        return File::createLegalFileName(name) + ".wav";
+    }
+
+private:
+    void run() override
+    {
+        // the workers take the slices in order, this thread is one of them
+        nextSlice = 0;
+        numRunning = workers.getNumThreads();
+        finished.reset();
+        auto work = [this]() {
+            WavAudioFormat format;
+            std::vector<const float*> channels (static_cast<size_t>(source->getNumChannels()));
+            for (auto index = nextSlice++; index < static_cast<int>(slices.size()) && !threadShouldExit(); index = nextSlice++)
+                writeSlice(format, channels, index);
+            if (--numRunning == 0)
+                finished.signal();
+        };
+        for (int i=1; i<workers.getNumThreads(); i++)
+            workers.addJob(std::function<void()>(work));
+        work();
+        finished.wait();
+        // the jobs are done with the counters, let the pool retire them too
+        workers.removeAllJobs(false, -1);
+    }
+
+    void writeSlice(WavAudioFormat& format, std::vector<const float*>& channels, int index)
+    {
+        auto slice = slices[static_cast<size_t>(index)].getIntersectionWith({0, source->getNumSamples()});
+        auto file = settings.directory.getChildFile(createFileName(settings.nameTemplate, index, static_cast<int>(slices.size()), slice));
+        // FileOutputStream appends to an existing file
+        file.deleteFile();
+
+        auto written = true;
+        {
+            std::unique_ptr<FileOutputStream> stream (new FileOutputStream(file, streamBufferSize));
+            std::unique_ptr<AudioFormatWriter> writer;
+            if (stream->openedOk())
+                writer.reset(format.createWriterFor(stream.get(), sampleRate, static_cast<unsigned int>(channels.size()),
+                                                    settings.bitsPerSample, {}, 0));
+            // the writer owns the stream once it exists
+            if (writer != nullptr)
+                stream.release();
+            written = writer != nullptr;
+            for (auto position=slice.getStart(); written && position<slice.getEnd(); position+=samplesPerWrite)
+            {
+                if (threadShouldExit())
+                {
+                    written = false;
+                    break;
+                }
+                auto numSamples = jmin(static_cast<int>(samplesPerWrite), slice.getEnd() - position);
+                for (size_t channel=0; channel<channels.size(); channel++)
+                    channels[channel] = source->getReadPointer(static_cast<int>(channel), position);
+                written = writer->writeFromFloatArrays(channels.data(), static_cast<int>(channels.size()), numSamples);
+                samplesWritten += numSamples;
+            }
+        }
+
+        if (written)
+        {
+            numFilesWritten++;
+        }
+        else
+        {
+            file.deleteFile();
+            if (!threadShouldExit())
+            {
+                const ScopedLock sl (failedLock);
+                failedFiles.add(file.getFullPathName());
+            }
+        }
+    }
+
+    ThreadPool workers;
+    const AudioBuffer<float>* source;
+    double sampleRate;
+    std::vector<Range<int>> slices;
+    SliceExportSettings settings;
+    int64 totalSamples;
+    std::atomic<int64> samplesWritten;
+    std::atomic<int> numFilesWritten;
+    CriticalSection failedLock;     // guards failedFiles
+    StringArray failedFiles;
+    // shared by the jobs of one export, members so they outlive every job
+    std::atomic<int> nextSlice;
+    std::atomic<int> numRunning;
+    WaitableEvent finished;
+
+    JUCE_DECLARE_NON_COPYABLE (SliceExporter)
+};
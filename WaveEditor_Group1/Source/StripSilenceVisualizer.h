@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    StripSilenceVisualizer.h
+    Created: 19 Oct 2026 7:36:57am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioProcessingComponent.h"
+
+/*! Silence detection settings with a live count of the silent spans in the
+\   selection, Apply strips them down to the kept length. The settings and the
+\   strip go through the edit queue, so the count is redrawn when it moves on.
+*/
+class StripSilenceVisualizer : public Component,
+                               public ChangeListener
+{
+public:
+    StripSilenceVisualizer(AudioProcessingComponent& c) :
+        apc(c)
+    {
+        auto settings = apc.getSilenceSettings();
+        setUpSlider(thresholdSlider, -90.0, -20.0, 1.0, settings.thresholdDb, -50.0, " dB threshold");
+        setUpSlider(hysteresisSlider, 0.0, 20.0, 0.5, settings.hysteresisDb, 6.0, " dB hysteresis");
+        setUpSlider(minDurationSlider, 20.0, 3000.0, 10.0, settings.minDurationMs, 300.0, " ms minimum");
+        setUpSlider(keepSlider, 0.0, 1000.0, 10.0, 100.0, 100.0, " ms kept");
+        minDurationSlider.setSkewFactorFromMidPoint(500.0);
+
+        applyButton.setButtonText("Strip Silence");
+        applyButton.onClick = [this] {
+            apc.stripSilenceInMarkedRegion(static_cast<float>(keepSlider.getValue()));
+            repaint();
+        };
+        addAndMakeVisible(applyButton);
+
+        setSize(320, 195);
+        apc.getEditQueue().addChangeListener(this);
+    }
+
+    ~StripSilenceVisualizer() override
+    {
+        apc.getEditQueue().removeChangeListener(this);
+    }
+
+    void changeListenerCallback(ChangeBroadcaster*) override
+    {
+        repaint();
+    }
+
+    void paint(Graphics& g) override
+    {
+        auto spans = apc.getMarkedRegionSilentSpans();
+        int64 numSilentSamples = 0;
+        for (auto& span : spans)
+            numSilentSamples += span.getLength();
+
+        g.fillAll(Colour(32, 32, 32));
+        g.setColour(Colours::grey);
+        g.setFont(12.0f);
+        g.drawText(String(spans.size()) + " silent spans, " + String(numSilentSamples / apc.getSampleRate(), 2) + " s",
+                   10, 130, getWidth() - 20, 20, Justification::centredLeft);
+    }
+
+    void resized() override
+    {
+        thresholdSlider.setBounds(10, 10, getWidth() - 20, 25);
+        hysteresisSlider.setBounds(10, 40, getWidth() - 20, 25);
+        minDurationSlider.setBounds(10, 70, getWidth() - 20, 25);
+        keepSlider.setBounds(10, 100, getWidth() - 20, 25);
+        applyButton.setBounds(getWidth() - 110, getHeight() - 35, 100, 25);
+    }
+
+private:
+    void setUpSlider(Slider& slider, double minimum, double maximum, double interval, double value, double defaultValue, const String& suffix)
+    {
+        slider.setSliderStyle(Slider::LinearBar);
+        slider.setRange(minimum, maximum, interval);
+        slider.setTextValueSuffix(suffix);
+        slider.setValue(value, dontSendNotification);
+        slider.setDoubleClickReturnValue(true, defaultValue);
+        slider.onValueChange = [this] {settingsChanged(); };
+        addAndMakeVisible(slider);
+    }
+
+    void settingsChanged()
+    {
+        SilenceSettings settings;
+        settings.thresholdDb = static_cast<float>(thresholdSlider.getValue());
+        settings.hysteresisDb = static_cast<float>(hysteresisSlider.getValue());
+        settings.minDurationMs = minDurationSlider.getValue();
+        apc.setSilenceSettings(settings);
+        repaint();
+    }
+
+    AudioProcessingComponent& apc;
+    Slider thresholdSlider;
+    Slider hysteresisSlider;
+    Slider minDurationSlider;
+    Slider keepSlider;
+    TextButton applyButton;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StripSilenceVisualizer)
+};
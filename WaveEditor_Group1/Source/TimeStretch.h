@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+    TimeStretch.h
+    Created: 19 Oct 2026 7:20:49am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Resampler.h"
+#include "SampleRateConverter.h"
+#include "ParallelUtils.h"
+
+/*! Phase vocoder working one frame at a time. Every frame of fftSize input
+\   samples, taken analysisHop samples after the previous one, adds one frame
+\   to the overlap-add output and completes synthesisHop output samples, so
+\   the time scale changes by synthesisHop / analysisHop. The phase of every
+\   bin is advanced by its measured frequency times the synthesis hop, which
+\   keeps the partials continuous across the frames.
+\
+\   All buffers are allocated in prepare, one set per channel, so processFrame
+\   is real-time safe. The channels share one FFT, which may lock inside
+\   perform, so parallel work needs one vocoder per thread.
+*/
+class PhaseVocoder
+{
+public:
+    enum
+    {
+        fftOrder = 11,
+        fftSize = 1 << fftOrder,
+        numBins = fftSize / 2 + 1,
+        overlap = 4,
+        synthesisHop = fftSize / overlap
+    };
+
+    PhaseVocoder():
+    fft(fftOrder),
+    numChannels(0)
+    {
+        // periodic Hann for analysis and synthesis, Hann squared at 4x overlap sums to 1.5
+        window.allocate(static_cast<size_t>(fftSize), true);
+        for (int i=0; i<fftSize; i++)
+            window[i] = static_cast<float>(0.5 - 0.5 * std::cos(MathConstants<double>::twoPi * i / fftSize));
+    }
+    ~PhaseVocoder(){}
+
+    /*! Allocates the per channel state, not real-time safe
+    */
+    void prepare(int newNumChannels)
+    {
+        numChannels = newNumChannels;
+        workspace.allocate(static_cast<size_t>(numChannels * 2 * fftSize), true);
+        accumulator.allocate(static_cast<size_t>(numChannels * fftSize), true);
+        lastPhase.allocate(static_cast<size_t>(numChannels * numBins), true);
+        sumPhase.allocate(static_cast<size_t>(numChannels * numBins), true);
+        isFirstFrame.allocate(static_cast<size_t>(jmax(1, numChannels)), true);
+        reset();
+    }
+
+    void reset()
+    {
+        if (numChannels == 0)
+            return;
+        FloatVectorOperations::clear(accumulator.get(), numChannels * fftSize);
+        std::fill(lastPhase.get(), lastPhase.get() + numChannels * numBins, 0.0);
+        std::fill(sumPhase.get(), sumPhase.get() + numChannels * numBins, 0.0);
+        for (int channel=0; channel<numChannels; channel++)
+            isFirstFrame[channel] = true;
+    }
+
+    int getNumChannels() const
+    {
+        return numChannels;
+    }
+
+    /*! The analysis hop for a time stretch factor (output length / input length)
+    \   when the output is resampled by pitchFactor afterwards
+    */
+    static double getAnalysisHop(double stretchFactor, double pitchFactor)
+    {
+        return synthesisHop / (stretchFactor * pitchFactor);
+    }
+
+    /*! Processes one frame of one channel and writes the synthesisHop output
+    \   samples it completes
+        @param const float* fftSize input samples
+        @param int input samples since the previous frame of this channel
+    */
+    void processFrame(int channel, const float* frame, int analysisHop, float* output)
+    {
+        jassert(channel < numChannels);
+        auto work = workspace.get() + channel * 2 * fftSize;
+        auto phases = lastPhase.get() + channel * numBins;
+        auto sums = sumPhase.get() + channel * numBins;
+
+        FloatVectorOperations::multiply(work, frame, window.get(), fftSize);
+        FloatVectorOperations::clear(work + fftSize, fftSize);
+        fft.performRealOnlyForwardTransform(work, true);
+
+        const auto twoPi = MathConstants<double>::twoPi;
+        for (int bin=0; bin<numBins; bin++)
+        {
+            auto real = work[2 * bin];
+            auto imag = work[2 * bin + 1];
+            auto magnitude = std::sqrt(real * real + imag * imag);
+            auto phase = std::atan2(static_cast<double>(imag), static_cast<double>(real));
+
+            if (isFirstFrame[channel])
+            {
+                sums[bin] = phase;
+            }
+            else
+            {
+                // the frequency of the bin is its centre plus the phase deviation over the hop
+                auto expected = twoPi * bin * analysisHop / fftSize;
+                auto deviation = phase - phases[bin] - expected;
+                deviation -= twoPi * std::floor(deviation / twoPi + 0.5);
+                auto advance = twoPi * bin * synthesisHop / fftSize;
+                if (analysisHop > 0)
+                    advance += deviation * synthesisHop / analysisHop;
+                sums[bin] = std::fmod(sums[bin] + advance, twoPi);
+            }
+            phases[bin] = phase;
+
+            work[2 * bin] = static_cast<float>(magnitude * std::cos(sums[bin]));
+            work[2 * bin + 1] = static_cast<float>(magnitude * std::sin(sums[bin]));
+        }
+        isFirstFrame[channel] = false;
+
+        // the inverse transform expects the full conjugate symmetric spectrum
+        for (int bin=numBins; bin<fftSize; bin++)
+        {
+            work[2 * bin] = work[2 * (fftSize - bin)];
+            work[2 * bin + 1] = -work[2 * (fftSize - bin) + 1];
+        }
+        fft.performRealOnlyInverseTransform(work);
+
+        auto sum = accumulator.get() + channel * fftSize;
+        FloatVectorOperations::multiply(work, window.get(), fftSize);
+        FloatVectorOperations::addWithMultiply(sum, work, 1.f / 1.5f, fftSize);
+
+        FloatVectorOperations::copy(output, sum, synthesisHop);
+        std::memmove(sum, sum + synthesisHop, sizeof(float) * static_cast<size_t>(fftSize - synthesisHop));
+        FloatVectorOperations::clear(sum + fftSize - synthesisHop, synthesisHop);
+    }
+
+private:
+    dsp::FFT fft;
+    int numChannels;
+    HeapBlock<float> window;
+    HeapBlock<float> workspace;
+    HeapBlock<float> accumulator;
+    HeapBlock<double> lastPhase;
+    HeapBlock<double> sumPhase;     // double and wrapped every hop, so long renders don't drift
+    HeapBlock<bool> isFirstFrame;
+
+    JUCE_DECLARE_NON_COPYABLE (PhaseVocoder)
+};
+
+/*! Offline time stretch and pitch shift of a whole buffer. The vocoder
+\   stretches by stretchFactor * pitchFactor, the result is then resampled by
+\   pitchFactor with the sinc table, which restores the length and moves the
+\   pitch. Every channel runs on its own worker with its own vocoder.
+*/
+class TimeStretcher
+{
+public:
+    static int getStretchedLength(int numSamples, double stretchFactor)
+    {
+        return roundToInt(numSamples * stretchFactor);
+    }
+
+    static void process(const AudioBuffer<float>& source, double stretchFactor, double pitchFactor, AudioBuffer<float>& dest)
+    {
+        const int fftSize = PhaseVocoder::fftSize;
+        const int hop = PhaseVocoder::synthesisHop;
+        auto numChannels = source.getNumChannels();
+        auto numSamples = source.getNumSamples();
+        auto numStretched = getStretchedLength(numSamples, stretchFactor * pitchFactor);
+        auto numOutput = getStretchedLength(numSamples, stretchFactor);
+        auto analysisHop = PhaseVocoder::getAnalysisHop(stretchFactor, pitchFactor);
+        dest.setSize(numChannels, numOutput);
+
+        auto table = SincTable::get(0.9f * static_cast<float>(jmin(1.0, 1.0 / pitchFactor)));
+
+        ParallelUtils::parallelFor(numChannels, [&](int channel) {
+            // frames are centred on their analysis position, so the output of the
+            // first fftSize / 2 / hop frames lies before the start and is dropped
+            HeapBlock<float> frame (static_cast<size_t>(fftSize), true);
+            HeapBlock<float> stretched (static_cast<size_t>(numStretched + hop), true);
+            HeapBlock<float> frameOutput (static_cast<size_t>(hop), true);
+            PhaseVocoder vocoder;
+            vocoder.prepare(1);
+            auto input = source.getReadPointer(channel);
+            int previousStart = 0;
+
+            for (int k=0; k * hop - fftSize / 2 < numStretched; k++)
+            {
+                auto frameStart = static_cast<int>(std::floor(k * analysisHop)) - fftSize / 2;
+                copyWithZeroPadding(input, numSamples, frameStart, frame.get(), fftSize);
+                vocoder.processFrame(0, frame.get(), frameStart - previousStart, frameOutput.get());
+                previousStart = frameStart;
+
+                auto outputStart = k * hop - fftSize / 2;
+                for (int i=jmax(0, -outputStart); i<hop && outputStart + i < numStretched; i++)
+                    stretched[outputStart + i] = frameOutput[i];
+            }
+
+            if (pitchFactor == 1.0)
+                FloatVectorOperations::copy(dest.getWritePointer(channel), stretched.get(), numOutput);
+            else
+                SampleRateConverter::convertRange(*table, pitchFactor, stretched.get(), 0, numStretched,
+                                                  dest.getWritePointer(channel), 0, numOutput);
+        });
+    }
+
+    /*! Copies numSamples samples from position, silence outside the input
+    */
+    static void copyWithZeroPadding(const float* input, int numInput, int position, float* dest, int numSamples)
+    {
+        auto first = jlimit(0, numSamples, -position);
+        auto last = jlimit(first, numSamples, numInput - position);
+        FloatVectorOperations::clear(dest, numSamples);
+        if (last > first)
+            FloatVectorOperations::copy(dest + first, input + position + first, last - first);
+    }
+
+private:
+    TimeStretcher(){};
+    ~TimeStretcher(){};
+};
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    TimeStretchVisualizer.h
+    Created: 19 Oct 2026 7:20:49am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioProcessingComponent.h"
+
+/*! Stretch and pitch controls with a live preview through the playback
+\   callback, Apply renders them into the marked region
+*/
+class TimeStretchVisualizer : public Component
+{
+public:
+    TimeStretchVisualizer(AudioProcessingComponent& c) :
+        apc(c)
+    {
+        stretchSlider.setSliderStyle(Slider::LinearBar);
+        stretchSlider.setRange(25.0, 400.0, 1.0);
+        stretchSlider.setSkewFactorFromMidPoint(100.0);
+        stretchSlider.setTextValueSuffix(" % length");
+        stretchSlider.setValue(100.0, dontSendNotification);
+        stretchSlider.setDoubleClickReturnValue(true, 100.0);
+        stretchSlider.onValueChange = [this] {parametersChanged(); };
+        addAndMakeVisible(stretchSlider);
+
+        pitchSlider.setSliderStyle(Slider::LinearBar);
+        pitchSlider.setRange(-12.0, 12.0, 0.1);
+        pitchSlider.setTextValueSuffix(" semitones");
+        pitchSlider.setValue(0.0, dontSendNotification);
+        pitchSlider.setDoubleClickReturnValue(true, 0.0);
+        pitchSlider.onValueChange = [this] {parametersChanged(); };
+        addAndMakeVisible(pitchSlider);
+
+        previewButton.setButtonText("Preview");
+        previewButton.setClickingTogglesState(true);
+        previewButton.onClick = [this] {apc.setTimeStretchPreview(previewButton.getToggleState()); };
+        addAndMakeVisible(previewButton);
+
+        applyButton.setButtonText("Apply");
+        applyButton.onClick = [this] {applyButtonClicked(); };
+        addAndMakeVisible(applyButton);
+
+        parametersChanged();
+        setSize(320, 130);
+    }
+
+    ~TimeStretchVisualizer()
+    {
+        apc.setTimeStretchPreview(false);
+    }
+
+    void paint(Graphics& g) override
+    {
+        g.fillAll(Colour(32, 32, 32));
+        g.setColour(Colours::grey);
+        g.setFont(12.0f);
+        g.drawText("stretch", 10, 10, 50, 25, Justification::centredLeft);
+        g.drawText("pitch", 10, 45, 50, 25, Justification::centredLeft);
+    }
+
+    void resized() override
+    {
+        stretchSlider.setBounds(60, 10, getWidth() - 70, 25);
+        pitchSlider.setBounds(60, 45, getWidth() - 70, 25);
+        previewButton.setBounds(10, getHeight() - 35, 100, 25);
+        applyButton.setBounds(getWidth() - 110, getHeight() - 35, 100, 25);
+    }
+
+private:
+    void parametersChanged()
+    {
+        apc.setTimeStretchParameters(static_cast<float>(stretchSlider.getValue() / 100.0),
+                                     static_cast<float>(pitchSlider.getValue()));
+    }
+
+    void applyButtonClicked()
+    {
+        previewButton.setToggleState(false, dontSendNotification);
+        apc.setTimeStretchPreview(false);
+        apc.timeStretchMarkedRegion(static_cast<float>(stretchSlider.getValue() / 100.0),
+                                    static_cast<float>(pitchSlider.getValue()));
+    }
+
+    AudioProcessingComponent& apc;
+    Slider stretchSlider;
+    Slider pitchSlider;
+    TextButton previewButton;
+    TextButton applyButton;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimeStretchVisualizer)
+};
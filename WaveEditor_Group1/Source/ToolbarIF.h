@@ -11,18 +11,21 @@
 #pragma once
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "AudioProcessingComponent.h"
+#include "DiagnosticsVisualizer.h"
+#include "RoutingVisualizer.h"
 #include "buttonAssets.h"
 
 
 class ToolbarIF : public Component, public ChangeListener
 {
 public:
-    ToolbarIF(AudioProcessingComponent& c) : apc(c)
+    ToolbarIF(AudioProcessingComponent& c) : editProgress(0.0), editProgressBar(editProgress), apc(c)
     {
         state = apc.getState(); //initialize transport source state
         apc.transportState.addChangeListener(this);
         apc.audioBufferChanged.addChangeListener(this);
         apc.audioCopied.addChangeListener(this);
+        apc.getEditQueue().addChangeListener(this);
         buttonHelp = new TooltipWindow(this);
 
         //-----------------------GUI Images------------------------------------
@@ -286,6 +289,65 @@ public:
         normalizeButton.onClick = [this] {apc.normalizeMarkedRegion(); };
         normalizeButton.setEnabled(false);
         normalizeButton.setTooltip("normalize (or right click->Normalize)");
+
+        //Diagnostics
+        addAndMakeVisible(&diagnosticsButton);
+        diagnosticsButton.setButtonText("Diagnostics");
+        diagnosticsButton.onClick = [this] {diagnosticsButtonClicked(); };
+        diagnosticsButton.setTooltip("audio callback timing and dropouts");
+
+        //Audio device settings
+        addAndMakeVisible(&audioSettingsButton);
+        audioSettingsButton.setButtonText("Audio Settings");
+        audioSettingsButton.onClick = [this] {audioSettingsButtonClicked(); };
+        audioSettingsButton.setTooltip("output device, sample rate and block size");
+
+        //Routing
+        addAndMakeVisible(&routingButton);
+        routingButton.setButtonText("Routing");
+        routingButton.onClick = [this] {routingButtonClicked(); };
+        routingButton.setTooltip("file channel to output routing");
+
+        //Resampler quality
+        addAndMakeVisible(&resamplerBox);
+        resamplerBox.addItem("Linear", PlaybackResampler::Linear + 1);
+        resamplerBox.addItem("Catmull-Rom", PlaybackResampler::CatmullRom + 1);
+        resamplerBox.addItem("Sinc", PlaybackResampler::WindowedSinc + 1);
+        resamplerBox.setSelectedId(apc.getResamplerQuality() + 1, dontSendNotification);
+        resamplerBox.onChange = [this] {apc.setResamplerQuality(static_cast<PlaybackResampler::Quality>(resamplerBox.getSelectedId() - 1)); };
+        resamplerBox.setTooltip("resampling quality when the file and device sample rates differ");
+
+        //Varispeed
+        addAndMakeVisible(&speedSlider);
+        speedSlider.setSliderStyle(Slider::LinearBar);
+        speedSlider.setRange(AudioProcessingComponent::minPlaybackRate, AudioProcessingComponent::maxPlaybackRate, 0.01);
+        speedSlider.setSkewFactorFromMidPoint(1.0);
+        speedSlider.setTextValueSuffix("x");
+        speedSlider.setValue(std::abs(apc.getPlaybackRate()), dontSendNotification);
+        speedSlider.onValueChange = [this] {speedChanged(); };
+        speedSlider.setDoubleClickReturnValue(true, 1.0);
+        speedSlider.setTooltip("playback speed, double click for 1x (alt + drag on the waveform to scrub)");
+
+        addAndMakeVisible(&reverseButton);
+        reverseButton.setButtonText("Rev");
+        reverseButton.setClickingTogglesState(true);
+        reverseButton.onClick = [this] {speedChanged(); };
+        reverseButton.setTooltip("play backwards");
+
+        //Loop crossfade
+        addAndMakeVisible(&crossfadeBox);
+        for (auto milliseconds : {0, 2, 5, 10, 50})
+            crossfadeBox.addItem(milliseconds == 0 ? String("No xfade") : String(milliseconds) + " ms xfade", milliseconds + 1);
+        crossfadeBox.setSelectedId(roundToInt(apc.getLoopCrossfade()) + 1, dontSendNotification);
+        crossfadeBox.onChange = [this] {apc.setLoopCrossfade(static_cast<float>(crossfadeBox.getSelectedId() - 1)); };
+        crossfadeBox.setTooltip("crossfade at the loop point");
+
+        //Edit progress, only shown while an edit runs
+        addChildComponent(&editProgressBar);
+        addChildComponent(&cancelEditButton);
+        cancelEditButton.setButtonText("Cancel");
+        cancelEditButton.onClick = [this] {apc.getEditQueue().cancelAll(); };
+        cancelEditButton.setTooltip("cancel the running and queued edits, the audio stays as it was");
     }
 
     ~ToolbarIF()
@@ -434,6 +496,17 @@ public:
             else
                 redoButton.setEnabled(false);
         }
+        else if (source == &apc.getEditQueue())
+        {
+            //the other edit buttons stay enabled, their edits are queued
+            auto& editQueue = apc.getEditQueue();
+            auto busy = !editQueue.isIdle();
+            editProgress = editQueue.getProgress();
+            auto numQueued = editQueue.getNumQueued();
+            editProgressBar.setTextToDisplay(editQueue.getCurrentName() + (numQueued > 0 ? " (+" + String(numQueued) + ")" : String()));
+            editProgressBar.setVisible(busy);
+            cancelEditButton.setVisible(busy);
+        }
         else if (source == &apc.audioCopied)
         {
             if (apc.isPasteEnabled())
@@ -499,6 +572,15 @@ public:
         fadeInButton.setBounds(298, 43, 30, 30);
         fadeOutButton.setBounds(331, 43, 30, 30);
         normalizeButton.setBounds(364, 43, 30, 30);
+        diagnosticsButton.setBounds(getWidth() - 90, 46, 80, 24);
+        resamplerBox.setBounds(getWidth() - 200, 46, 105, 24);
+        routingButton.setBounds(getWidth() - 280, 46, 75, 24);
+        audioSettingsButton.setBounds(getWidth() - 435, 13, 100, 24);
+        reverseButton.setBounds(getWidth() - 330, 13, 40, 24);
+        speedSlider.setBounds(getWidth() - 285, 13, 100, 24);
+        crossfadeBox.setBounds(getWidth() - 180, 13, 100, 24);
+        editProgressBar.setBounds(400, 46, jmax(0, getWidth() - 765), 24);
+        cancelEditButton.setBounds(getWidth() - 355, 46, 70, 24);
     }
 
     //==========================================================================
@@ -692,6 +774,53 @@ private:
             apc.loopOffRequested();
     }
 
+    void diagnosticsButtonClicked()
+    {
+        DialogWindow::LaunchOptions options;
+        options.content.setOwned(new DiagnosticsVisualizer(apc));
+        options.dialogTitle = "Diagnostics";
+        options.dialogBackgroundColour = Colour(32, 32, 32);
+        options.escapeKeyTriggersCloseButton = true;
+        options.useNativeTitleBar = true;
+        options.resizable = false;
+        options.launchAsync();
+    }
+
+    /*! The device can be changed while a file is loaded, JUCE restarts the
+    \   callback and prepares the component again for the new settings
+    */
+    void audioSettingsButtonClicked()
+    {
+        DialogWindow::LaunchOptions options;
+        auto selector = new AudioDeviceSelectorComponent(apc.deviceManager, 0, 0, 1, 256, false, false, true, false);
+        selector->setSize(500, 400);
+        options.content.setOwned(selector);
+        options.dialogTitle = "Audio Settings";
+        options.dialogBackgroundColour = Colour(32, 32, 32);
+        options.escapeKeyTriggersCloseButton = true;
+        options.useNativeTitleBar = true;
+        options.resizable = false;
+        options.launchAsync();
+    }
+
+    void routingButtonClicked()
+    {
+        DialogWindow::LaunchOptions options;
+        options.content.setOwned(new RoutingVisualizer(apc));
+        options.dialogTitle = "Routing";
+        options.dialogBackgroundColour = Colour(32, 32, 32);
+        options.escapeKeyTriggersCloseButton = true;
+        options.useNativeTitleBar = true;
+        options.resizable = false;
+        options.launchAsync();
+    }
+
+    void speedChanged()
+    {
+        auto speed = static_cast<float>(speedSlider.getValue());
+        apc.setPlaybackRate(reverseButton.getToggleState() ? -speed : speed);
+    }
+
     void mouseButtonClicked()
     {
         //toggle button state
@@ -725,6 +854,16 @@ private:
     ImageButton fadeInButton;
     ImageButton fadeOutButton;
     ImageButton normalizeButton;
+    TextButton diagnosticsButton;
+    ComboBox resamplerBox;
+    TextButton routingButton;
+    TextButton audioSettingsButton;
+    ComboBox crossfadeBox;
+    Slider speedSlider;
+    TextButton reverseButton;
+    double editProgress; //read by editProgressBar
+    ProgressBar editProgressBar;
+    TextButton cancelEditButton;
 
     //Image objects
     Image iPlayNormal;
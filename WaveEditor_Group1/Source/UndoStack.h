@@ -12,16 +12,50 @@
 
 #include <JuceHeader.h>
 #include "Utils.h"
+#include "RegionList.h"
 
+/*! A record can have several parts, e.g. one per region of a batch edit,
+\   which are undone and redone together as one step.
+*/
 class UndoRecord
 {
 public:
+    /*! One region of the document before and after the operation
+    */
+    struct Part
+    {
+        Part():
+        startSample(0)
+        {
+        }
+
+        Part(AudioBuffer<float> bufferBeforeOperation, AudioBuffer<float> bufferAfterOperation, int startSample):
+        bufferBeforeOperation(std::move(bufferBeforeOperation)),
+        bufferAfterOperation(std::move(bufferAfterOperation)),
+        startSample(startSample)
+        {
+        }
+
+        AudioBuffer<float> bufferBeforeOperation;
+        AudioBuffer<float> bufferAfterOperation;
+        int startSample;
+    };
+
     UndoRecord(AudioBuffer<float> bufferBeforeOperation, AudioBuffer<float> bufferAfterOperation, int startChannel, int startSample)
     {
-        this->bufferBeforeOperation = bufferBeforeOperation;
-        this->bufferAfterOperation = bufferAfterOperation;
+        parts.emplace_back(std::move(bufferBeforeOperation), std::move(bufferAfterOperation), startSample);
         this->startChannel = startChannel;
-        this->startSample = startSample;
+        sampleRateBeforeOperation = 0.0;
+        sampleRateAfterOperation = 0.0;
+    }
+
+    /*! A record without parts yet, for operations on several regions
+    */
+    UndoRecord():
+    startChannel(0),
+    sampleRateBeforeOperation(0.0),
+    sampleRateAfterOperation(0.0)
+    {
     }
     ~UndoRecord(){};
 
@@ -31,60 +65,105 @@ public:
         RedoBuffer
     };
 
-    int getNumSamples(BufferType bufferType)
+    /*! Parts are redone in the order they are added and undone in reverse,
+    \   each one has to keep the length of the audio it replaces
+    */
+    void addPart(Part part)
+    {
+        jassert (part.bufferBeforeOperation.getNumSamples() == part.bufferAfterOperation.getNumSamples());
+        parts.push_back(std::move(part));
+    }
+
+    int getNumParts()
+    {
+        return static_cast<int>(parts.size());
+    }
+
+    int getNumSamples(BufferType bufferType, int part = 0)
     {
         switch (bufferType)
         {
             case UndoBuffer:
-                return bufferBeforeOperation.getNumSamples();
+                return parts[static_cast<size_t>(part)].bufferBeforeOperation.getNumSamples();
             case RedoBuffer:
-                return bufferAfterOperation.getNumSamples();
+                return parts[static_cast<size_t>(part)].bufferAfterOperation.getNumSamples();
             default:
                 return 0;
         }
     }
 
-    int getNumChannels(BufferType bufferType)
+    int getNumChannels(BufferType bufferType, int part = 0)
     {
         switch (bufferType)
         {
             case UndoBuffer:
-                return bufferBeforeOperation.getNumChannels();
+                return parts[static_cast<size_t>(part)].bufferBeforeOperation.getNumChannels();
             case RedoBuffer:
-                return bufferAfterOperation.getNumChannels();
+                return parts[static_cast<size_t>(part)].bufferAfterOperation.getNumChannels();
             default:
                 return 0;
         }
     }
 
+    /*! For operations that change the document sample rate, e.g. sample rate conversion
+    */
+    void setSampleRates(double sampleRateBefore, double sampleRateAfter)
+    {
+        sampleRateBeforeOperation = sampleRateBefore;
+        sampleRateAfterOperation = sampleRateAfter;
+    }
+
+    /*! Returns the sample rate that goes with the buffer, 0 if the operation kept the rate
+    */
+    double getSampleRate(BufferType bufferType)
+    {
+        return bufferType == UndoBuffer ? sampleRateBeforeOperation : sampleRateAfterOperation;
+    }
+
+    /*! The regions the operation reshaped, as they were before and after it.
+    \   Regions it only moved follow the audio when it is undone or redone.
+    */
+    void setRegions(std::vector<Region> regionsBefore, std::vector<Region> regionsAfter)
+    {
+        this->regionsBefore = std::move(regionsBefore);
+        this->regionsAfter = std::move(regionsAfter);
+    }
+
+    const std::vector<Region>& getRegions(BufferType bufferType)
+    {
+        return bufferType == UndoBuffer ? regionsBefore : regionsAfter;
+    }
+
     int getStartChannel()
     {
         return startChannel;
     }
 
-    int getStartSample()
+    int getStartSample(int part = 0)
     {
-        return startSample;
+        return parts[static_cast<size_t>(part)].startSample;
     }
 
-    AudioBuffer<float>* getAudioBuffer(BufferType bufferType)
+    AudioBuffer<float>* getAudioBuffer(BufferType bufferType, int part = 0)
     {
         switch (bufferType)
         {
             case UndoBuffer:
-                return &bufferBeforeOperation;
+                return &parts[static_cast<size_t>(part)].bufferBeforeOperation;
             case RedoBuffer:
-                return &bufferAfterOperation;
+                return &parts[static_cast<size_t>(part)].bufferAfterOperation;
             default:
                 return nullptr;
         }
     }
 
 private:
-    AudioBuffer<float> bufferBeforeOperation;
-    AudioBuffer<float> bufferAfterOperation;
+    std::vector<Part> parts;
+    std::vector<Region> regionsBefore;
+    std::vector<Region> regionsAfter;
     int startChannel;
-    int startSample;
+    double sampleRateBeforeOperation;
+    double sampleRateAfterOperation;
 };
 
 class UndoStack
@@ -181,12 +260,30 @@ public:
             }
             std::reverse(undoStack.begin(),undoStack.end());
         }
-        undoStack.push_back(undoRecord);
+        undoStack.push_back(std::move(undoRecord));
         mode = RedoMode;
         stackPos++;
     }
 
     void undo(AudioBuffer<float>& audioBuffer, int& startSample, int& numSamples)
+    {
+        double sampleRate = 0.0;
+        undo(audioBuffer, startSample, numSamples, sampleRate);
+    }
+
+    void undo(AudioBuffer<float>& audioBuffer, int& startSample, int& numSamples, double& sampleRate)
+    {
+        std::vector<Region> regions;
+        undo(audioBuffer, startSample, numSamples, sampleRate, regions);
+    }
+
+    /*! sampleRate is set when the record changed the sample rate, regions
+    \   gets the regions to put back after the buffer change moved them.
+    \   preparedBuffer, if not null, is the document made by prepareUndo and
+    \   replaces audioBuffer instead of the record being applied to it.
+    */
+    void undo(AudioBuffer<float>& audioBuffer, int& startSample, int& numSamples, double& sampleRate, std::vector<Region>& regions,
+              AudioBuffer<float>* preparedBuffer = nullptr)
     {
         if(!isUndoEnabled())
             return;
@@ -195,16 +292,28 @@ public:
             stackPos--;
 
         auto record = getRecord(stackPos);
-        auto undoBuffer = record->getAudioBuffer(UndoRecord::UndoBuffer);
-        startSample = record->getStartSample();
-        auto replaceNumSamples = record->getNumSamples(UndoRecord::RedoBuffer);
-        numSamples = record->getNumSamples(UndoRecord::UndoBuffer);
-        AudioBufferUtils<float>::replaceRegion(audioBuffer, *undoBuffer, startSample, replaceNumSamples);
+        applyParts(*record, UndoRecord::UndoBuffer, audioBuffer, preparedBuffer, startSample, numSamples);
+        if (record->getSampleRate(UndoRecord::UndoBuffer) > 0.0)
+            sampleRate = record->getSampleRate(UndoRecord::UndoBuffer);
+        regions = record->getRegions(UndoRecord::UndoBuffer);
 
         mode = UndoMode;
     }
 
     void redo(AudioBuffer<float>& audioBuffer, int& startSample, int& numSamples)
+    {
+        double sampleRate = 0.0;
+        redo(audioBuffer, startSample, numSamples, sampleRate);
+    }
+
+    void redo(AudioBuffer<float>& audioBuffer, int& startSample, int& numSamples, double& sampleRate)
+    {
+        std::vector<Region> regions;
+        redo(audioBuffer, startSample, numSamples, sampleRate, regions);
+    }
+
+    void redo(AudioBuffer<float>& audioBuffer, int& startSample, int& numSamples, double& sampleRate, std::vector<Region>& regions,
+              AudioBuffer<float>* preparedBuffer = nullptr)
     {
         if(!isRedoEnabled())
             return;
@@ -213,16 +322,83 @@ public:
             stackPos++;
 
         auto record = getRecord(stackPos);
-        auto redoBuffer = record->getAudioBuffer(UndoRecord::RedoBuffer);
-        startSample = record->getStartSample();
-        auto replaceNumSamples = record->getNumSamples(UndoRecord::UndoBuffer);
-        numSamples = record->getNumSamples(UndoRecord::RedoBuffer);
-        AudioBufferUtils<float>::replaceRegion(audioBuffer, *redoBuffer, startSample, replaceNumSamples);
+        applyParts(*record, UndoRecord::RedoBuffer, audioBuffer, preparedBuffer, startSample, numSamples);
+        if (record->getSampleRate(UndoRecord::RedoBuffer) > 0.0)
+            sampleRate = record->getSampleRate(UndoRecord::RedoBuffer);
+        regions = record->getRegions(UndoRecord::RedoBuffer);
 
         mode = RedoMode;
     }
 
+    /*! Makes the document undo() would leave in preparedBuffer and returns
+    \   true, without changing audioBuffer or the stack. Returns false for a
+    \   record that keeps the length, undo() copies that one into place. Lets
+    \   the copying run on a worker while the stack isn't changed.
+    */
+    bool prepareUndo(const AudioBuffer<float>& audioBuffer, AudioBuffer<float>& preparedBuffer)
+    {
+        if(!isUndoEnabled())
+            return false;
+        auto record = getRecord(mode == UndoMode ? stackPos - 1 : stackPos);
+        return prepareParts(*record, UndoRecord::UndoBuffer, audioBuffer, preparedBuffer);
+    }
+
+    bool prepareRedo(const AudioBuffer<float>& audioBuffer, AudioBuffer<float>& preparedBuffer)
+    {
+        if(!isRedoEnabled())
+            return false;
+        auto record = getRecord(mode == RedoMode ? stackPos + 1 : stackPos);
+        return prepareParts(*record, UndoRecord::RedoBuffer, audioBuffer, preparedBuffer);
+    }
+
 private:
+    /*! Only a single part can change the length, batch edits keep it
+    */
+    static bool prepareParts(UndoRecord& record, UndoRecord::BufferType bufferType, const AudioBuffer<float>& audioBuffer, AudioBuffer<float>& preparedBuffer)
+    {
+        auto otherType = bufferType == UndoRecord::UndoBuffer ? UndoRecord::RedoBuffer : UndoRecord::UndoBuffer;
+        if (record.getNumParts() != 1 || record.getNumSamples(bufferType) == record.getNumSamples(otherType))
+            return false;
+        AudioBufferUtils<float>::copyWithRegionReplaced(audioBuffer, *record.getAudioBuffer(bufferType), record.getStartSample(),
+                                                       record.getNumSamples(otherType), preparedBuffer);
+        return true;
+    }
+
+    /*! Puts one side of every part of the record into audioBuffer, or moves
+    \   preparedBuffer there if there is one. startSample and numSamples get
+    \   the span of the parts afterwards.
+    */
+    static void applyParts(UndoRecord& record, UndoRecord::BufferType bufferType, AudioBuffer<float>& audioBuffer,
+                           AudioBuffer<float>* preparedBuffer, int& startSample, int& numSamples)
+    {
+        auto otherType = bufferType == UndoRecord::UndoBuffer ? UndoRecord::RedoBuffer : UndoRecord::UndoBuffer;
+        auto numParts = record.getNumParts();
+        auto spanStart = std::numeric_limits<int>::max();
+        auto spanEnd = 0;
+        for (int i=0; i<numParts; i++)
+        {
+            auto part = bufferType == UndoRecord::UndoBuffer ? numParts - 1 - i : i;
+            auto partStart = record.getStartSample(part);
+            auto partBuffer = record.getAudioBuffer(bufferType, part);
+            auto replaceLength = record.getNumSamples(otherType, part);
+            if (preparedBuffer == nullptr)
+            {
+                // a part that keeps the length is copied over, nothing has to move
+                if (partBuffer->getNumSamples() == replaceLength)
+                    for (int channel=0; channel<partBuffer->getNumChannels(); channel++)
+                        audioBuffer.copyFrom(channel, partStart, *partBuffer, channel, 0, replaceLength);
+                else
+                    AudioBufferUtils<float>::replaceRegion(audioBuffer, *partBuffer, partStart, replaceLength);
+            }
+            spanStart = jmin(spanStart, partStart);
+            spanEnd = jmax(spanEnd, partStart + record.getNumSamples(bufferType, part));
+        }
+        if (preparedBuffer != nullptr)
+            audioBuffer = std::move(*preparedBuffer);
+        startSample = numParts > 0 ? spanStart : 0;
+        numSamples = numParts > 0 ? spanEnd - spanStart : 0;
+    }
+
     UndoRecord* getRecord(int position)
     {
         return &undoStack[position];
@@ -12,6 +12,26 @@
 
 #include <JuceHeader.h>
 #include "Utils.h"
+#include "LevelIndex.h"
+#include "SilenceIndex.h"
+#include "ZeroCrossingIndex.h"
+#include "OnsetIndex.h"
+#include "SliceExporter.h"
+#include "RegionList.h"
+#include "BufferChange.h"
+#include "EditCommandQueue.h"
+#include "MeterAudio.h"
+#include "CallbackProfiler.h"
+#include "Resampler.h"
+#include "SampleRateConverter.h"
+#include "UndoStack.h"
+#include "ChannelRouter.h"
+#include "PlaybackReader.h"
+#include "TimeStretch.h"
+#include "Equalizer.h"
+#include "Dynamics.h"
+#include "NoiseReduction.h"
+#include "EffectChain.h"
 
 class KoolEditTest  : public UnitTest
 {
@@ -56,6 +76,738 @@ public:
         auto trueBufferWritePointer = trueBuffer.getWritePointer(0);
         for (int i=0; i<15; i++)
             expectEquals(testBufferWritePointer[i], trueBufferWritePointer[i], "insertRegion failed.");
+
+        ////////// Test copyWithRegionReplaced, it gives the same buffer as replaceRegion and leaves the source alone
+        AudioBuffer<float> replacedCopy;
+        AudioBufferUtils<float>::copyWithRegionReplaced(testBuffer, insertBuffer, 2, 8, replacedCopy);
+        AudioBufferUtils<float>::replaceRegion(trueBuffer, insertBuffer, 2, 8);
+        expectEquals(testBuffer.getNumSamples(), 15, "copyWithRegionReplaced changed its source.");
+        expectEquals(replacedCopy.getNumSamples(), trueBuffer.getNumSamples(), "copyWithRegionReplaced length wrong.");
+        for (int i=0; i<trueBuffer.getNumSamples(); i++)
+            expectEquals(replacedCopy.getSample(0, i), trueBuffer.getSample(0, i), "copyWithRegionReplaced failed.");
+
+        beginTest ("LevelIndexTest");
+
+        ////////// Test range queries against a direct scan, before and after a delete
+        AudioBuffer<float> levelBuffer {1, 5000};
+        writePointer = levelBuffer.getWritePointer(0);
+        for (int i=0; i<levelBuffer.getNumSamples(); i++)
+            writePointer[i] = std::sin(0.003f * i) * (i % 7) / 7.f;
+        LevelIndex levelIndex {64};
+        levelIndex.rebuild(levelBuffer);
+        expectEquals(levelIndex.getLevels(levelBuffer, 0, 10, 4321).peak, levelBuffer.getMagnitude(0, 10, 4321), "peak query failed.");
+        expectWithinAbsoluteError(levelIndex.getLevels(levelBuffer, 0, 100, 3000).getRMS(), levelBuffer.getRMSLevel(0, 100, 3000), 1e-5f, "RMS query failed.");
+
+        AudioBufferUtils<float>::deleteRegion(levelBuffer, 1000, 1500);
+        levelIndex.update(levelBuffer, 1000, 1500, 0);
+        expectEquals(levelIndex.getLevels(levelBuffer, 0, 0, 3500).peak, levelBuffer.getMagnitude(0, 0, 3500), "peak query after delete failed.");
+
+        beginTest ("LoudnessMeterTest");
+
+        ////////// A stereo 1 kHz sine with a -20 dBFS peak measures -20 LUFS
+        AudioBuffer<float> sineBuffer {2, 48000 * 5};
+        for (int channel=0; channel<2; channel++)
+        {
+            writePointer = sineBuffer.getWritePointer(channel);
+            for (int i=0; i<sineBuffer.getNumSamples(); i++)
+                writePointer[i] = 0.1f * std::sin(MathConstants<float>::twoPi * 1000.f * i / 48000.f);
+        }
+        auto loudness = LoudnessMeter::measure(sineBuffer, 0, sineBuffer.getNumSamples(), 48000.0);
+        expectWithinAbsoluteError(loudness.integratedLoudness, -20.f, 0.1f, "integrated loudness failed.");
+        expectWithinAbsoluteError(loudness.truePeak, -20.f, 0.1f, "true peak failed.");
+
+        beginTest ("LevelMeterTest");
+
+        ////////// The peak is held until it is read, the RMS settles on the block RMS
+        LevelMeter levelMeter;
+        levelMeter.prepare(48000.0);
+        for (int block=0; block<400; block++)
+            levelMeter.process(sineBuffer, block * 480, 480);
+        expectEquals(levelMeter.getNumChannels(), 2, "channel count failed.");
+        expectWithinAbsoluteError(levelMeter.getAndResetPeak(0), 0.1f, 1e-4f, "peak failed.");
+        expectEquals(levelMeter.getAndResetPeak(0), 0.f, "peak was not reset.");
+        expectWithinAbsoluteError(levelMeter.getRMS(1), 0.1f / std::sqrt(2.f), 1e-3f, "RMS failed.");
+
+        beginTest ("CallbackProfilerTest");
+
+        ////////// Every callback lands in exactly one histogram bin
+        CallbackProfiler profiler;
+        profiler.prepare(48000.0);
+        for (int callback=0; callback<10; callback++)
+            profiler.callbackFinished(profiler.callbackStarted(512), 512, 2);
+        uint64 histogramTotal = 0;
+        for (int bin=0; bin<CallbackProfiler::numHistogramBins; bin++)
+            histogramTotal += profiler.getHistogramBin(bin);
+        expectEquals(static_cast<int>(profiler.getNumCallbacks()), 10, "callback count failed.");
+        expectEquals(static_cast<int>(histogramTotal), 10, "histogram failed.");
+        expectEquals(profiler.getAverageLoopIterations(), 2.0, "loop iteration count failed.");
+
+        beginTest ("PlaybackResamplerTest");
+
+        ////////// 44.1k to 48k, every quality follows a 1 kHz sine once its latency is accounted for
+        AudioBuffer<float> resamplerInput {1, 44100};
+        writePointer = resamplerInput.getWritePointer(0);
+        for (int i=0; i<resamplerInput.getNumSamples(); i++)
+            writePointer[i] = std::sin(MathConstants<float>::twoPi * 1000.f * i / 44100.f);
+        for (auto quality : {PlaybackResampler::Linear, PlaybackResampler::CatmullRom, PlaybackResampler::WindowedSinc})
+        {
+            PlaybackResampler resampler;
+            resampler.prepare(1);
+            resampler.setQuality(quality);
+            resampler.setSpeedRatio(44100.0 / 48000.0);
+            AudioBuffer<float> resamplerOutput {1, 4800};
+            auto numUsed = resampler.process(44100.0 / 48000.0, resamplerInput, 0, resamplerInput.getNumSamples(),
+                                             resamplerOutput, 0, resamplerOutput.getNumSamples());
+            expectEquals(numUsed, 4410, "consumed input count failed.");
+            auto i = 4000;
+            auto expected = std::sin(MathConstants<double>::twoPi * 1000.0 * (i * 44100.0 / 48000.0 - resampler.getLatency()) / 44100.0);
+            expectWithinAbsoluteError(resamplerOutput.getSample(0, i), static_cast<float>(expected), 5e-3f, "resampled value failed.");
+        }
+
+        beginTest ("SampleRateConverterTest");
+
+        ////////// Offline 44.1k to 48k conversion, undone together with the sample rate
+        AudioBuffer<float> convertedBuffer;
+        SampleRateConverter::process(resamplerInput, 44100.0, 48000.0, convertedBuffer);
+        expectEquals(convertedBuffer.getNumSamples(), 48000, "converted length failed.");
+        expectWithinAbsoluteError(convertedBuffer.getSample(0, 12345),
+                                  std::sin(MathConstants<float>::twoPi * 1000.f * 12345.f / 48000.f), 1e-3f, "converted value failed.");
+
+        UndoStack conversionUndoStack;
+        UndoRecord conversionRecord {resamplerInput, convertedBuffer, 0, 0};
+        conversionRecord.setSampleRates(44100.0, 48000.0);
+        conversionUndoStack.addRecord(std::move(conversionRecord));
+        int undoStart = 0;
+        int undoLength = 0;
+        double undoSampleRate = 0.0;
+        conversionUndoStack.undo(convertedBuffer, undoStart, undoLength, undoSampleRate);
+        expectEquals(convertedBuffer.getNumSamples(), 44100, "undo length failed.");
+        expectEquals(undoSampleRate, 44100.0, "undo sample rate failed.");
+
+        beginTest ("ChannelRouterTest");
+
+        ////////// 5.1 to stereo downmix, then a matrix edit picked up by the next block
+        AudioBuffer<float> surroundBuffer {6, 64};
+        for (int channel=0; channel<6; channel++)
+            FloatVectorOperations::fill(surroundBuffer.getWritePointer(channel), static_cast<float>(channel + 1), 64);
+        AudioBuffer<float> stereoBuffer {2, 64};
+        ChannelRouter router;
+        router.prepare(6, 2);
+        router.process(surroundBuffer, 0, stereoBuffer, 0, 64);
+        expectWithinAbsoluteError(stereoBuffer.getSample(0, 10), 1.f + 0.7071f * (3.f + 5.f), 1e-3f, "left downmix failed.");
+        expectWithinAbsoluteError(stereoBuffer.getSample(1, 10), 2.f + 0.7071f * (3.f + 6.f), 1e-3f, "right downmix failed.");
+        router.setGain(0, 3, 1.f);
+        router.process(surroundBuffer, 0, stereoBuffer, 0, 64);
+        expectWithinAbsoluteError(stereoBuffer.getSample(0, 10), 1.f + 0.7071f * (3.f + 5.f) + 4.f, 1e-3f, "matrix update failed.");
+
+        beginTest ("PlaybackReaderTest");
+
+        ////////// A 10 sample loop read past its end several times, then with a 4 sample crossfade
+        AudioBuffer<float> rampBuffer {1, 1000};
+        for (int i=0; i<rampBuffer.getNumSamples(); i++)
+            rampBuffer.setSample(0, i, static_cast<float>(i));
+        PlaybackReader reader;
+        reader.prepare(1, 64);
+        expectEquals(reader.read(rampBuffer, 105, 100, 110, true, 0, 25), 25, "looped read length failed.");
+        expectEquals(reader.getBuffer().getSample(0, 4), 109.f, "sample before the loop end failed.");
+        expectEquals(reader.getBuffer().getSample(0, 5), 100.f, "loop wrap failed.");
+        expectEquals(reader.getBuffer().getSample(0, 24), 109.f, "second loop wrap failed.");
+        expectEquals(PlaybackReader::advance(105, 25, 100, 110, true), 100, "looped advance failed.");
+        expectEquals(reader.read(rampBuffer, 995, 100, 110, false, 0, 25), 5, "read at the end of the file failed.");
+
+        reader.read(rampBuffer, 100, 100, 110, true, 4, 20);
+        expectEquals(reader.getBuffer().getSample(0, 5), 105.f, "sample before the crossfade failed.");
+        expectWithinAbsoluteError(reader.getBuffer().getSample(0, 6), 106.f * 0.98079f + 96.f * 0.19509f, 1e-2f, "crossfade failed.");
+        expectEquals(reader.getBuffer().getSample(0, 10), 100.f, "sample after the crossfade failed.");
+
+        ////////// A loop from the start of the file has no pre-roll, its start fades in over what follows the loop end
+        reader.read(rampBuffer, 0, 0, 10, true, 4, 20);
+        expectWithinAbsoluteError(reader.getBuffer().getSample(0, 0), 0.f * 0.19509f + 10.f * 0.98079f, 1e-2f, "crossfade at the loop start failed.");
+        expectEquals(reader.getBuffer().getSample(0, 4), 4.f, "sample after the loop start crossfade failed.");
+        expectEquals(reader.getBuffer().getSample(0, 9), 9.f, "sample before the loop end failed.");
+        expectWithinAbsoluteError(reader.getBuffer().getSample(0, 10), reader.getBuffer().getSample(0, 0), 1e-6f, "wrapped crossfade failed.");
+
+        ////////// The same loop played backwards wraps from its start to its end
+        reader.read(rampBuffer, 103, 100, 110, true, 0, 10, true);
+        expectEquals(reader.getBuffer().getSample(0, 0), 102.f, "reverse read failed.");
+        expectEquals(reader.getBuffer().getSample(0, 3), 109.f, "reverse loop wrap failed.");
+        expectEquals(PlaybackReader::advance(103, 10, 100, 110, true, true), 103, "reverse advance failed.");
+
+        beginTest ("TimeStretchTest");
+
+        ////////// A 440 Hz sine stretched to 1.5 times its length keeps its pitch, shifted an octave up keeps its length
+        AudioBuffer<float> stretchInput {1, 48000};
+        for (int i=0; i<stretchInput.getNumSamples(); i++)
+            stretchInput.setSample(0, i, 0.5f * std::sin(MathConstants<float>::twoPi * 440.f * i / 48000.f));
+        auto countCrossings = [](const AudioBuffer<float>& buffer, int start, int numSamples) {
+            int crossings = 0;
+            for (int i=start+1; i<start+numSamples; i++)
+                if ((buffer.getSample(0, i - 1) < 0.f) != (buffer.getSample(0, i) < 0.f))
+                    crossings++;
+            return crossings;
+        };
+        AudioBuffer<float> stretchedBuffer;
+        TimeStretcher::process(stretchInput, 1.5, 1.0, stretchedBuffer);
+        expectEquals(stretchedBuffer.getNumSamples(), 72000, "stretched length failed.");
+        expectWithinAbsoluteError(countCrossings(stretchedBuffer, 24000, 24000), 440, 4, "stretched pitch failed.");
+        TimeStretcher::process(stretchInput, 1.0, 2.0, stretchedBuffer);
+        expectEquals(stretchedBuffer.getNumSamples(), 48000, "shifted length failed.");
+        expectWithinAbsoluteError(countCrossings(stretchedBuffer, 12000, 24000), 880, 4, "shifted pitch failed.");
+
+        beginTest ("EffectChainTest");
+
+        ////////// -6 dB and a 10 ms fade in rendered to a region of ones, then the same chain live
+        EffectChain chain;
+        chain.prepare(1000.0, 2, 64);
+        chain.addEffect(EffectChain::createEffect("Gain"));
+        chain.getEffect(0)->setParameter(GainEffect::gainParameter, -6.f);
+        chain.addEffect(EffectChain::createEffect("Fade"));
+        chain.getEffect(1)->setParameter(FadeEffect::fadeInParameter, 10.f);
+        chain.getEffect(1)->setParameter(FadeEffect::fadeOutParameter, 0.f);
+        AudioBuffer<float> chainBuffer {2, 100};
+        for (int channel=0; channel<2; channel++)
+            FloatVectorOperations::fill(chainBuffer.getWritePointer(channel), 1.f, 100);
+        chain.render(chainBuffer, 1000.0, 200, 299);
+        expectEquals(chainBuffer.getSample(1, 0), 0.f, "fade start failed.");
+        expectWithinAbsoluteError(chainBuffer.getSample(1, 5), 0.5f * 0.5012f, 1e-3f, "fade middle failed.");
+        expectWithinAbsoluteError(chainBuffer.getSample(0, 50), 0.5012f, 1e-3f, "rendered gain failed.");
+
+        chain.getEffect(1)->setBypassed(true);
+        for (int channel=0; channel<2; channel++)
+            FloatVectorOperations::fill(chainBuffer.getWritePointer(channel), 1.f, 100);
+        chain.process(chainBuffer, 0, 64, {0.0, 1.0, 1000.0, 0, 99});
+        expectGreaterThan(chainBuffer.getSample(0, 10), 0.9f, "gain ramp failed.");
+        chain.process(chainBuffer, 64, 36, {64.0, 1.0, 1000.0, 0, 99});
+        expectWithinAbsoluteError(chainBuffer.getSample(0, 80), 0.5012f, 1e-3f, "live gain failed.");
+        chain.removeEffect(0);
+        FloatVectorOperations::fill(chainBuffer.getWritePointer(0), 1.f, 100);
+        chain.process(chainBuffer, 0, 100, {0.0, 1.0, 1000.0, 0, 99});
+        expectEquals(chainBuffer.getSample(0, 80), 1.f, "removed effect still applied.");
+
+        beginTest ("EqualizerTest");
+
+        ////////// A 6 dB peak at 1 kHz boosts 1 kHz on all 6 channels and leaves 100 Hz alone, a 1 kHz high pass cuts 100 Hz
+        auto measureGain = [](const std::vector<EqBand>& bands, double frequency) {
+            AudioBuffer<float> toneBuffer {6, 48000};
+            for (int channel=0; channel<6; channel++)
+                for (int i=0; i<toneBuffer.getNumSamples(); i++)
+                    toneBuffer.setSample(channel, i, static_cast<float>(std::sin(MathConstants<double>::twoPi * frequency * i / 48000.0)));
+            ParametricEqualizer::process(toneBuffer, 48000.0, bands);
+            return toneBuffer.getMagnitude(5, 24000, 24000);
+        };
+        std::vector<EqBand> peakBand {{EqBand::Peak, 1000.0, 6.0, 1.0}};
+        expectWithinAbsoluteError(measureGain(peakBand, 1000.0), 1.995f, 1e-2f, "peak gain failed.");
+        expectWithinAbsoluteError(measureGain(peakBand, 100.0), 1.f, 2e-2f, "peak gain away from the band failed.");
+        std::vector<EqBand> highPassBand {{EqBand::HighPass, 1000.0, 0.0, 0.7071}};
+        expectLessThan(measureGain(highPassBand, 100.0), 0.02f, "high pass failed.");
+        expectWithinAbsoluteError(measureGain(highPassBand, 10000.0), 1.f, 2e-2f, "high pass pass band failed.");
+
+        beginTest ("DynamicsTest");
+
+        ////////// A limiter leaves the quiet half untouched and in place and holds the loud half under -1 dBTP
+        AudioBuffer<float> dynamicsBuffer {2, 48000};
+        for (int channel=0; channel<2; channel++)
+            for (int i=0; i<dynamicsBuffer.getNumSamples(); i++)
+                dynamicsBuffer.setSample(channel, i, (i < 24000 ? 0.1f : 1.5f + channel * 0.5f)
+                                                     * std::sin(MathConstants<float>::twoPi * 997.f * i / 48000.f));
+        AudioBuffer<float> dynamicsInput;
+        dynamicsInput.makeCopyOf(dynamicsBuffer);
+        DynamicsProcessor::process(dynamicsBuffer, 48000.0, LimiterEffect::makeSettings(-1.f, 100.f, 5.f));
+        expectWithinAbsoluteError(dynamicsBuffer.getSample(0, 12345), dynamicsInput.getSample(0, 12345), 1e-6f, "limiter latency failed.");
+        auto limitedPeak = TruePeakDetector::findTruePeak(dynamicsBuffer.getReadPointer(1), 48000, 0, 48000, 0.f);
+        expectLessOrEqual(limitedPeak, Decibels::decibelsToGain(-1.f) + 1e-4f, "limiter ceiling failed.");
+        expectWithinAbsoluteError(dynamicsBuffer.getMagnitude(0, 36000, 12000), 0.75f * Decibels::decibelsToGain(-1.f), 1e-2f, "linked gain failed.");
+
+        ////////// Unlinked 4:1 compression above -20 dB leaves the quiet channel alone
+        DynamicsSettings compressorSettings;
+        compressorSettings.thresholdDb = -20.f;
+        compressorSettings.kneeDb = 0.f;
+        compressorSettings.linked = false;
+        dynamicsBuffer.makeCopyOf(dynamicsInput);
+        DynamicsProcessor::process(dynamicsBuffer, 48000.0, compressorSettings);
+        expectWithinAbsoluteError(dynamicsBuffer.getMagnitude(0, 6000, 12000), 0.1f, 1e-3f, "quiet channel changed.");
+        expectLessThan(dynamicsBuffer.getMagnitude(1, 36000, 12000), 0.3f, "compression failed.");
+
+        beginTest ("NoiseReductionTest");
+
+        ////////// A tone in noise keeps its level while the noise learned from a noise only buffer drops by about 20 dB
+        Random noiseRandom (42);
+        AudioBuffer<float> noiseOnly {1, 48000};
+        AudioBuffer<float> toneInNoise {1, 96000};
+        for (int i=0; i<noiseOnly.getNumSamples(); i++)
+            noiseOnly.setSample(0, i, 0.05f * (noiseRandom.nextFloat() - 0.5f));
+        for (int i=0; i<toneInNoise.getNumSamples(); i++)
+            toneInNoise.setSample(0, i, 0.05f * (noiseRandom.nextFloat() - 0.5f)
+                                        + (i >= 48000 ? 0.5f * std::sin(MathConstants<float>::twoPi * 1000.f * i / 48000.f) : 0.f));
+        NoiseProfile profile;
+        profile.capture(noiseOnly);
+        AudioBuffer<float> reduced {1, 96000};
+        SpectralNoiseReducer::process(toneInNoise, reduced, profile, 20.f, 2.f);
+        expectLessThan(reduced.getRMSLevel(0, 4000, 40000), 0.1f * toneInNoise.getRMSLevel(0, 4000, 40000) * 1.5f, "noise not reduced.");
+        expectWithinAbsoluteError(reduced.getRMSLevel(0, 52000, 40000), 0.5f * std::sqrt(0.5f), 1e-2f, "tone level changed.");
+
+        beginTest ("SilenceIndexTest");
+
+        ////////// 1 s of silence that runs on through a quiet part inside the hysteresis, a gap shorter than the minimum, silence at the end
+        AudioBuffer<float> silenceBuffer {2, 4 * 48000};
+        for (int channel=0; channel<2; channel++)
+        {
+            for (int i=0; i<silenceBuffer.getNumSamples(); i++)
+            {
+                auto amplitude = 0.5f;
+                if (i >= 48000 && i < 96000)
+                    amplitude = 0.f;
+                else if (i >= 96000 && i < 120000)
+                    amplitude = 0.0063f;    // about -47 dB RMS
+                else if (i >= 144000 && i < 148800)
+                    amplitude = 0.f;
+                else if (i >= 168000 && (channel == 0 || i >= 172000))
+                    amplitude = 0.f;
+                silenceBuffer.setSample(channel, i, amplitude * std::sin(0.05f * i));
+            }
+        }
+        LevelIndex silenceLevels;
+        silenceLevels.rebuild(silenceBuffer);
+        SilenceIndex silenceIndex;
+        silenceIndex.setSampleRate(48000.0);
+        silenceIndex.setSettings(SilenceSettings(), silenceLevels, silenceBuffer.getNumSamples());
+        auto spans = silenceIndex.getSpans();
+        expectEquals(static_cast<int>(spans.size()), 2, "wrong number of silent spans.");
+        if (spans.size() == 2)
+        {
+            expectWithinAbsoluteError(spans[0].getStart(), 48000, 256, "silence start wrong.");
+            expectWithinAbsoluteError(spans[0].getEnd(), 120000, 256, "hysteresis ignored.");
+            expectWithinAbsoluteError(spans[1].getStart(), 172000, 256, "linked channels ignored.");
+            expectEquals(spans[1].getEnd(), silenceBuffer.getNumSamples(), "silence at the end missing.");
+        }
+
+        ////////// Incremental updates match a full rebuild, after a delete and after an in-place mute
+        auto expectSameSpans = [this](const SilenceIndex& updated, const SilenceIndex& rebuilt, const String& message) {
+            auto updatedSpans = updated.getSpans();
+            auto rebuiltSpans = rebuilt.getSpans();
+            expectEquals(static_cast<int>(updatedSpans.size()), static_cast<int>(rebuiltSpans.size()), message);
+            for (size_t i=0; i<jmin(updatedSpans.size(), rebuiltSpans.size()); i++)
+                expect(updatedSpans[i] == rebuiltSpans[i], message);
+        };
+        SilenceIndex rebuiltIndex;
+        rebuiltIndex.setSampleRate(48000.0);
+        AudioBufferUtils<float>::deleteRegion(silenceBuffer, 60000, 12345);
+        silenceLevels.update(silenceBuffer, 60000, 12345, 0);
+        silenceIndex.update(silenceLevels, silenceBuffer.getNumSamples(), 60000, 12345, 0);
+        rebuiltIndex.rebuild(silenceLevels, silenceBuffer.getNumSamples());
+        expectSameSpans(silenceIndex, rebuiltIndex, "update after delete failed.");
+
+        for (int channel=0; channel<2; channel++)
+            AudioProcessingUtils::mute(silenceBuffer.getWritePointer(channel), 20000, 20000);
+        silenceLevels.update(silenceBuffer, 20000, 20000, 20000);
+        silenceIndex.update(silenceLevels, silenceBuffer.getNumSamples(), 20000, 20000, 20000);
+        rebuiltIndex.rebuild(silenceLevels, silenceBuffer.getNumSamples());
+        expectSameSpans(silenceIndex, rebuiltIndex, "update after mute failed.");
+
+        ////////// Deleting the spans in one pass gives the same buffer as deleting them one by one from the back
+        AudioBuffer<float> stripped;
+        stripped.makeCopyOf(silenceBuffer);
+        AudioBuffer<float> strippedOneByOne;
+        strippedOneByOne.makeCopyOf(silenceBuffer);
+        spans = silenceIndex.getSpans();
+        AudioBufferUtils<float>::deleteRegions(stripped, spans);
+        for (auto span=spans.rbegin(); span!=spans.rend(); span++)
+            AudioBufferUtils<float>::deleteRegion(strippedOneByOne, span->getStart(), span->getLength());
+        expectEquals(stripped.getNumSamples(), strippedOneByOne.getNumSamples(), "deleteRegions length wrong.");
+        for (int channel=0; channel<2; channel++)
+            for (int i=0; i<stripped.getNumSamples(); i++)
+                expectEquals(stripped.getSample(channel, i), strippedOneByOne.getSample(channel, i), "deleteRegions failed.");
+        AudioBuffer<float> strippedCopy;
+        AudioBufferUtils<float>::copyWithRegionsDeleted(silenceBuffer, spans, strippedCopy);
+        expectEquals(strippedCopy.getNumSamples(), stripped.getNumSamples(), "copyWithRegionsDeleted length wrong.");
+        for (int channel=0; channel<2; channel++)
+            for (int i=0; i<stripped.getNumSamples(); i++)
+                expectEquals(strippedCopy.getSample(channel, i), stripped.getSample(channel, i), "copyWithRegionsDeleted failed.");
+
+        beginTest ("ZeroCrossingIndexTest");
+
+        ////////// Nearest crossings match a direct search while building, once built and after a delete
+        AudioBuffer<float> crossingBuffer {2, 300000};
+        for (int channel=0; channel<2; channel++)
+            for (int i=0; i<crossingBuffer.getNumSamples(); i++)
+                crossingBuffer.setSample(channel, i, std::sin(0.0013f * (channel + 1) * i) + 0.3f * std::sin(0.021f * i));
+        auto directNearest = [&crossingBuffer](int channel, int position, int maxDistance) {
+            auto samples = crossingBuffer.getReadPointer(channel);
+            for (int distance=0; distance<=maxDistance; distance++)
+            {
+                for (auto i : {position - distance, position + distance})
+                {
+                    if (i < 1 || i >= crossingBuffer.getNumSamples() || (samples[i - 1] < 0.f) == (samples[i] < 0.f))
+                        continue;
+                    return std::abs(samples[i - 1]) < std::abs(samples[i]) ? i - 1 : i;
+                }
+            }
+            return -1;
+        };
+        auto expectNearestCrossings = [&](const ZeroCrossingIndex& index, const String& message) {
+            Random positionRandom (7);
+            for (int i=0; i<500; i++)
+            {
+                auto channel = i % 2;
+                auto position = positionRandom.nextInt(crossingBuffer.getNumSamples());
+                expectEquals(index.getNearest(channel, position, 3000), directNearest(channel, position, 3000), message);
+            }
+        };
+        ZeroCrossingIndex crossingIndex;
+        crossingIndex.rebuild(crossingBuffer);
+        expectNearestCrossings(crossingIndex, "query while building failed.");
+        expect(crossingIndex.waitUntilBuilt(10000), "index not built.");
+        expectNearestCrossings(crossingIndex, "query failed.");
+        expectLessThan(crossingIndex.getMemoryUsage(), static_cast<size_t>(crossingBuffer.getNumSamples()), "index not compact.");
+
+        crossingIndex.stopBuilding();
+        AudioBufferUtils<float>::deleteRegion(crossingBuffer, 70000, 12345);
+        crossingIndex.update(70000, 12345, 0);
+        expect(crossingIndex.waitUntilBuilt(10000), "index not updated.");
+        expectNearestCrossings(crossingIndex, "query after delete failed.");
+
+        ////////// Snapping lands on a sign change of one of the channels
+        auto snapped = crossingIndex.snap(123456, 3000);
+        expect(snapped == directNearest(0, 123456, 3000) || snapped == directNearest(1, 123456, 3000), "snap failed.");
+
+        beginTest ("OnsetIndexTest");
+
+        ////////// Decaying noise bursts over a quiet sine are found near their attacks
+        const double onsetSampleRate = 48000.0;
+        AudioBuffer<float> onsetBuffer {2, 480000};
+        for (int channel=0; channel<2; channel++)
+            for (int i=0; i<onsetBuffer.getNumSamples(); i++)
+                onsetBuffer.setSample(channel, i, 0.05f * std::sin(0.02f * i));
+        std::vector<int> attacks;
+        Random burstRandom (3);
+        for (int attack=12345; attack<onsetBuffer.getNumSamples()-20000; attack+=9000+burstRandom.nextInt(20000))
+        {
+            attacks.push_back(attack);
+            auto amplitude = 0.2f + 0.8f * burstRandom.nextFloat();
+            for (int i=0; i<8000; i++)
+            {
+                auto burst = amplitude * std::exp(-i / 1500.f) * (2.f * burstRandom.nextFloat() - 1.f);
+                onsetBuffer.addSample(0, attack + i, burst);
+                onsetBuffer.addSample(1, attack + i, 0.7f * burst);
+            }
+        }
+        std::vector<int> detected;
+        OnsetDetector::detect(onsetBuffer, 0, onsetBuffer.getNumSamples(), onsetSampleRate, OnsetSettings(), detected);
+        expectEquals(static_cast<int>(detected.size()), static_cast<int>(attacks.size()), "wrong number of onsets.");
+        for (size_t i=0; i<jmin(detected.size(), attacks.size()); i++)
+            expectLessThan(std::abs(detected[i] - attacks[i]), static_cast<int>(OnsetDetector::hop), "onset not at the attack.");
+
+        ////////// The index finds the same onsets in segments, and follows a delete
+        OnsetIndex onsetIndex;
+        onsetIndex.rebuild(onsetBuffer, onsetSampleRate);
+        expect(onsetIndex.waitUntilBuilt(10000), "onset index not built.");
+        expect(onsetIndex.getOnsets(0, onsetBuffer.getNumSamples()) == detected, "onset index differs from detection.");
+
+        onsetIndex.stopBuilding();
+        AudioBufferUtils<float>::deleteRegion(onsetBuffer, 100000, 30000);
+        onsetIndex.update(100000, 30000, 0, onsetSampleRate);
+        expect(onsetIndex.waitUntilBuilt(10000), "onset index not updated.");
+        detected.clear();
+        OnsetDetector::detect(onsetBuffer, 0, onsetBuffer.getNumSamples(), onsetSampleRate, OnsetSettings(), detected);
+        auto updated = onsetIndex.getOnsets(0, onsetBuffer.getNumSamples());
+        expectEquals(static_cast<int>(updated.size()), static_cast<int>(detected.size()), "wrong number of onsets after delete.");
+        for (size_t i=0; i<jmin(updated.size(), detected.size()); i++)
+            expectLessThan(std::abs(updated[i] - detected[i]), static_cast<int>(OnsetDetector::hop), "onset moved wrongly after delete.");
+
+        auto slice = onsetIndex.getSliceAt(updated[3] + 10);
+        expect(slice.getStart() == updated[3] && slice.getEnd() == updated[4], "wrong slice.");
+
+        beginTest ("SliceExporterTest");
+
+        ////////// Every slice ends up in its own file with its own samples
+        expectEquals(SliceExporter::createFileName("take_{index}_{start}", 41, 2000, {5, 9}), String("take_0042_5.wav"), "wrong file name.");
+        expectEquals(SliceExporter::createFileName("take", 41, 2000, {5, 9}), String("take_0042.wav"), "a template without the index makes the files collide.");
+
+        AudioBuffer<float> sliceBuffer {2, 100000};
+        for (int channel=0; channel<2; channel++)
+            for (int i=0; i<sliceBuffer.getNumSamples(); i++)
+                sliceBuffer.setSample(channel, i, 0.5f * std::sin(0.001f * (channel + 1) * i));
+        std::vector<Range<int>> slices;
+        for (int start=0; start<sliceBuffer.getNumSamples(); start+=7000)
+            slices.push_back({start, jmin(sliceBuffer.getNumSamples(), start + 5000 + start / 10)});
+
+        SliceExportSettings exportSettings;
+        exportSettings.directory = File::createTempFile("slices");
+        SliceExporter exporter (3);
+        expect(exporter.start(sliceBuffer, 48000.0, slices, exportSettings), "export not started.");
+        expect(exporter.waitUntilFinished(10000), "export not finished.");
+        expectEquals(exporter.getNumFilesWritten(), static_cast<int>(slices.size()), "wrong number of files.");
+        expectEquals(exporter.getProgress(), 1.0, "wrong progress.");
+
+        WavAudioFormat wavFormat;
+        for (size_t index=0; index<slices.size(); index++)
+        {
+            auto file = exportSettings.directory.getChildFile(SliceExporter::createFileName(exportSettings.nameTemplate, static_cast<int>(index),
+                                                                                             static_cast<int>(slices.size()), slices[index]));
+            std::unique_ptr<AudioFormatReader> reader (wavFormat.createReaderFor(new FileInputStream(file), true));
+            expect(reader != nullptr, "slice file missing.");
+            if (reader == nullptr)
+                continue;
+            expectEquals(static_cast<int>(reader->lengthInSamples), slices[index].getLength(), "wrong slice length.");
+            AudioBuffer<float> readBack {2, slices[index].getLength()};
+            reader->read(&readBack, 0, readBack.getNumSamples(), 0, true, true);
+            expectWithinAbsoluteError(readBack.getSample(1, 100), sliceBuffer.getSample(1, slices[index].getStart() + 100), 1e-5f, "wrong slice samples.");
+        }
+        exportSettings.directory.deleteRecursively();
+
+        beginTest ("RegionListTest");
+
+        ////////// Queries and edits match a plain list of regions
+        RegionList regionList;
+        std::vector<Region> plainRegions;
+        Random regionRandom (5);
+        auto overlaps = [](const Region& region, int start, int end) {
+            return region.range.getStart() < end && jmax(region.range.getEnd(), region.range.getStart() + 1) > start;
+        };
+        for (int step=0; step<3000; step++)
+        {
+            auto operation = regionRandom.nextInt(8);
+            if (operation < 3 || plainRegions.empty())
+            {
+                auto start = regionRandom.nextInt(100000);
+                Range<int> range (start, start + (regionRandom.nextInt(3) == 0 ? 0 : regionRandom.nextInt(5000)));
+                plainRegions.push_back({regionList.add("Region", range), "Region", range});
+            }
+            else if (operation == 3)
+            {
+                auto index = static_cast<size_t>(regionRandom.nextInt(static_cast<int>(plainRegions.size())));
+                expect(regionList.remove(plainRegions[index].id), "remove failed.");
+                plainRegions.erase(plainRegions.begin() + static_cast<std::ptrdiff_t>(index));
+            }
+            else if (operation < 6)
+            {
+                auto start = regionRandom.nextInt(100000);
+                auto removedEnd = start + (regionRandom.nextInt(4) == 0 ? 0 : regionRandom.nextInt(8000));
+                auto numInserted = regionRandom.nextInt(2) == 0 ? 0 : regionRandom.nextInt(8000);
+                auto delta = numInserted - (removedEnd - start);
+                regionList.update(start, removedEnd - start, numInserted);
+                for (auto& region : plainRegions)
+                {
+                    auto newStart = region.range.getStart() < start ? region.range.getStart()
+                                  : (region.range.getStart() >= removedEnd ? region.range.getStart() + delta : start);
+                    auto newEnd = region.range.getEnd() <= start ? region.range.getEnd()
+                                : (region.range.getEnd() >= removedEnd ? region.range.getEnd() + delta : start);
+                    region.range = {newStart, region.isMarker() ? newStart : jmax(newStart, newEnd)};
+                }
+            }
+            else
+            {
+                auto start = regionRandom.nextInt(110000) - 5000;
+                auto end = start + regionRandom.nextInt(20000);
+                auto found = regionList.getOverlapping({start, end});
+                int numExpected = 0;
+                for (auto& region : plainRegions)
+                {
+                    if (!overlaps(region, start, end))
+                        continue;
+                    numExpected++;
+                    auto match = std::find_if(found.begin(), found.end(), [&region](const Region& other) { return other.id == region.id; });
+                    expect(match != found.end() && match->range == region.range, "overlap query failed.");
+                }
+                expectEquals(static_cast<int>(found.size()), numExpected, "overlap query found too many.");
+            }
+        }
+        expectEquals(regionList.size(), static_cast<int>(plainRegions.size()), "wrong region count.");
+        for (auto& region : plainRegions)
+            expect(regionList.get(region.id).range == region.range, "region moved wrongly.");
+
+        ////////// Regions survive the wave cue chunks
+        StringPairArray cueMetadata;
+        regionList.addToWavMetadata(cueMetadata);
+        RegionList loadedRegions;
+        loadedRegions.loadFromWavMetadata(cueMetadata);
+        auto savedRegions = regionList.getAll();
+        auto restoredRegions = loadedRegions.getAll();
+        expectEquals(static_cast<int>(restoredRegions.size()), static_cast<int>(savedRegions.size()), "regions lost.");
+        for (size_t i=0; i<jmin(savedRegions.size(), restoredRegions.size()); i++)
+            expect(restoredRegions[i].range == savedRegions[i].range && restoredRegions[i].name == savedRegions[i].name, "region changed.");
+
+        beginTest ("RegionUndoTest");
+
+        ////////// Deleting audio that holds a region collapses it, undo gives it back its range
+        AudioBuffer<float> regionDocument (1, 1000);
+        regionDocument.clear();
+        RegionList editedRegions;
+        auto cutRegion = editedRegions.add("cut", {100, 200});
+        auto laterRegion = editedRegions.add("later", {300, 400});
+        UndoStack regionUndoStack (5);
+
+        // what AudioProcessingComponent does for a delete
+        AudioBuffer<float> deletedAudio (1, 200);
+        deletedAudio.copyFrom(0, 0, regionDocument, 0, 50, 200);
+        auto regionsBefore = editedRegions.getReshapedBy(50, 200);
+        AudioBufferUtils<float>::deleteRegion(regionDocument, 50, 200);
+        editedRegions.update(50, 200, 0);
+        UndoRecord deleteRecord (deletedAudio, AudioBuffer<float>(1, 0), 0, 50);
+        deleteRecord.setRegions(regionsBefore, editedRegions.getCurrent(regionsBefore));
+        regionUndoStack.addRecord(std::move(deleteRecord));
+        expect(editedRegions.get(cutRegion).range == Range<int>(50, 50), "the deleted region didn't collapse.");
+        expect(editedRegions.get(laterRegion).range == Range<int>(100, 200), "the region after the delete didn't move.");
+
+        // and for undo and redo, with the new document made first as the edit queue does
+        auto undoRegions = [&](bool isUndo) {
+            int changedStart, changedLength;
+            double changedSampleRate = 0.0;
+            std::vector<Region> reshapedRegions;
+            AudioBuffer<float> preparedDocument;
+            auto oldLength = regionDocument.getNumSamples();
+            if (isUndo)
+            {
+                expect(regionUndoStack.prepareUndo(regionDocument, preparedDocument), "undo of a delete wasn't prepared.");
+                expectEquals(regionDocument.getNumSamples(), oldLength, "prepareUndo changed the document.");
+                regionUndoStack.undo(regionDocument, changedStart, changedLength, changedSampleRate, reshapedRegions, &preparedDocument);
+            }
+            else
+            {
+                expect(regionUndoStack.prepareRedo(regionDocument, preparedDocument), "redo of a delete wasn't prepared.");
+                regionUndoStack.redo(regionDocument, changedStart, changedLength, changedSampleRate, reshapedRegions, &preparedDocument);
+            }
+            editedRegions.update(changedStart, oldLength - regionDocument.getNumSamples() + changedLength, changedLength);
+            editedRegions.restore(reshapedRegions);
+        };
+        undoRegions(true);
+        expectEquals(regionDocument.getNumSamples(), 1000, "undo didn't restore the audio.");
+        expect(editedRegions.get(cutRegion).range == Range<int>(100, 200), "undo didn't restore the deleted region.");
+        expect(editedRegions.get(laterRegion).range == Range<int>(300, 400), "undo didn't move the later region back.");
+        undoRegions(false);
+        expect(editedRegions.get(cutRegion).range == Range<int>(50, 50), "redo didn't collapse the region again.");
+        expect(editedRegions.get(laterRegion).range == Range<int>(100, 200), "redo didn't move the later region.");
+
+        beginTest ("UndoRecordPartsTest");
+
+        ////////// A record with several parts is undone and redone as one step,
+        ////////// the second part overlaps the first and is applied after it
+        AudioBuffer<float> document {2, 1000};
+        for (int channel=0; channel<2; channel++)
+            for (int i=0; i<document.getNumSamples(); i++)
+                document.setSample(channel, i, std::sin(0.02f * i * (channel+1)));
+        AudioBuffer<float> originalDocument (document);
+        UndoRecord batchRecord;
+        std::vector<std::pair<Range<int>, float>> partGains {{{100, 200}, 0.5f}, {{600, 700}, 0.f}, {{150, 250}, -1.f}};
+        for (auto& partGain : partGains)
+        {
+            auto range = partGain.first;
+            AudioBuffer<float> before {2, range.getLength()};
+            AudioBuffer<float> after {2, range.getLength()};
+            for (int channel=0; channel<2; channel++)
+            {
+                before.copyFrom(channel, 0, document, channel, range.getStart(), range.getLength());
+                document.applyGain(channel, range.getStart(), range.getLength(), partGain.second);
+                after.copyFrom(channel, 0, document, channel, range.getStart(), range.getLength());
+            }
+            batchRecord.addPart(UndoRecord::Part(before, after, range.getStart()));
+        }
+        AudioBuffer<float> editedDocument (document);
+        UndoStack batchUndoStack;
+        batchUndoStack.addRecord(std::move(batchRecord));
+
+        int changedStart, changedLength;
+        batchUndoStack.undo(document, changedStart, changedLength);
+        expectEquals(changedStart, 100, "wrong start of the undone span.");
+        expectEquals(changedLength, 600, "wrong length of the undone span.");
+        for (int channel=0; channel<2; channel++)
+            for (int i=0; i<document.getNumSamples(); i++)
+                expectEquals(document.getSample(channel, i), originalDocument.getSample(channel, i), "undo of the parts failed.");
+
+        batchUndoStack.redo(document, changedStart, changedLength);
+        for (int channel=0; channel<2; channel++)
+            for (int i=0; i<document.getNumSamples(); i++)
+                expectEquals(document.getSample(channel, i), editedDocument.getSample(channel, i), "redo of the parts failed.");
+
+        beginTest ("BufferChangeTest");
+
+        struct ChangeRecorder : public BufferChangeBroadcaster::Listener
+        {
+            void bufferChanged(const BufferChange& change) override
+            {
+                changes.push_back(change);
+            }
+            std::vector<BufferChange> changes;
+        };
+        ChangeRecorder changeRecorder;
+        BufferChangeBroadcaster bufferChangeBroadcaster;
+        bufferChangeBroadcaster.addListener(&changeRecorder);
+
+        ////////// In-place edits before the dispatch are merged into one change
+        bufferChangeBroadcaster.addChange(100, 50, 50, 1000);
+        bufferChangeBroadcaster.addChange(400, 10, 10, 1000);
+        bufferChangeBroadcaster.dispatchPendingChange();
+        expectEquals(static_cast<int>(changeRecorder.changes.size()), 1, "edits were not merged.");
+        expect(changeRecorder.changes.back().range == Range<int>(100, 410), "wrong merged range.");
+        expect(!changeRecorder.changes.back().lengthChanged, "in-place edits changed the length.");
+        expectEquals(static_cast<int>(changeRecorder.changes.back().version), 2, "wrong version.");
+        expectEquals(changeRecorder.changes.back().numEdits, 2, "wrong number of edits.");
+
+        ////////// A length change reaches the end, and is clipped when a later edit shortens the buffer
+        bufferChangeBroadcaster.addChange(500, 100, 0, 900);
+        bufferChangeBroadcaster.dispatchPendingChange();
+        expect(changeRecorder.changes.back().range == Range<int>(500, 900), "a length change didn't reach the end.");
+        expect(changeRecorder.changes.back().lengthChanged, "the length change was lost.");
+        bufferChangeBroadcaster.addChange(850, 10, 10, 900);
+        bufferChangeBroadcaster.addChange(0, 500, 0, 400);
+        bufferChangeBroadcaster.dispatchPendingChange();
+        expect(changeRecorder.changes.back().range == Range<int>(0, 400), "the range was not clipped to the buffer.");
+        expectEquals(static_cast<int>(changeRecorder.changes.back().version), 5, "wrong version.");
+
+        ////////// Nothing is sent without edits
+        bufferChangeBroadcaster.dispatchPendingChange();
+        expectEquals(static_cast<int>(changeRecorder.changes.size()), 3, "a change was sent without edits.");
+        bufferChangeBroadcaster.removeListener(&changeRecorder);
+
+        beginTest ("EditCommandQueueTest");
+
+        AudioBuffer<float> editedBuffer (1, 1000);
+        editedBuffer.clear();
+        EditCommandQueue editQueue;
+        // prepares the edited buffer with func applied to every sample
+        auto makeCommand = [&editedBuffer](const std::function<float(float)>& func) {
+            auto result = std::make_shared<AudioBuffer<float>>();
+            return EditCommand{"Edit", [&editedBuffer, result, func](EditProgress& progress) {
+                result->makeCopyOf(editedBuffer);
+                for (int i=0; i<result->getNumSamples(); i++)
+                    result->setSample(0, i, func(result->getSample(0, i)));
+                return progress.setProgress(1.0);
+            }, [&editedBuffer, result] {
+                editedBuffer.makeCopyOf(*result);
+            }};
+        };
+
+        ////////// Commands are prepared on the worker and applied in order
+        editQueue.submit(makeCommand([](float x) { return x + 1.0f; }));
+        editQueue.submit(makeCommand([](float x) { return x * 2.0f; }));
+        editQueue.submit(makeCommand([](float x) { return x + 1.0f; }));
+        expect(editQueue.waitUntilIdle(10000), "the queue didn't finish.");
+        for (int i=0; i<editedBuffer.getNumSamples(); i++)
+            expectEquals(editedBuffer.getSample(0, i), 3.0f, "the commands were not applied in order.");
+
+        ////////// Cancelling while preparing leaves the buffer unchanged and drops the queued commands
+        WaitableEvent prepareStarted;
+        bool cancelledApplied = false;
+        editQueue.submit({"Slow", [&prepareStarted](EditProgress& progress) {
+            prepareStarted.signal();
+            while (progress.setProgress(0.5))
+                Thread::sleep(1);
+            return false;
+        }, [&cancelledApplied] { cancelledApplied = true; }});
+        editQueue.submit(makeCommand([](float) { return 0.0f; }));
+        expect(prepareStarted.wait(10000), "the command was not prepared.");
+        expectEquals(editQueue.getNumQueued(), 1, "the second command was not queued.");
+        editQueue.cancelAll();
+        expect(editQueue.waitUntilIdle(10000), "the queue didn't stop after cancelling.");
+        expect(!cancelledApplied, "a cancelled command was applied.");
+        for (int i=0; i<editedBuffer.getNumSamples(); i++)
+            expectEquals(editedBuffer.getSample(0, i), 3.0f, "cancelling changed the buffer.");
+
+        ////////// A command without prepare is applied straight away when the queue is idle
+        bool applied = false;
+        editQueue.submit({"Apply", nullptr, [&applied] { applied = true; }});
+        expect(applied, "the command was not applied straight away.");
+        expect(editQueue.isIdle(), "the queue is not idle.");
     }
 };
 
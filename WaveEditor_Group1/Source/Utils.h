@@ -54,6 +54,82 @@ public:
         insertRegion(audioBuffer, replaceBuffer, startSample);
     }
 
+    /*! Deletes several regions at once, sorted and not overlapping. Every kept
+    \   sample moves once, so the tail after the last region is only shifted
+    \   once instead of once per region.
+    */
+    static void deleteRegions (AudioBuffer<Type>& audioBuffer, const std::vector<Range<int>>& regions)
+    {
+        if (regions.empty())
+            return;
+
+        int oldLength = audioBuffer.getNumSamples();
+        int numDeleted = 0;
+        for (auto& region : regions)
+            numDeleted += region.getLength();
+
+        for (int channel=0; channel<audioBuffer.getNumChannels(); channel++)
+        {
+            auto writePointer = audioBuffer.getWritePointer(channel);
+            auto writePos = regions.front().getStart();
+            for (size_t i=0; i<regions.size(); i++)
+            {
+                auto keptStart = regions[i].getEnd();
+                auto keptEnd = i+1 < regions.size() ? regions[i+1].getStart() : oldLength;
+                std::memmove(writePointer + writePos, writePointer + keptStart, static_cast<size_t>(keptEnd - keptStart) * sizeof(Type));
+                writePos += keptEnd - keptStart;
+            }
+        }
+        audioBuffer.setSize(audioBuffer.getNumChannels(), oldLength-numDeleted, true);
+    }
+
+    /*! Fills dest with audioBuffer where replaceLength samples from startSample
+    \   are replaced by replaceBuffer. audioBuffer is only read, so the new
+    \   document can be made on another thread and moved in afterwards.
+    */
+    static void copyWithRegionReplaced (const AudioBuffer<Type>& audioBuffer, const AudioBuffer<Type>& replaceBuffer, int startSample, int replaceLength, AudioBuffer<Type>& dest)
+    {
+        int oldLength = audioBuffer.getNumSamples();
+        int insertLength = replaceBuffer.getNumSamples();
+        int tailLength = oldLength - startSample - replaceLength;
+        dest.setSize(audioBuffer.getNumChannels(), oldLength - replaceLength + insertLength);
+        for (int channel=0; channel<audioBuffer.getNumChannels(); channel++)
+        {
+            auto writePointer = dest.getWritePointer(channel);
+            auto readPointer = audioBuffer.getReadPointer(channel);
+            FloatVectorOperations::copy(writePointer, readPointer, startSample);
+            if (insertLength > 0)
+                FloatVectorOperations::copy(writePointer + startSample, replaceBuffer.getReadPointer(channel), insertLength);
+            FloatVectorOperations::copy(writePointer + startSample + insertLength, readPointer + startSample + replaceLength, tailLength);
+        }
+    }
+
+    /*! Like deleteRegions, but fills dest and leaves audioBuffer as it is
+    */
+    static void copyWithRegionsDeleted (const AudioBuffer<Type>& audioBuffer, const std::vector<Range<int>>& regions, AudioBuffer<Type>& dest)
+    {
+        int oldLength = audioBuffer.getNumSamples();
+        int numDeleted = 0;
+        for (auto& region : regions)
+            numDeleted += region.getLength();
+
+        dest.setSize(audioBuffer.getNumChannels(), oldLength - numDeleted);
+        for (int channel=0; channel<audioBuffer.getNumChannels(); channel++)
+        {
+            auto writePointer = dest.getWritePointer(channel);
+            auto readPointer = audioBuffer.getReadPointer(channel);
+            int keptStart = 0;
+            for (size_t i=0; i<=regions.size(); i++)
+            {
+                auto keptEnd = i < regions.size() ? regions[i].getStart() : oldLength;
+                FloatVectorOperations::copy(writePointer, readPointer + keptStart, keptEnd - keptStart);
+                writePointer += keptEnd - keptStart;
+                if (i < regions.size())
+                    keptStart = regions[i].getEnd();
+            }
+        }
+    }
+
 private:
     AudioBufferUtils(){};
     ~AudioBufferUtils(){};
@@ -104,8 +180,17 @@ public:
                 maxValue = currentAbsValue;
         }
 
-        for (int i=0; i<numSamples; i++)
-            bufferWritePointer[startSample+i] /= maxValue;
+        normalize(bufferWritePointer, startSample, numSamples, maxValue);
+    }
+
+    /*! Normalizes with an already known peak value, e.g. from the LevelIndex
+    */
+    static void normalize (float* bufferWritePointer, int startSample, int numSamples, float peakValue)
+    {
+        if (peakValue <= 0)
+            return;
+
+        gain(bufferWritePointer, startSample, numSamples, 1.f / peakValue);
     }
 private:
     AudioProcessingUtils(){};
@@ -18,19 +18,26 @@
 /*
 */
 class WaveVisualizer    : public Component,
-                          public ChangeListener,
+                          public BufferChangeBroadcaster::Listener,
                           private Timer
 {
 public:
+    enum
+    {
+        samplesPerThumbnailPoint = 512
+    };
+
     WaveVisualizer(AudioProcessingComponent& c):
     apc(c),
     thumbnailCache (5),
-    thumbnail (512, formatManager, thumbnailCache),
+    thumbnail (samplesPerThumbnailPoint, formatManager, thumbnailCache),
     thumbnailBounds(0, 0, 0, 0),
-    timelineBounds(0, 0, 0, 0)
+    timelineBounds(0, 0, 0, 0),
+    thumbnailSampleRate(0.0),
+    thumbnailNumChannels(0)
     {
         state = apc.getState(); //initialize transport source state
-        apc.audioBufferChanged.addChangeListener(this);
+        apc.audioBufferChanged.addListener(this);
         startTimerHz (60); // refresh the visualizer 30 times per second
                 
         
@@ -41,6 +48,7 @@ public:
 
     ~WaveVisualizer()
     {
+        apc.audioBufferChanged.removeListener(this);
 //        setLookAndFeel (nullptr);
     }
 
@@ -68,11 +76,27 @@ public:
         waveSelection->parentDimensions(getWidth(), getHeight());
     }
 
-    void changeListenerCallback (ChangeBroadcaster* source) override
+    /*! Redoes the thumbnail points under the changed samples, or the whole
+    \   thumbnail when the length, rate or channels changed
+    */
+    void bufferChanged (const BufferChange& change) override
     {
         auto audioBuffer = apc.getAudioBuffer();
-        thumbnail.reset(apc.getNumChannels(), apc.getSampleRate(), audioBuffer->getNumSamples());
-        thumbnail.addBlock(0, *audioBuffer, 0, audioBuffer->getNumSamples());
+        auto numSamples = audioBuffer->getNumSamples();
+        if (change.lengthChanged || apc.getSampleRate() != thumbnailSampleRate || apc.getNumChannels() != thumbnailNumChannels)
+        {
+            thumbnailSampleRate = apc.getSampleRate();
+            thumbnailNumChannels = apc.getNumChannels();
+            thumbnail.reset(thumbnailNumChannels, thumbnailSampleRate, numSamples);
+            thumbnail.addBlock(0, *audioBuffer, 0, numSamples);
+        }
+        else if (!change.range.isEmpty())
+        {
+            // a point covers samplesPerThumbnailPoint samples, so whole points are redone
+            auto start = change.range.getStart() / samplesPerThumbnailPoint * samplesPerThumbnailPoint;
+            auto end = jmin(numSamples, (change.range.getEnd() + samplesPerThumbnailPoint - 1) / samplesPerThumbnailPoint * samplesPerThumbnailPoint);
+            thumbnail.addBlock(start, *audioBuffer, start, end - start);
+        }
         repaint();
     }
 
@@ -110,6 +134,12 @@ public:
                                 0.0,                                    // start time
                                 thumbnail.getTotalLength(),             // end time
                                 1.0f);                                  // vertical zoom
+
+        //-----------------------------------onsets-----------------------------------------
+        paintOnsets (g);
+
+        //---------------------------------regions------------------------------------------
+        paintRegions (g);
         
         //-------------------------------play marker----------------------------------------
         g.setColour (Colour(128,255,0));
@@ -121,6 +151,69 @@ public:
                     thumbnailBounds.getBottom(), 2.0f);
     }
     
+    /*! One line per onset, at most one per pixel column
+    */
+    void paintOnsets (Graphics& g)
+    {
+        auto numSamples = apc.getNumSamples();
+        if (numSamples <= 0 || thumbnailBounds.getWidth() <= 0)
+            return;
+
+        g.setColour (Colours::orange.withAlpha (0.5f));
+        auto lastX = -1;
+        for (auto onset : apc.getOnsets (0, numSamples))
+        {
+            auto x = thumbnailBounds.getX() + static_cast<int>(static_cast<int64>(onset) * thumbnailBounds.getWidth() / numSamples);
+            if (x == lastX)
+                continue;
+            g.drawVerticalLine (x, static_cast<float>(thumbnailBounds.getY()), static_cast<float>(thumbnailBounds.getBottom()));
+            lastX = x;
+        }
+    }
+
+    /*! Regions as shaded spans with their name, markers as lines. Names
+    \   are left out where they would overlap the previous one.
+    */
+    void paintRegions (Graphics& g)
+    {
+        auto numSamples = apc.getNumSamples();
+        if (numSamples <= 0 || thumbnailBounds.getWidth() <= 0)
+            return;
+
+        auto toX = [this, numSamples](int position) {
+            return thumbnailBounds.getX() + static_cast<int>(static_cast<int64>(position) * thumbnailBounds.getWidth() / numSamples);
+        };
+        g.setFont (11.0f);
+        auto lastMarkerX = -1;
+        auto nameEnd = -1;
+        for (auto& region : apc.getRegionList().getOverlapping ({0, numSamples + 1}))
+        {
+            auto x = toX (region.range.getStart());
+            if (region.isMarker())
+            {
+                if (x == lastMarkerX)
+                    continue;
+                g.setColour (Colours::yellow.withAlpha (0.8f));
+                g.drawVerticalLine (x, static_cast<float>(thumbnailBounds.getY()), static_cast<float>(thumbnailBounds.getBottom()));
+                lastMarkerX = x;
+            }
+            else
+            {
+                auto width = jmax (1, toX (region.range.getEnd()) - x);
+                g.setColour (Colours::yellow.withAlpha (0.12f));
+                g.fillRect (x, thumbnailBounds.getY(), width, thumbnailBounds.getHeight());
+            }
+
+            if (x >= nameEnd)
+            {
+                auto nameWidth = jmin (120, g.getCurrentFont().getStringWidth (region.name) + 4);
+                g.setColour (Colours::yellow);
+                g.drawText (region.name, x + 2, thumbnailBounds.getY(), nameWidth, 14, Justification::centredLeft, true);
+                nameEnd = x + nameWidth + 2;
+            }
+        }
+    }
+
     void setWidth(float waveVisualizerWidth)
     {
         waveWidth = waveVisualizerWidth;
@@ -158,6 +251,8 @@ private:
     Rectangle<int> thumbnailBounds;
     Rectangle<int> timelineBounds;
     AudioProcessingComponent::TransportState state;
+    double thumbnailSampleRate;
+    int thumbnailNumChannels;
 
     
     Slider timelineSlider;
@@ -170,10 +265,12 @@ private:
 //-----------------------------------------------------------------------------------------------
 
 class TrackVisualizer: public Component,
-                       public Slider::Listener
+                       public Slider::Listener,
+                       private Timer
 {
 public:
     TrackVisualizer (AudioProcessingComponent &c):
+    apc(c),
     waveVis(c),
     waveVisualizerWidthRatio(1.f),
     waveVisualizerWidth(0),
@@ -183,8 +280,13 @@ public:
         incDecSlider.setRange(0.1, 10.0, 0.1);
         incDecSlider.setValue(1.0);
         
+        selectionLevelsLabel.setFont(Font(12.0f));
+        selectionLevelsLabel.setJustificationType(Justification::centredLeft);
+
         addAndMakeVisible(incDecSlider);
         addAndMakeVisible(trackViewport);
+        addAndMakeVisible(selectionLevelsLabel);
+        startTimerHz (10); // the level index answers in O(log n), so polling is cheap
     }
     ~TrackVisualizer()
     {
@@ -207,10 +309,28 @@ public:
         trackViewport.setViewedComponent(&waveVis);
         trackViewport.setBounds(0, 50, getWidth(), getHeight()-50);
         incDecSlider.setBounds(getWidth()-100, 0, 100, 50);
+        selectionLevelsLabel.setBounds(5, 0, getWidth()-110, 50);
 
         waveVis.repaint();
     }
 
+    /*! Shows peak, RMS and DC of the marked region (the whole file if nothing is selected)
+    */
+    void timerCallback() override
+    {
+        if (apc.getNumChannels() == 0)
+        {
+            selectionLevelsLabel.setText("", dontSendNotification);
+            return;
+        }
+
+        auto levels = apc.getMarkedRegionLevels();
+        auto text = "Peak " + String(Decibels::gainToDecibels(levels.peak), 1) + " dBFS"
+                  + "   RMS " + String(Decibels::gainToDecibels(levels.getRMS()), 1) + " dBFS"
+                  + "   DC " + String(levels.getDC(), 4);
+        selectionLevelsLabel.setText(text, dontSendNotification);
+    }
+
     void sliderValueChanged(Slider* slider) override
     {
         waveVis.setWidth(incDecSlider.getValue() * waveVisualizerWidth);
@@ -225,8 +345,10 @@ public:
 
     
 private:
+    AudioProcessingComponent& apc;
     Viewport trackViewport;
     WaveVisualizer waveVis;
+    Label selectionLevelsLabel;
     Slider incDecSlider { Slider::IncDecButtons, Slider::TextBoxBelow };
 
     float waveVisualizerWidthRatio;
@@ -0,0 +1,304 @@
+/*
+  ==============================================================================
+
+    ZeroCrossingIndex.h
+    Created: 19 Oct 2026 7:40:09am
+    Author:  user
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*! Per channel positions where the signal changes sign, built by a background
+\   thread. The positions are stored per chunk of samplesPerChunk samples as
+\   16 bit offsets from the chunk start, so the index takes 2 bytes per
+\   crossing and a query is a chunk lookup plus a binary search.
+\   Chunks the thread hasn't reached yet are answered from the samples, so
+\   queries are exact while the index is being built.
+\
+\   The thread reads the audio buffer, so stopBuilding() must be called
+\   before the buffer is changed and update() after.
+*/
+class ZeroCrossingIndex : private Thread
+{
+public:
+    enum
+    {
+        samplesPerChunk = 1 << 16
+    };
+
+    ZeroCrossingIndex():
+    Thread("Zero Crossing Index"),
+    source(nullptr)
+    {
+    }
+
+    ~ZeroCrossingIndex()
+    {
+        stopBuilding();
+    }
+
+    /*! Throws the index away and builds it again in the background
+    */
+    void rebuild(const AudioBuffer<float>& audioBuffer)
+    {
+        stopBuilding();
+        source = &audioBuffer;
+        channels.clear();
+        resize();
+        startThread(3);
+    }
+
+    /*! Called after numRemoved samples starting at startSample have been
+    \   replaced by numInserted samples, rebuilds the chunks that changed in the
+    \   background. Chunks after an edit that changed the length have moved, so
+    \   they are rebuilt too.
+    */
+    void update(int startSample, int numRemoved, int numInserted)
+    {
+        stopBuilding();
+        if (source == nullptr)
+            return;
+        if (static_cast<int>(channels.size()) != source->getNumChannels())
+        {
+            rebuild(*source);
+            return;
+        }
+
+        resize();
+        if (numRemoved == numInserted)
+            invalidate(startSample, startSample + numInserted);
+        else
+            invalidate(startSample, source->getNumSamples());
+        startThread(3);
+    }
+
+    /*! Like update() for in-place edits of several ranges, with one restart
+    \   of the background pass
+    */
+    void update(const std::vector<Range<int>>& changedRanges)
+    {
+        stopBuilding();
+        if (source == nullptr)
+            return;
+        if (static_cast<int>(channels.size()) != source->getNumChannels())
+        {
+            rebuild(*source);
+            return;
+        }
+
+        for (auto& range : changedRanges)
+            invalidate(range.getStart(), range.getEnd());
+        startThread(3);
+    }
+
+    /*! Call before the audio buffer is changed
+    */
+    void stopBuilding()
+    {
+        stopThread(2000);
+    }
+
+    /*! Waits for the background pass, returns true if the whole index is built
+    */
+    bool waitUntilBuilt(int timeOutMilliseconds)
+    {
+        return waitForThreadToExit(timeOutMilliseconds);
+    }
+
+    /*! The zero crossing of a channel nearest to position and at most
+    \   maxDistance samples away, -1 if there is none. Of the two samples
+    \   around a sign change the one closer to zero is returned.
+    */
+    int getNearest(int channel, int position, int maxDistance) const
+    {
+        if (source == nullptr || channel >= static_cast<int>(channels.size()))
+            return -1;
+
+        auto& chunks = channels[static_cast<size_t>(channel)];
+        auto numSamples = source->getNumSamples();
+        auto first = jmax(1, position - maxDistance);
+        auto last = jmin(numSamples - 1, position + maxDistance);
+        if (first > last)
+            return -1;
+
+        // the crossing after the position, then the one before it
+        auto after = -1;
+        for (int chunk=position / samplesPerChunk; after < 0 && chunk <= last / samplesPerChunk; chunk++)
+            after = findInChunk(chunks, channel, chunk, jmax(first, position), last, true);
+        auto before = -1;
+        for (int chunk=jmin(position, last) / samplesPerChunk; before < 0 && chunk >= first / samplesPerChunk; chunk--)
+            before = findInChunk(chunks, channel, chunk, first, jmin(position, last), false);
+
+        auto nearest = after;
+        if (before >= 0 && (after < 0 || position - before <= after - position))
+            nearest = before;
+        if (nearest < 0)
+            return -1;
+
+        auto samples = source->getReadPointer(channel);
+        return std::abs(samples[nearest - 1]) < std::abs(samples[nearest]) ? nearest - 1 : nearest;
+    }
+
+    /*! Every channel proposes its nearest crossing, the proposal where the
+    \   channels together are closest to zero wins. Returns position when no
+    \   channel has a crossing in range.
+    */
+    int snap(int position, int maxDistance) const
+    {
+        auto best = position;
+        auto bestSum = std::numeric_limits<float>::max();
+        for (int channel=0; channel<static_cast<int>(channels.size()); channel++)
+        {
+            auto candidate = getNearest(channel, position, maxDistance);
+            if (candidate < 0)
+                continue;
+            float sum = 0.f;
+            for (int other=0; other<source->getNumChannels(); other++)
+                sum += std::abs(source->getSample(other, candidate));
+            if (sum < bestSum || (sum == bestSum && std::abs(candidate - position) < std::abs(best - position)))
+            {
+                best = candidate;
+                bestSum = sum;
+            }
+        }
+        return best;
+    }
+
+    /*! Bytes used by the stored positions
+    */
+    size_t getMemoryUsage() const
+    {
+        size_t bytes = 0;
+        for (auto& chunks : channels)
+            for (auto& chunk : chunks)
+                bytes += chunk.offsets.capacity() * sizeof(uint16);
+        return bytes;
+    }
+
+private:
+    struct Chunk
+    {
+        Chunk(){}
+        Chunk(const Chunk& other):
+        offsets(other.offsets),
+        ready(other.ready.load())
+        {
+        }
+
+        std::vector<uint16> offsets;    // sample after each sign change, from the chunk start
+        std::atomic<bool> ready {false};
+    };
+
+    int getNumChunks() const
+    {
+        return (source->getNumSamples() + samplesPerChunk - 1) / samplesPerChunk;
+    }
+
+    void resize()
+    {
+        channels.resize(static_cast<size_t>(source->getNumChannels()));
+        for (auto& chunks : channels)
+            chunks.resize(static_cast<size_t>(getNumChunks()));
+    }
+
+    /*! Marks the chunks that depend on the samples in [startSample, endSample)
+    */
+    void invalidate(int startSample, int endSample)
+    {
+        auto numChunks = getNumChunks();
+        // a crossing belongs to the sample after it, so the chunk after the edit depends on it too
+        auto startChunk = jlimit(0, numChunks, startSample / samplesPerChunk);
+        auto endChunk = jlimit(startChunk, numChunks, endSample / samplesPerChunk + 1);
+        for (auto& chunks : channels)
+            for (int chunk=startChunk; chunk<endChunk; chunk++)
+                chunks[static_cast<size_t>(chunk)].ready.store(false);
+    }
+
+    static bool crosses(const float* samples, int i)
+    {
+        return (samples[i - 1] < 0.f) != (samples[i] < 0.f);
+    }
+
+    /*! The first (or last) sign change in [first, last] of one chunk, -1 if
+    \   there is none
+    */
+    int findInChunk(const std::vector<Chunk>& chunks, int channel, int chunk, int first, int last, bool forwards) const
+    {
+        auto chunkStart = chunk * samplesPerChunk;
+        first = jmax(first, chunkStart);
+        last = jmin(last, chunkStart + samplesPerChunk - 1);
+        if (first > last)
+            return -1;
+
+        auto& entry = chunks[static_cast<size_t>(chunk)];
+        if (!entry.ready.load(std::memory_order_acquire))
+        {
+            auto samples = source->getReadPointer(channel);
+            if (forwards)
+            {
+                for (int i=first; i<=last; i++)
+                    if (crosses(samples, i))
+                        return i;
+            }
+            else
+            {
+                for (int i=last; i>=first; i--)
+                    if (crosses(samples, i))
+                        return i;
+            }
+            return -1;
+        }
+
+        auto& offsets = entry.offsets;
+        if (forwards)
+        {
+            auto found = std::lower_bound(offsets.begin(), offsets.end(), static_cast<uint16>(first - chunkStart));
+            if (found != offsets.end() && chunkStart + *found <= last)
+                return chunkStart + *found;
+        }
+        else
+        {
+            auto found = std::upper_bound(offsets.begin(), offsets.end(), static_cast<uint16>(last - chunkStart));
+            if (found != offsets.begin() && chunkStart + *(found - 1) >= first)
+                return chunkStart + *(found - 1);
+        }
+        return -1;
+    }
+
+    void buildChunk(int channel, Chunk& chunk, int chunkIndex)
+    {
+        auto samples = source->getReadPointer(channel);
+        auto chunkStart = chunkIndex * samplesPerChunk;
+        auto chunkEnd = jmin(source->getNumSamples(), chunkStart + samplesPerChunk);
+        chunk.offsets.clear();
+        for (int i=jmax(1, chunkStart); i<chunkEnd; i++)
+            if (crosses(samples, i))
+                chunk.offsets.push_back(static_cast<uint16>(i - chunkStart));
+        chunk.offsets.shrink_to_fit();
+        chunk.ready.store(true, std::memory_order_release);
+    }
+
+    void run() override
+    {
+        for (int channel=0; channel<static_cast<int>(channels.size()); channel++)
+        {
+            auto& chunks = channels[static_cast<size_t>(channel)];
+            for (int chunk=0; chunk<static_cast<int>(chunks.size()); chunk++)
+            {
+                if (threadShouldExit())
+                    return;
+                if (!chunks[static_cast<size_t>(chunk)].ready.load())
+                    buildChunk(channel, chunks[static_cast<size_t>(chunk)], chunk);
+            }
+        }
+    }
+
+    const AudioBuffer<float>* source;
+    std::vector<std::vector<Chunk>> channels;
+
+    JUCE_DECLARE_NON_COPYABLE (ZeroCrossingIndex)
+};